@@ -35,12 +35,16 @@ SOURCES += \
     editor/pages/propspage.cpp \
     main.cpp \
     core/appstate.cpp \
+    core/utilities/bufferedwriter.cpp \
     core/utilities/fileparse.cpp \
+    core/utilities/lexer.cpp \
     core/utilities/misc.cpp \
     core/utilities/progress.cpp \
     core/config/configuration.cpp \
     core/config/settings.cpp \
     core/config/propfile.cpp \
+    core/config/propcache.cpp \
+    core/config/styletree.cpp \
     editor/pages/generalpage.cpp \
     editor/pages/presetspage.cpp \
     editor/pages/bladespage.cpp \
@@ -51,9 +55,20 @@ SOURCES += \
     onboard/pages/overviewpage.cpp \
     onboard/pages/welcomepage.cpp \
     tools/arduino.cpp \
+    tools/batchverify.cpp \
+    tools/boardwatcher.cpp \
+    tools/buildcache.cpp \
+    tools/compileoutput.cpp \
+    tools/dfu.cpp \
+    tools/flashqueue.cpp \
+    tools/headless.cpp \
+    tools/presetsync.cpp \
+    tools/seriallog.cpp \
     tools/serialmonitor.cpp \
+    tools/serialparser.cpp \
     ui/pcchoice.cpp \
     ui/pccombobox.cpp \
+    ui/pclogview.cpp \
     ui/pcspinctrl.cpp \
     ui/pcspinctrldouble.cpp \
     ui/pctextctrl.cpp
@@ -61,12 +76,18 @@ SOURCES += \
 HEADERS += \
     core/appstate.h \
     core/defines.h \
+    core/config/configmodel.h \
     core/config/configuration.h \
     core/config/settings.h \
     core/config/propfile.h \
+    core/config/propcache.h \
+    core/config/styletree.h \
+    core/utilities/bufferedwriter.h \
     core/utilities/fileparse.h \
+    core/utilities/lexer.h \
     core/utilities/misc.h \
     core/utilities/progress.h \
+    core/utilities/ringbuffer.h \
     editor/dialogs/bladearraydlg.h \
     editor/dialogs/customoptionsdlg.h \
     editor/editorwindow.h \
@@ -78,9 +99,20 @@ HEADERS += \
     mainmenu/mainmenu.h \
     onboard/onboard.h \
     tools/arduino.h \
+    tools/batchverify.h \
+    tools/boardwatcher.h \
+    tools/buildcache.h \
+    tools/compileoutput.h \
+    tools/dfu.h \
+    tools/flashqueue.h \
+    tools/headless.h \
+    tools/presetsync.h \
+    tools/seriallog.h \
     tools/serialmonitor.h \
+    tools/serialparser.h \
     ui/pcchoice.h \
     ui/pccombobox.h \
+    ui/pclogview.h \
     ui/pcspinctrl.h \
     ui/pcspinctrldouble.h \
     ui/pctextctrl.h
@@ -12,9 +12,10 @@
 
 AppState* AppState::instance;
 AppState::AppState() {}
-void AppState::init() {
+void AppState::init(bool headless) {
   instance = new AppState();
   instance->loadStateFromFile();
+  if (headless) return;
 
   if (instance->firstRun) Onboard::instance = new Onboard();
   else MainMenu::instance = new MainMenu();
@@ -8,7 +8,8 @@
 
 class AppState {
 public:
-  static void init();
+  // Headless skips creating the first window (for --cli)
+  static void init(bool headless = false);
   static AppState* instance;
 
   void addConfig(const std::string&);
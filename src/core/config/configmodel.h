@@ -0,0 +1,128 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <wx/string.h>
+
+#define BD_PIXELRGB "WS281X (RGB)"
+#define BD_PIXELRGBW "WS281X (RGBW)"
+#define BD_TRISTAR "Tri-LED Star"
+#define BD_QUADSTAR "Quad-LED Star"
+#define BD_SINGLELED "Single Color"
+#define BD_NORESISTANCE "<None>"
+
+constexpr auto BLADE_ID_MODE_SNAPSHOT{"Snapshot"};
+constexpr auto BLADE_ID_MODE_EXTERNAL{"External Pullup"};
+constexpr auto BLADE_ID_MODE_BRIDGED {"Bridged Pullup"};
+
+// Everything that goes into a config file, as plain data.
+// The editor pages load from and save to this, while reading, checking and
+// writing configs only ever touch the model, so they also work headless.
+struct ConfigModel {
+  typedef std::pair<std::string, std::string> Define;
+
+  struct General {
+    int32_t board{0}; // Index into Configuration::Proffieboard
+    bool massStorage{false};
+    bool webUSB{false};
+
+    std::string orientation{"ORIENTATION_FETS_TOWARDS_BLADE"};
+    int32_t buttons{2};
+    int32_t volume{1500};
+    double clash{3};
+    int32_t pliTime{2};
+    int32_t idleTime{10};
+    int32_t motionTime{15};
+    int32_t maxLEDs{144};
+
+    bool volumeSave{false};
+    bool presetSave{false};
+    bool colorSave{false};
+    bool enableOLED{false};
+    bool disableColor{false};
+    bool noTalkie{false};
+    bool noBasicParsers{false};
+    bool disableDiagnosticCommands{false};
+  };
+
+  struct BladeAwareness {
+    bool enableDetect{false};
+    std::string detectPin{};
+
+    bool enableID{false};
+    std::string mode{BLADE_ID_MODE_SNAPSHOT};
+    std::string IDPin{};
+    int32_t pullupResistance{30000};
+    std::string pullupPin{};
+
+    bool enablePowerForID{false};
+    std::array<bool, 6> powerPins{};
+
+    bool continuousScans{false};
+    int32_t numIDTimes{10};
+    int32_t scanIDMillis{1000};
+  };
+
+  struct Preset {
+    std::vector<wxString> styles{};
+    wxString name{""};
+    wxString dirs{""};
+    wxString track{""};
+  };
+
+  struct Blade {
+    wxString type{BD_PIXELRGB};
+
+    wxString dataPin{"bladePin"};
+    wxString colorType{"GRB"};
+    int32_t numPixels{0};
+    bool useRGBWithWhite{false};
+
+    wxString Star1{BD_NORESISTANCE};
+    wxString Star2{BD_NORESISTANCE};
+    wxString Star3{BD_NORESISTANCE};
+    wxString Star4{BD_NORESISTANCE};
+    int32_t Star1Resistance{0};
+    int32_t Star2Resistance{0};
+    int32_t Star3Resistance{0};
+    int32_t Star4Resistance{0};
+
+    std::vector<std::string> powerPins;
+
+    bool isSubBlade{false};
+    bool useStride{false};
+    bool useZigZag{false};
+
+    struct subBladeInfo {
+      uint32_t startPixel{0};
+      uint32_t endPixel{0};
+    };
+    std::vector<subBladeInfo> subBlades{};
+  };
+
+  struct BladeArray {
+    wxString name{""};
+    int32_t value{0};
+
+    std::vector<Preset> presets{};
+    std::vector<Blade> blades{};
+  };
+
+  General general{};
+  BladeAwareness bladeAwareness{};
+
+  std::string propFile{}; // Empty for the default prop
+  // Prop settings as written to the config. Without the prop file loaded they
+  // can't be told apart from custom defines, so readConfig leaves them in
+  // customDefines and the props page claims them when it loads the model.
+  std::vector<Define> propDefines{};
+  std::vector<Define> customDefines{};
+
+  std::vector<BladeArray> bladeArrays{BladeArray{"blade_in", 0}};
+};
@@ -6,6 +6,8 @@
 #include "core/defines.h"
 #include "core/config/settings.h"
 #include "core/config/propfile.h"
+#include "core/config/styletree.h"
+#include "core/utilities/bufferedwriter.h"
 #include "core/utilities/misc.h"
 #include "editor/editorwindow.h"
 #include "editor/pages/generalpage.h"
@@ -14,8 +16,12 @@
 #include "editor/pages/bladespage.h"
 #include "editor/dialogs/bladearraydlg.h"
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_set>
 
 #include <wx/filedlg.h>
 #include <wx/event.h>
@@ -27,17 +33,19 @@
 
 
 bool Configuration::outputConfig(const std::string& filePath, EditorWindow* editor) {
-  editor->presetsPage->update();
-  editor->bladesPage->update();
-  editor->bladesPage->bladeArrayDlg->update();
+  editor->saveModel();
 
-  if (!runPreChecks(editor)) return false;
-
-  std::ofstream configOutput(filePath);
-  if (!configOutput.is_open()) {
-    ERR("Could not open config file for output.");
+  std::string error;
+  if (!outputConfig(filePath, editor->model, error)) {
+    ERR(error);
   }
+  return true;
+}
+bool Configuration::outputConfig(const std::string& filePath, const ConfigModel& config, std::string& error) {
+  if (!runPreChecks(config, error)) return false;
 
+  static thread_local BufferedWriter configOutput;
+  configOutput.clear();
   configOutput <<
       "/*\n"
       "This configuration file was generated by ProffieConfig " VERSION ", created by Ryryog25.\n"
@@ -45,12 +53,15 @@ bool Configuration::outputConfig(const std::string& filePath, EditorWindow* edit
       "ProffieConfig is an All-In-One utility for managing your Proffieboard.\n"
       "*/\n\n";
 
-  outputConfigTop(configOutput, editor);
-  outputConfigProp(configOutput, editor);
-  outputConfigPresets(configOutput, editor);
-  outputConfigButtons(configOutput, editor);
+  outputConfigTop(configOutput, config);
+  outputConfigProp(configOutput, config);
+  outputConfigPresets(configOutput, config);
+  outputConfigButtons(configOutput, config);
 
-  configOutput.close();
+  if (!configOutput.commit(filePath)) {
+    error = "Could not write config file.";
+    return false;
+  }
   return true;
 }
 bool Configuration::outputConfig(EditorWindow* editor) { return Configuration::outputConfig(CONFIG_DIR + editor->getOpenConfig() + ".h", editor); }
@@ -62,104 +73,98 @@ bool Configuration::exportConfig(EditorWindow* editor) {
   return Configuration::outputConfig(configLocation.GetPath().ToStdString(), editor);
 }
 
-void Configuration::outputConfigTop(std::ofstream& configOutput, EditorWindow* editor) {
-  configOutput << "#ifdef CONFIG_TOP" << std::endl;
-  outputConfigTopGeneral(configOutput, editor);
-  outputConfigTopPropSpecific(configOutput, editor);
-  outputConfigTopCustom(configOutput, editor);
-  configOutput << "#endif" << std::endl << std::endl;
+void Configuration::outputConfigTop(BufferedWriter& configOutput, const ConfigModel& config) {
+  configOutput << "#ifdef CONFIG_TOP\n";
+  outputConfigTopGeneral(configOutput, config);
+  outputConfigTopPropSpecific(configOutput, config);
+  outputConfigTopCustom(configOutput, config);
+  configOutput << "#endif\n\n";
 
 }
-void Configuration::outputConfigTopGeneral(std::ofstream& configOutput, EditorWindow* editor) {
-  if (editor->generalPage->massStorage->GetValue()) configOutput << "//PROFFIECONFIG ENABLE_MASS_STORAGE" << std::endl;
-  if (editor->generalPage->webUSB->GetValue()) configOutput << "//PROFFIECONFIG ENABLE_WEBUSB" << std::endl;
-
-  configOutput << findInVMap(Proffieboard, editor->generalPage->board->entry()->GetStringSelection().ToStdString()).second << std::endl;
-
-  configOutput << "const unsigned int maxLedsPerStrip = " << editor->generalPage->maxLEDs->entry()->GetValue() << ";" << std::endl;
-  configOutput << "#define ENABLE_AUDIO" << std::endl;
-  configOutput << "#define ENABLE_WS2811" << std::endl;
-  configOutput << "#define ENABLE_SD" << std::endl;
-  configOutput << "#define ENABLE_MOTION" << std::endl;
-  configOutput << "#define SHARED_POWER_PINS" << std::endl;
-
-  for (const auto& [ name, define ] : editor->settings->generalDefines) {
-    if (define->shouldOutput()) configOutput << "#define " << define->getOutput() << std::endl;
+void Configuration::outputConfigTopGeneral(BufferedWriter& configOutput, const ConfigModel& config) {
+  if (config.general.massStorage) configOutput << "//PROFFIECONFIG ENABLE_MASS_STORAGE\n";
+  if (config.general.webUSB) configOutput << "//PROFFIECONFIG ENABLE_WEBUSB\n";
+
+  configOutput << Proffieboard.at(config.general.board).second << '\n';
+
+  configOutput << "const unsigned int maxLedsPerStrip = " << config.general.maxLEDs << ";\n";
+  configOutput << "#define ENABLE_AUDIO\n";
+  configOutput << "#define ENABLE_WS2811\n";
+  configOutput << "#define ENABLE_SD\n";
+  configOutput << "#define ENABLE_MOTION\n";
+  configOutput << "#define SHARED_POWER_PINS\n";
+
+  Settings settings(config);
+  for (const auto& [ name, define ] : settings.generalDefines) {
+    if (define->shouldOutput()) configOutput << "#define " << define->getOutput() << '\n';
   }
 }
-void Configuration::outputConfigTopPropSpecific(std::ofstream& configOutput, EditorWindow* editor) {
-  auto selectedProp = editor->propsPage->getSelectedProp();
-  if (selectedProp == nullptr) return;
-
-  for (const auto& [ name, setting ] : *selectedProp->getSettings()) {
-    if (
-        !setting.checkRequiredSatisfied(*selectedProp->getSettings()) ||
-        setting.disabled ||
-        !setting.shouldOutput
-        ) continue;
-
-    auto output = setting.getOutput();
-    if (!output.empty()) configOutput << "#define " << output << std::endl;
+void Configuration::outputConfigTopPropSpecific(BufferedWriter& configOutput, const ConfigModel& config) {
+  for (const auto& [ name, value ] : config.propDefines) {
+    configOutput << "#define " << name;
+    if (!value.empty()) configOutput << ' ' << value;
+    configOutput << '\n';
   }
 }
-void Configuration::outputConfigTopCustom(std::ofstream& configOutput, EditorWindow* editor) {
-    for (const auto& [ name, value ] : editor->generalPage->customOptDlg->getCustomDefines()) {
-        if (!name.empty()) configOutput << "#define " << name << " " << value << std::endl;
+void Configuration::outputConfigTopCustom(BufferedWriter& configOutput, const ConfigModel& config) {
+    for (const auto& [ name, value ] : config.customDefines) {
+        if (!name.empty()) configOutput << "#define " << name << " " << value << '\n';
     }
 }
 
-void Configuration::outputConfigProp(std::ofstream& configOutput, EditorWindow* editor) {
-  auto selectedProp = editor->propsPage->getSelectedProp();
-  if (selectedProp == nullptr) return;
+void Configuration::outputConfigProp(BufferedWriter& configOutput, const ConfigModel& config) {
+  if (config.propFile.empty()) return;
 
-  configOutput << "#ifdef CONFIG_PROP" << std::endl;
-  configOutput << "#include \"../props/" << selectedProp->getFileName() << "\"" << std::endl;
-  configOutput << "#endif" << std:: endl << std::endl; // CONFIG_PROP
+  configOutput << "#ifdef CONFIG_PROP\n";
+  configOutput << "#include \"../props/" << config.propFile << "\"\n";
+  configOutput << "#endif\n\n"; // CONFIG_PROP
 }
-void Configuration::outputConfigPresets(std::ofstream& configOutput, EditorWindow* editor) {
-  configOutput << "#ifdef CONFIG_PRESETS" << std::endl;
-  outputConfigPresetsStyles(configOutput, editor);
-  outputConfigPresetsBlades(configOutput, editor);
-  configOutput << "#endif" << std::endl << std::endl;
+void Configuration::outputConfigPresets(BufferedWriter& configOutput, const ConfigModel& config) {
+  configOutput << "#ifdef CONFIG_PRESETS\n";
+  outputConfigPresetsStyles(configOutput, config);
+  outputConfigPresetsBlades(configOutput, config);
+  configOutput << "#endif\n\n";
 }
-void Configuration::outputConfigPresetsStyles(std::ofstream& configOutput, EditorWindow* editor) {
-  for (const BladeArrayDlg::BladeArray& bladeArray : editor->bladesPage->bladeArrayDlg->bladeArrays) {
-    configOutput << "Preset " << bladeArray.name << "[] = {" << std::endl;
-    for (const PresetsPage::PresetConfig& preset : bladeArray.presets) {
-      configOutput << "\t{ \"" << preset.dirs << "\", \"" << preset.track << "\"," << std::endl;
+void Configuration::outputConfigPresetsStyles(BufferedWriter& configOutput, const ConfigModel& config) {
+  for (const ConfigModel::BladeArray& bladeArray : config.bladeArrays) {
+    configOutput << "Preset " << bladeArray.name << "[] = {\n";
+    for (const ConfigModel::Preset& preset : bladeArray.presets) {
+      configOutput << "\t{ \"" << preset.dirs << "\", \"" << preset.track << "\",\n";
       if (preset.styles.size() > 0) {
+        StyleTree tree;
         for (const wxString& style : preset.styles) {
-          std::istringstream styleStream(style.ToStdString());
-          std::string styleLine;
+          tree.parse(style.ToStdString());
+          auto styleSource = tree.getSource();
           while (!false) {
-            std::getline(styleStream, styleLine);
-              configOutput << "\t\t" << styleLine;
-            if (styleStream.eof()) {
-                  configOutput << "," << std::endl;
+            auto lineEnd = styleSource.find('\n');
+            configOutput << "\t\t" << styleSource.substr(0, lineEnd);
+            if (lineEnd == std::string_view::npos) {
+              configOutput << ",\n";
               break;
-            } else configOutput << std::endl;
+            } else configOutput << '\n';
+            styleSource.remove_prefix(lineEnd + 1);
           }
         }
-      } else configOutput << "\t\t," << std::endl;
+      } else configOutput << "\t\t,\n";
       configOutput << "\t\t\"" << preset.name << "\"}";
       // If not the last one, add comma
       if (&bladeArray.presets[bladeArray.presets.size() - 1] != &preset) configOutput << ",";
-      configOutput << std::endl;
+      configOutput << '\n';
     }
-    configOutput << "};" << std::endl;
+    configOutput << "};\n";
   }
 }
-void Configuration::outputConfigPresetsBlades(std::ofstream& configOutput, EditorWindow* editor) {
-  configOutput << "BladeConfig blades[] = {" << std::endl;
-  for (const BladeArrayDlg::BladeArray& bladeArray : editor->bladesPage->bladeArrayDlg->bladeArrays) {
-    configOutput << "\t{ " << (bladeArray.name == "no_blade" ? "NO_BLADE" : std::to_string(bladeArray.value)) << "," << std::endl;
-    for (const BladesPage::BladeConfig& blade : bladeArray.blades) {
+void Configuration::outputConfigPresetsBlades(BufferedWriter& configOutput, const ConfigModel& config) {
+  configOutput << "BladeConfig blades[] = {\n";
+  for (const ConfigModel::BladeArray& bladeArray : config.bladeArrays) {
+    configOutput << "\t{ " << (bladeArray.name == "no_blade" ? "NO_BLADE" : std::to_string(bladeArray.value)) << ",\n";
+    for (const ConfigModel::Blade& blade : bladeArray.blades) {
       if (blade.type == BD_PIXELRGB || blade.type == BD_PIXELRGBW) {
         if (blade.isSubBlade) genSubBlades(configOutput, blade);
         else {
           configOutput << "\t\t";
           genWS281X(configOutput, blade);
-          configOutput << "," << std::endl;
+          configOutput << ",\n";
         }
       } else if (blade.type == BD_TRISTAR || blade.type == BD_QUADSTAR) {
         bool powerPins[4]{true, true, true, true};
@@ -195,20 +200,20 @@ void Configuration::outputConfigPresetsBlades(std::ofstream& configOutput, Edito
 
           if (&usePowerPin != &powerPins[3]) configOutput << ", ";
         }
-        configOutput << ">()," << std::endl;
+        configOutput << ">(),\n";
       } else if (blade.type == BD_SINGLELED) {
         configOutput << "\t\tSimpleBladePtr<CreeXPE2WhiteTemplate<550>, NoLED, NoLED, NoLED, ";
         configOutput << (blade.powerPins.size() > 0 ? blade.powerPins.at(0) : "-1");
-        configOutput << ", -1, -1, -1>()," << std::endl;
+        configOutput << ", -1, -1, -1>(),\n";
       }
     }
-    configOutput << "\t\tCONFIGARRAY(" << bladeArray.name << "), \"" << bladeArray.name << "\"" << std::endl << "\t}";
-    if (&bladeArray != &editor->bladesPage->bladeArrayDlg->bladeArrays[editor->bladesPage->bladeArrayDlg->bladeArrays.size() - 1]) configOutput << ",";
-    configOutput << std::endl;
+    configOutput << "\t\tCONFIGARRAY(" << bladeArray.name << "), \"" << bladeArray.name << "\"\n\t}";
+    if (&bladeArray != &config.bladeArrays.back()) configOutput << ",";
+    configOutput << '\n';
   }
-  configOutput << "};" << std::endl;
+  configOutput << "};\n";
 }
-void Configuration::genWS281X(std::ofstream& configOutput, const BladesPage::BladeConfig& blade) {
+void Configuration::genWS281X(BufferedWriter& configOutput, const ConfigModel::Blade& blade) {
   wxString bladePin = blade.dataPin;
   wxString bladeColor = blade.type == BD_PIXELRGB || blade.useRGBWithWhite ? blade.colorType : [=](wxString colorType) -> wxString { colorType.replace(colorType.find("W"), 1, "w"); return colorType; }(blade.colorType);
 
@@ -218,7 +223,7 @@ void Configuration::genWS281X(std::ofstream& configOutput, const BladesPage::Bla
   }
   configOutput << ">>()";
 };
-void Configuration::genSubBlades(std::ofstream& configOutput, const BladesPage::BladeConfig& blade) {
+void Configuration::genSubBlades(BufferedWriter& configOutput, const ConfigModel::Blade& blade) {
   int32_t subNum{0};
   for (const auto& subBlade : blade.subBlades) {
     if (blade.useStride) {
@@ -239,65 +244,65 @@ void Configuration::genSubBlades(std::ofstream& configOutput, const BladesPage::
 
     if (subNum == 0) {
       genWS281X(configOutput, blade);
-      configOutput << ")," << std::endl;
+      configOutput << "),\n";
     } else {
-      configOutput << "NULL)," << std::endl;
+      configOutput << "NULL),\n";
     }
 
     subNum++;
   }
 }
-void Configuration::outputConfigButtons(std::ofstream& configOutput, EditorWindow* editor) {
-  configOutput << "#ifdef CONFIG_BUTTONS" << std::endl;
-  configOutput << "Button PowerButton(BUTTON_POWER, powerButtonPin, \"pow\");" << std::endl;
-  if (editor->generalPage->buttons->entry()->GetValue() >= 2) configOutput << "Button AuxButton(BUTTON_AUX, auxPin, \"aux\");" << std::endl;
-  if (editor->generalPage->buttons->entry()->GetValue() == 3) configOutput << "Button Aux2Button(BUTTON_AUX2, aux2Pin, \"aux\");" << std::endl; // figure out aux2 syntax
-  configOutput << "#endif" << std::endl << std::endl; // CONFIG_BUTTONS
+void Configuration::outputConfigButtons(BufferedWriter& configOutput, const ConfigModel& config) {
+  configOutput << "#ifdef CONFIG_BUTTONS\n";
+  configOutput << "Button PowerButton(BUTTON_POWER, powerButtonPin, \"pow\");\n";
+  if (config.general.buttons >= 2) configOutput << "Button AuxButton(BUTTON_AUX, auxPin, \"aux\");\n";
+  if (config.general.buttons == 3) configOutput << "Button Aux2Button(BUTTON_AUX2, aux2Pin, \"aux\");\n"; // figure out aux2 syntax
+  configOutput << "#endif\n\n"; // CONFIG_BUTTONS
 }
 
 bool Configuration::readConfig(const std::string& filePath, EditorWindow* editor) {
-  std::ifstream file(filePath);
-  if (!file.is_open()) return false;
+  ConfigModel config;
+  std::string error;
+  if (!readConfig(filePath, config, error)) {
+    std::cerr << error << std::endl;
+    return false;
+  }
+
+  editor->model = std::move(config);
+  editor->loadModel();
+  return true;
+}
+bool Configuration::readConfig(const std::string& filePath, ConfigModel& config, std::string& error) {
+  Lexer lexer;
+  if (!lexer.readFile(filePath)) {
+    error = "Could not open config file.";
+    return false;
+  }
 
   try {
-    std::string section;
-    while (!file.eof()) {
-      file >> section;
-      if (section == "//") {
-        getline(file, section);
-        continue;
-      }
-      if (std::strstr(section.data(), "/*")) {
-        while (!file.eof()) {
-          if (std::strstr(section.data(), "*/")) break;
-          file >> section;
-        }
-        continue;
-      }
-      if (section == "#ifdef") {
-        file >> section;
-        if (section == "CONFIG_TOP") Configuration::readConfigTop(file, editor);
-        if (section == "CONFIG_PROP") Configuration::readConfigProp(file, editor);
-        if (section == "CONFIG_PRESETS") Configuration::readConfigPresets(file, editor);
-        if (section == "CONFIG_STYLES") Configuration::readConfigStyles(file, editor);
-      }
+    Lexer::Stream stream(lexer);
+    StyleAliases aliases;
+    std::vector<std::string> defines;
+    while (!stream.eof()) {
+      const auto& token = stream.nextCode();
+      if (!token.is(Lexer::Token::Type::DIRECTIVE, "#ifdef")) continue;
+
+      const auto& section = stream.next();
+      if (section.text == "CONFIG_TOP") Configuration::readConfigTop(stream, config, defines);
+      else if (section.text == "CONFIG_PROP") Configuration::readConfigProp(stream, config);
+      else if (section.text == "CONFIG_PRESETS") Configuration::readConfigPresets(stream, config);
+      else if (section.text == "CONFIG_STYLES") Configuration::readConfigStyles(stream, aliases);
     }
-    // Wait to call remaining defines "custom" until prop file stuffage has been read
-    setCustomDefines(editor);
+    // Aliases are expanded once everything is read, so section order doesn't matter
+    expandStyleAliases(aliases, config);
+    setCustomDefines(defines, config);
 
   } catch (std::exception& e) {
-    std::string errorMessage = "There was an error parsing config, please ensure it is valid:\n\n";
-    errorMessage += e.what();
-
-    std::cerr << errorMessage << std::endl;
+    error = "There was an error parsing config, please ensure it is valid:\n\n";
+    error += e.what();
     return false;
   }
 
-  //GeneralPage::update();
-  editor->propsPage->update();
-  editor->bladesPage->update();
-  editor->presetsPage->update();
-
   return true;
 }
 bool Configuration::importConfig(EditorWindow* editor) {
@@ -308,352 +313,286 @@ bool Configuration::importConfig(EditorWindow* editor) {
   return Configuration::readConfig(configLocation.GetPath().ToStdString(), editor);
 }
 
-void Configuration::readConfigTop(std::ifstream& file, EditorWindow* editor) {
-  std::string element;
-  editor->settings->readDefines.clear();
-  while (!file.eof() && element != "#endif") {
-    file >> element;
-    if (element == "//") {
-      getline(file, element);
-      continue;
-    }
-    if (std::strstr(element.data(), "/*")) {
-      while (!file.eof()) {
-        if (std::strstr(element.data(), "*/")) break;
-        file >> element;
-      }
-      continue;
-    }
-    if (element == "#define" && !file.eof()) {
-      getline(file, element);
-      editor->settings->readDefines.push_back(element);
-    } else if (element == "const" && !file.eof()) {
-      getline(file, element);
-      std::strtok(element.data(), "="); // unsigned int maxLedsPerStrip =
-      element = std::strtok(nullptr, " ;");
-      editor->generalPage->maxLEDs->entry()->SetValue(std::stoi(element));
-    } else if (element == "#include" && !file.eof()) {
-      file >> element;
-      if (std::strstr(element.c_str(), "v1") != NULL) {
-        editor->generalPage->board->entry()->SetSelection(0);
-      } else if (std::strstr(element.c_str(), "v2") != NULL) {
-        editor->generalPage->board->entry()->SetSelection(1);
-      } else if (std::strstr(element.c_str(), "v3") != NULL) {
-        editor->generalPage->board->entry()->SetSelection(2);
+void Configuration::readConfigTop(Lexer::Stream& stream, ConfigModel& config, std::vector<std::string>& defines) {
+  int32_t depth{0};
+  while (!stream.eof()) {
+    const auto& token = stream.next();
+    if (endOfSection(token, depth)) break;
+
+    if (token.type == Lexer::Token::Type::COMMENT) {
+      if (token.text.rfind("//PROFFIECONFIG", 0) != 0) continue;
+      if (token.text.find("ENABLE_MASS_STORAGE") != std::string::npos) config.general.massStorage = true;
+      if (token.text.find("ENABLE_WEBUSB") != std::string::npos) config.general.webUSB = true;
+    } else if (token.is(Lexer::Token::Type::DIRECTIVE, "#define")) {
+      auto define = stream.getLexer().restOfLine(token);
+      define.remove_prefix(std::min(define.find_first_not_of(" \t"), define.size()));
+      defines.emplace_back(define);
+      stream.skipLine(token.line);
+    } else if (token.is(Lexer::Token::Type::IDENTIFIER, "const")) {
+      // const unsigned int maxLedsPerStrip = 144;
+      while (!stream.eof() && !stream.peekCode().isPunct('=') && !stream.peekCode().isPunct(';')) stream.nextCode();
+      if (!stream.peekCode().isPunct('=')) continue;
+      stream.nextCode();
+      const auto& value = stream.nextCode();
+      if (value.type == Lexer::Token::Type::NUMBER) config.general.maxLEDs = std::stoi(std::string(value.text));
+    } else if (token.is(Lexer::Token::Type::DIRECTIVE, "#include")) {
+      auto include = stream.getLexer().restOfLine(token);
+      if (include.find("v1") != std::string::npos) {
+        config.general.board = 0;
+      } else if (include.find("v2") != std::string::npos) {
+        config.general.board = 1;
+      } else if (include.find("v3") != std::string::npos) {
+        config.general.board = 2;
       }
-    } else if (element == "//PROFFIECONFIG") {
-      file >> element;
-      if (element == "ENABLE_MASS_STORAGE") editor->generalPage->massStorage->SetValue(true);
-      if (element == "ENABLE_WEBUSB") editor->generalPage->webUSB->SetValue(true);
+      stream.skipLine(token.line);
     }
   }
-  editor->settings->parseDefines(editor->settings->readDefines);
+  Settings(config).parseDefines(defines);
 }
-void Configuration::setCustomDefines(EditorWindow* editor) {
-    for (const auto& define : editor->settings->readDefines) {
+void Configuration::setCustomDefines(const std::vector<std::string>& defines, ConfigModel& config) {
+    // Prop settings land here too, see ConfigModel::propDefines
+    for (const auto& define : defines) {
         auto key = Settings::ProffieDefine::parseKey(define);
-        if (!key.first.empty()) editor->generalPage->customOptDlg->addDefine(key.first, key.second);
+        if (!key.first.empty()) config.customDefines.push_back(key);
     }
 }
-void Configuration::readConfigProp(std::ifstream& file, EditorWindow* editor) {
-  std::string element;
-  while (!file.eof() && element != "#endif") {
-    file >> element;
-    for (auto& prop : editor->propsPage->getLoadedProps()) {
-      auto propSettings = prop->getSettings();
-      if (element.find(prop->getFileName()) != std::string::npos) {
-        editor->propsPage->updateSelectedProp(prop->getName());
-        for (auto define = editor->settings->readDefines.begin(); define < editor->settings->readDefines.end();) {
-          std::istringstream defineStream(*define);
-          std::string defineName{};
-          double value{0};
-
-          defineStream >> defineName;
-          auto key = propSettings->find(defineName);
-          if (key == propSettings->end()) {
-            define++;
-            continue;
-          }
-
-          if (
-             key->second.type == PropFile::Setting::SettingType::TOGGLE ||
-             key->second.type == PropFile::Setting::SettingType::OPTION
-              ) {
-            key->second.setValue(true);
-          } else {
-            defineStream >> value;
-            key->second.setValue(value);
-          }
-          define = editor->settings->readDefines.erase(define);
-        }
-        break;
-      }
-    }
+void Configuration::readConfigProp(Lexer::Stream& stream, ConfigModel& config) {
+  int32_t depth{0};
+  while (!stream.eof()) {
+    const auto& token = stream.nextCode();
+    if (endOfSection(token, depth)) break;
+    if (token.type != Lexer::Token::Type::STRING) continue;
+
+    // #include "../props/saber_fett263_buttons.h"
+    auto include = token.unquoted();
+    auto separator = include.find_last_of("/\\");
+    if (separator != std::string_view::npos) include.remove_prefix(separator + 1);
+    config.propFile.assign(include);
   }
 }
-void Configuration::readConfigPresets(std::ifstream& file, EditorWindow* editor) {
-  editor->bladesPage->bladeArrayDlg->bladeArrays.clear();
-  std::string element;
-  while (!file.eof() && element != "#endif") {
-    file >> element;
-    if (element.find("//") == 0) {
-      getline(file, element);
-      continue;
-    }
-    if (std::strstr(element.data(), "/*")) {
-      while (!file.eof()) {
-        if (std::strstr(element.data(), "*/")) break;
-        file >> element;
-      }
-      continue;
-    }
-    if (element == "Preset") readPresetArray(file, editor);
-    if (element == "BladeConfig") readBladeArray(file, editor);
+void Configuration::readConfigPresets(Lexer::Stream& stream, ConfigModel& config) {
+  config.bladeArrays.clear();
+  int32_t depth{0};
+  while (!stream.eof()) {
+    const auto& token = stream.nextCode();
+    if (endOfSection(token, depth)) break;
+
+    if (token.is(Lexer::Token::Type::IDENTIFIER, "Preset")) readPresetArray(stream, config);
+    else if (token.is(Lexer::Token::Type::IDENTIFIER, "BladeConfig")) readBladeArray(stream, config);
   }
 }
-void Configuration::readConfigStyles(std::ifstream& file, EditorWindow* editor) {
-  std::string element;
-  std::string styleName;
-  std::string style;
-
-  while (!file.eof() && element != "#endif") {
-    file >> element;
-    if (element != "using") continue;
-
-    file >> styleName;
-    file >> element; // Clear "="
-
-    style.clear();
-    while (style.find(";") == std::string::npos) {
-      style += file.get();
-    }
-    style.erase(style.rfind(";")); // remove trailing ";"
-    // style.erase(std::remove(style.begin(), style.end(), '\n'), style.end()); // remove newlines
+void Configuration::readConfigStyles(Lexer::Stream& stream, StyleAliases& aliases) {
+  const auto& lexer = stream.getLexer();
+  int32_t depth{0};
+  while (!stream.eof()) {
+    const auto& token = stream.nextCode();
+    if (endOfSection(token, depth)) break;
+    if (!token.is(Lexer::Token::Type::IDENTIFIER, "using")) continue;
+
+    const auto& styleName = stream.nextCode();
+    if (styleName.type != Lexer::Token::Type::IDENTIFIER) continue;
+    if (stream.peekCode().isPunct('=')) stream.nextCode();
+
+    auto styleBegin = stream.position();
+    while (!stream.eof() && !stream.peek().isPunct(';') && stream.peek().type != Lexer::Token::Type::DIRECTIVE) stream.next();
+    auto styleEnd = stream.position();
 
     // Remove potential StylePtr<> syntax
-    if (style.find("StylePtr") != std::string::npos) {
-      style.erase(style.rfind("StylePtr<"), 9);
-      style.erase(style.find(">()"), 3);
-    }
+    auto args = templateArgs(lexer, styleBegin, styleEnd);
+    std::string style;
+    if (codeText(lexer, styleBegin, styleEnd).rfind("StylePtr<", 0) == 0 && !args.empty()) style = codeText(lexer, args.front().first, args.back().second);
+    else style = codeText(lexer, styleBegin, styleEnd);
 
-    Configuration::replaceStyles(styleName, style, editor);
+    aliases[std::string(styleName.text)] = style;
   }
-  file >> element;
 }
-void Configuration::readPresetArray(std::ifstream& file, EditorWindow* editor) {
-# define CHKSECT if (file.eof() || file.bad() || element == "#endif" || strstr(element.data(), "};") != NULL) return
-
-# define RUNTOSECTION element.clear(); while (element.find('{') == std::string::npos) { element += file.get(); CHKSECT; }
-
-  editor->bladesPage->bladeArrayDlg->bladeArrays.push_back(BladeArrayDlg::BladeArray());
-  BladeArrayDlg::BladeArray& bladeArray = editor->bladesPage->bladeArrayDlg->bladeArrays.at(editor->bladesPage->bladeArrayDlg->bladeArrays.size() - 1);
+void Configuration::readPresetArray(Lexer::Stream& stream, ConfigModel& config) {
+  const auto& lexer = stream.getLexer();
+  const auto& arrayName = stream.nextCode();
+  if (arrayName.type != Lexer::Token::Type::IDENTIFIER) return;
+
+  config.bladeArrays.push_back(ConfigModel::BladeArray());
+  ConfigModel::BladeArray& bladeArray = config.bladeArrays.back();
+  bladeArray.name.assign(std::string(arrayName.text));
+
+  while (!stream.eof() && !stream.peekCode().isPunct('{')) {
+    if (stream.peekCode().isPunct(';') || stream.peekCode().type == Lexer::Token::Type::DIRECTIVE) return;
+    stream.nextCode();
+  }
+  stream.nextCode(); // Opening brace of array
 
-  char* tempData;
-  static constexpr const char* detokenizeStr = "\t ,\r\n\"}";
-  std::string presetInfo;
-  std::string element;
-  std::string comment;
-  element.clear();
-  file >> element;
-  bladeArray.name.assign(std::strtok(element.data(), "[]"));
+  auto readString = [&](const StyleTree& element, wxString& output) -> bool {
+    if (element.getRoot() == nullptr || element.getRoot()->type != StyleTree::Node::Type::STRING) return false;
+    output = std::string(lexer.getTokens().at(element.getRoot()->begin).unquoted());
+    return true;
+  };
 
-  RUNTOSECTION;
-  uint32_t preset = -1;
   bladeArray.presets.clear();
-  while (!false) {
-    presetInfo.clear();
-    RUNTOSECTION;
-    bladeArray.presets.push_back(PresetsPage::PresetConfig());
-    preset++;
-
-    while (presetInfo.find("}") == std::string::npos) {
-      element.clear();
-      while (element.find(' ') == std::string::npos && element.find('\n') == std::string::npos) { element += file.get(); }
-      CHKSECT;
-      presetInfo.append(element);
+  while (!stream.eof()) {
+    const auto& token = stream.peekCode();
+    if (token.type == Lexer::Token::Type::DIRECTIVE) return;
+    stream.nextCode();
+    if (token.isPunct('}')) return;
+    if (!token.isPunct('{')) continue;
+
+    TokenRanges ranges;
+    std::string comment; // Deal with Fett's comments
+    if (!readInitializer(stream, ranges, &comment)) return;
+
+    std::vector<StyleTree> elements(ranges.size());
+    for (size_t idx = 0; idx < ranges.size(); idx++) elements[idx].parse(lexer, ranges[idx].first, ranges[idx].second);
+
+    bladeArray.presets.push_back(ConfigModel::Preset());
+    ConfigModel::Preset& preset = bladeArray.presets.back();
+
+    size_t firstStyle{0};
+    size_t lastStyle{elements.size()};
+    if (firstStyle < lastStyle && readString(elements.at(firstStyle), preset.dirs)) firstStyle++;
+    if (firstStyle < lastStyle && readString(elements.at(firstStyle), preset.track)) firstStyle++;
+    if (firstStyle < lastStyle && readString(elements.at(lastStyle - 1), preset.name)) lastStyle--;
+    if (preset.name.empty()) preset.name = "noname";
+
+    for (auto element = firstStyle; element < lastStyle; element++) {
+      // Malformed styles are kept as written so runPreChecks can point them out
+      auto style = elements.at(element).getRoot() == nullptr ? codeText(lexer, ranges.at(element).first, ranges.at(element).second) : elements.at(element).getText();
+      preset.styles.push_back((element == firstStyle ? comment : std::string{}) + style);
     }
-
-
-    // Directory
-    auto dirBegin = presetInfo.find('"') + 1;
-    auto dirEnd   = presetInfo.find('"', dirBegin);
-    bladeArray.presets[preset].dirs.assign(presetInfo.substr(dirBegin, dirEnd - dirBegin));
-
-    // Same thing but for track
-    auto trackBegin = presetInfo.find('"', dirEnd + 2) + 1;
-    auto trackEnd   = presetInfo.find('"', trackBegin);
-    bladeArray.presets[preset].track.assign(presetInfo.substr(trackBegin, trackEnd - trackBegin));
-
-    presetInfo = presetInfo.substr(trackEnd + 2); // Clear
-
-    // Deal with Fett's comments
-    comment.clear();
-    while (presetInfo.find("/*") != std::string::npos) {
-      auto commentBegin = presetInfo.find("/*");
-      auto commentLength = presetInfo.find("*/") - commentBegin + 2;
-      comment += presetInfo.substr(commentBegin, commentLength);
-      presetInfo.erase(commentBegin, commentLength);
-    }
-
-    // Read actual styles
-    for (int32_t blade = 0; blade < editor->settings->numBlades; blade++) {
-      if (presetInfo.find("&style_charging,") < presetInfo.find("Style")) {
-        presetInfo = presetInfo.substr(presetInfo.find("&style_charging,") + 16 /* length of "&style_charging,"*/);
-        bladeArray.presets[preset].styles.push_back("&style_charging");
-      } else if (presetInfo.find("&style_pov") < presetInfo.find("Style")) {
-        presetInfo = presetInfo.substr(presetInfo.find("&style_pov,") + 11 /* length of "&style_pov,"*/);
-        bladeArray.presets[preset].styles.push_back("&style_pov");
-      } else {
-        auto presetBegin = presetInfo.find("Style");
-        auto presetEnd = presetInfo.find("()") + 2;
-        element = presetInfo.substr(presetBegin, presetEnd - presetBegin); // Copy in next
-
-        presetInfo = presetInfo.substr(presetEnd); // Increment
-        bladeArray.presets[preset].styles.push_back((blade == 0 ? comment : std::string{}) + element);
-      }
-    }
-
-    // Name
-    tempData = std::strtok(presetInfo.data(), detokenizeStr);
-    bladeArray.presets[preset].name.assign(tempData == nullptr ? "noname" : tempData);
   }
-# undef CHKSECT
-# undef RUNTOSECTION
 }
-void Configuration::readBladeArray(std::ifstream& file, EditorWindow* editor) {
-# define CHKSECT if (file.eof() || element == "#endif" || strstr(element.data(), "};") != NULL) return
-# define RUNTOSECTION element.clear(); while (element != "{") { file >> element; CHKSECT; }
+void Configuration::readBladeArray(Lexer::Stream& stream, ConfigModel& config) {
   // In future get detect val and presetarray association
+  const auto& lexer = stream.getLexer();
+  const auto& tokens = lexer.getTokens();
+
+  auto firstCode = [&](const TokenRange& range) {
+    auto index = range.first;
+    while (index < range.second && tokens.at(index).type == Lexer::Token::Type::COMMENT) index++;
+    return index;
+  };
+  auto findIdentifier = [&](const TokenRange& range, std::string_view identifier) {
+    for (auto index = range.first; index < range.second; index++) {
+      if (tokens.at(index).is(Lexer::Token::Type::IDENTIFIER, identifier)) return index;
+    }
+    return range.second;
+  };
+  auto readWS281X = [&](const TokenRange& range, ConfigModel::Blade& blade) {
+    auto args = templateArgs(lexer, range.first, range.second);
+    if (args.size() < 3) return;
+
+    blade.numPixels = std::stoi(codeText(lexer, args.at(0).first, args.at(0).second));
+    blade.dataPin = codeText(lexer, args.at(1).first, args.at(1).second);
+    auto colorType = codeText(lexer, args.at(2).first, args.at(2).second); // Color8::GRB
+    colorType.erase(0, colorType.rfind(':') == std::string::npos ? 0 : colorType.rfind(':') + 1);
+    blade.useRGBWithWhite = colorType.find('W') != std::string::npos;
+    blade.colorType.assign(colorType);
+
+    if (args.size() < 4) return;
+    for (const auto& powerPin : templateArgs(lexer, args.at(3).first, args.at(3).second)) {
+      blade.powerPins.push_back(codeText(lexer, powerPin.first, powerPin.second));
+    }
+  };
+  auto readSimple = [&](const TokenRange& range, ConfigModel::Blade& blade) {
+    auto getStarTemplate = [](const std::string& element) -> std::string {
+      if (element.find("RedOrange") != std::string::npos) return "RedOrange";
+      if (element.find("Amber") != std::string::npos) return "Amber";
+      if (element.find("White") != std::string::npos) return "White";
+      if (element.find("Red") != std::string::npos) return "Red";
+      if (element.find("Green") != std::string::npos) return "Green";
+      if (element.find("Blue") != std::string::npos) return "Blue";
+      // With this implementation, RedOrange must be before Red
+      return BD_NORESISTANCE;
+    };
+    wxString* stars[]{ &blade.Star1, &blade.Star2, &blade.Star3, &blade.Star4 };
+    int32_t* resistances[]{ &blade.Star1Resistance, &blade.Star2Resistance, &blade.Star3Resistance, &blade.Star4Resistance };
+
+    auto args = templateArgs(lexer, range.first, range.second);
+    uint32_t numLEDs = 0;
+    for (size_t star = 0; star < 4 && star < args.size(); star++) {
+      stars[star]->assign(getStarTemplate(codeText(lexer, args.at(star).first, args.at(star).second)));
+      if (*stars[star] == BD_NORESISTANCE) continue;
+
+      numLEDs++;
+      auto resistance = templateArgs(lexer, args.at(star).first, args.at(star).second);
+      if (!resistance.empty()) *resistances[star] = std::stoi(codeText(lexer, resistance.at(0).first, resistance.at(0).second));
+    }
 
-  BladeArrayDlg::BladeArray bladeArray;
-  std::string element;
-  std::string data;
-  int32_t tempNumBlades;
-  RUNTOSECTION;
-
-  while (true) {
-    bladeArray = {};
-    RUNTOSECTION;
-    file >> element;
-    element = std::strtok(element.data(), " ,");
-    bladeArray.value = std::strstr(element.data(), "NO_BLADE") ? 0 : std::stoi(element);
-    CHKSECT;
-    bladeArray.blades.clear();
-    tempNumBlades = editor->settings->numBlades;
-    for (int32_t blade = 0; blade < tempNumBlades; blade++) {
-      data.clear();
-
-      do { // Gather entire blade data
-        file >> element;
-        CHKSECT;
-        data.append(element);
-      } while (std::strstr(data.data(), "),") == nullptr);
-
-      if (std::strstr(data.data(), "SubBlade") != nullptr) {
-        if (std::strstr(data.data(), "NULL") == nullptr) { // Top Level SubBlade
-          bladeArray.blades.push_back(BladesPage::BladeConfig());
-          if (std::strstr(data.data(), "WithStride")) bladeArray.blades.at(blade).useStride = true;
-          if (std::strstr(data.data(), "ZZ")) bladeArray.blades.at(blade).useZigZag = true;
-        } else { // Lesser SubBlade
-          blade--;
-          tempNumBlades--;
-          // Switch to operating on previous blade
-        }
+    if (numLEDs <= 2) blade.type.assign(BD_SINGLELED);
+    if (numLEDs == 3) blade.type.assign(BD_TRISTAR);
+    if (numLEDs >= 4) blade.type.assign(BD_QUADSTAR);
 
-        bladeArray.blades[blade].isSubBlade = true;
-        std::strtok(data.data(), "("); // SubBlade(
-        bladeArray.blades[blade].subBlades.push_back({ (uint32_t)std::stoi(std::strtok(nullptr, "(,")), (uint32_t)std::stoi(std::strtok(nullptr, " (,")) });
-        data = std::strtok(nullptr, ""); // Clear out mangled data from strtok, replace with rest of data ("" runs until end of what's left)
-        // Rest will be handled by WS281X "if"
-      }
-      if (std::strstr(data.data(), "WS281XBladePtr") != nullptr) {
-        if (static_cast<int32_t>(bladeArray.blades.size()) - 1 != blade) bladeArray.blades.push_back(BladesPage::BladeConfig());
-        data = std::strstr(data.data(), "WS281XBladePtr"); // Shift start to blade data, in case of SubBlade;
-
-        std::strtok(data.data(), "<,"); // Clear WS281XBladePtr
-        bladeArray.blades[blade].numPixels = std::stoi(std::strtok(nullptr, "<,"));
-        bladeArray.blades[blade].dataPin = std::strtok(nullptr, ",");
-        std::strtok(nullptr, ":"); // Clear Color8::
-        element = std::strtok(nullptr, ":,"); // Set to color order;
-        bladeArray.blades[blade].useRGBWithWhite = strstr(element.data(), "W") != nullptr;
-        bladeArray.blades[blade].colorType.assign(element);
-
-        std::strtok(nullptr, "<"); // Clear PowerPINS
-        while (!false) {
-          char* tempStore = std::strtok(nullptr, " ()<>,");
-          if (tempStore == nullptr) break;
-          bladeArray.blades[blade].powerPins.push_back(tempStore);
-        }
-        continue;
-      }
-      if (std::strstr(data.data(), "SimpleBladePtr") != nullptr) {
-        bladeArray.blades.push_back(BladesPage::BladeConfig());
-        uint32_t numLEDs = 0;
-        auto getStarTemplate = [](const std::string& element) -> std::string {
-          if (std::strstr(element.data(), "RedOrange") != nullptr) return "RedOrange";
-          if (std::strstr(element.data(), "Amber") != nullptr) return "Amber";
-          if (std::strstr(element.data(), "White") != nullptr) return "White";
-          if (std::strstr(element.data(), "Red") != nullptr) return "Red";
-          if (std::strstr(element.data(), "Green") != nullptr) return "Green";
-          if (std::strstr(element.data(), "Blue") != nullptr) return "Blue";
-          // With this implementation, RedOrange must be before Red
-          return BD_NORESISTANCE;
-        };
+    for (size_t pin = 4; pin < args.size(); pin++) {
+      auto powerPin = codeText(lexer, args.at(pin).first, args.at(pin).second);
+      if (powerPin == "-1") break;
+      blade.powerPins.push_back(powerPin);
+    }
+  };
 
-        std::strtok(data.data(), "<"); // Clear SimpleBladePtr and setup strtok
+  while (!stream.eof() && !stream.peekCode().isPunct('{')) {
+    if (stream.peekCode().isPunct(';') || stream.peekCode().type == Lexer::Token::Type::DIRECTIVE) return;
+    stream.nextCode();
+  }
+  stream.nextCode(); // Opening brace of array
+
+  while (!stream.eof()) {
+    const auto& token = stream.peekCode();
+    if (token.type == Lexer::Token::Type::DIRECTIVE) return;
+    stream.nextCode();
+    if (token.isPunct('}')) return;
+    if (!token.isPunct('{')) continue;
+
+    TokenRanges elements;
+    if (!readInitializer(stream, elements)) return;
+    if (elements.empty()) continue;
+
+    ConfigModel::BladeArray bladeArray;
+    auto value = codeText(lexer, elements.at(0).first, elements.at(0).second);
+    bladeArray.value = value.find("NO_BLADE") != std::string::npos ? 0 : std::stoi(value);
+
+    for (auto element = std::next(elements.begin()); element != elements.end(); element++) {
+      const auto& kind = tokens.at(firstCode(*element));
+
+      if (kind.is(Lexer::Token::Type::IDENTIFIER, "CONFIGARRAY")) {
+        auto args = codeText(lexer, element->first, element->second);
+        auto nameStart = args.find('(') + 1;
+        auto nameEnd = args.find(')');
+        bladeArray.name.assign(args.substr(nameStart, nameEnd - nameStart));
+        break;
+      }
 
-        element = std::strtok(nullptr, "<,");
-        bladeArray.blades[blade].Star1.assign(getStarTemplate(element));
-        if (bladeArray.blades[blade].Star1 != BD_NORESISTANCE) {
-          numLEDs++;
-          bladeArray.blades[blade].Star1Resistance = std::stoi(std::strtok(nullptr, "<>"));
-        }
-        element = std::strtok(nullptr, "<,");
-        bladeArray.blades[blade].Star2.assign(getStarTemplate(element));
-        if (bladeArray.blades[blade].Star2 != BD_NORESISTANCE) {
-          numLEDs++;
-          bladeArray.blades[blade].Star2Resistance = std::stoi(std::strtok(nullptr, "<>"));
+      if (kind.type == Lexer::Token::Type::IDENTIFIER && kind.text.rfind("SubBlade", 0) == 0) {
+        std::vector<uint32_t> pixels;
+        for (auto index = element->first; index < element->second && pixels.size() < 2; index++) {
+          if (tokens.at(index).type == Lexer::Token::Type::NUMBER) pixels.push_back(std::stoi(std::string(tokens.at(index).text)));
         }
-        element = std::strtok(nullptr, "<, ");
-        bladeArray.blades[blade].Star3.assign(getStarTemplate(element));
-        if (bladeArray.blades[blade].Star3 != BD_NORESISTANCE) {
-          numLEDs++;
-          bladeArray.blades[blade].Star3Resistance = std::stoi(std::strtok(nullptr, "<>"));
-        }
-        element = std::strtok(nullptr, "<, ");
-        bladeArray.blades[blade].Star4.assign(getStarTemplate(element));
-        if (bladeArray.blades[blade].Star4 != BD_NORESISTANCE) {
-          numLEDs++;
-          bladeArray.blades[blade].Star4Resistance = std::stoi(std::strtok(nullptr, "<>"));
-        }
-
-        if (numLEDs <= 2) bladeArray.blades[blade].type.assign(BD_SINGLELED);
-        if (numLEDs == 3) bladeArray.blades[blade].type.assign(BD_TRISTAR);
-        if (numLEDs >= 4) bladeArray.blades[blade].type.assign(BD_QUADSTAR);
+        if (pixels.size() < 2) continue;
 
-        while (!false) {
-          char* tempStore = std::strtok(nullptr, " ()<>,");
-          if (tempStore == nullptr) break;
-          if (strstr(tempStore, "-1")) break;
-          bladeArray.blades[blade].powerPins.push_back(tempStore);
+        if (findIdentifier(*element, "NULL") != element->second && !bladeArray.blades.empty()) { // Lesser SubBlade
+          bladeArray.blades.back().isSubBlade = true;
+          bladeArray.blades.back().subBlades.push_back({ pixels.at(0), pixels.at(1) });
+          continue;
         }
+
+        bladeArray.blades.push_back(ConfigModel::Blade()); // Top Level SubBlade
+        auto& blade = bladeArray.blades.back();
+        blade.isSubBlade = true;
+        blade.useStride = kind.text == "SubBladeWithStride";
+        blade.useZigZag = kind.text == "SubBladeZZ";
+        blade.subBlades.push_back({ pixels.at(0), pixels.at(1) });
+
+        auto ws281x = findIdentifier(*element, "WS281XBladePtr");
+        if (ws281x != element->second) readWS281X({ ws281x, element->second }, blade);
+      } else if (kind.is(Lexer::Token::Type::IDENTIFIER, "WS281XBladePtr")) {
+        bladeArray.blades.push_back(ConfigModel::Blade());
+        readWS281X(*element, bladeArray.blades.back());
+      } else if (kind.is(Lexer::Token::Type::IDENTIFIER, "SimpleBladePtr")) {
+        bladeArray.blades.push_back(ConfigModel::Blade());
+        readSimple(*element, bladeArray.blades.back());
       }
     }
 
-    data.clear();
-    do {
-      file >> element;
-      CHKSECT;
-      data.append(element);
-    } while (std::strstr(data.data(), ")") == nullptr);
-
-    int32_t nameStart = data.find("CONFIGARRAY(") + 12;
-    int32_t nameEnd = data.find(")");
-    bladeArray.name.assign(data.substr(nameStart, nameEnd - nameStart));
-
-    if (bladeArray.blades.empty()) bladeArray.blades.push_back(BladesPage::BladeConfig{});
+    if (bladeArray.blades.empty()) bladeArray.blades.push_back(ConfigModel::Blade{});
 
-    for (BladeArrayDlg::BladeArray& array : editor->bladesPage->bladeArrayDlg->bladeArrays) {
+    for (ConfigModel::BladeArray& array : config.bladeArrays) {
       if (array.name == bladeArray.name) {
         array.value = bladeArray.value;
         array.blades = bladeArray.blades;
@@ -663,90 +602,201 @@ void Configuration::readBladeArray(std::ifstream& file, EditorWindow* editor) {
         }
       }
     }
-
-    for (const auto& blade : bladeArray.blades) {
-      for (const auto& powerPin : blade.powerPins) {
-        if (editor->bladesPage->powerPins->FindString(powerPin) == wxNOT_FOUND) editor->bladesPage->powerPins->Append(powerPin);
+  }
+}
+void Configuration::expandStyleAliases(const StyleAliases& aliases, ConfigModel& config) {
+  if (aliases.empty()) return;
+
+  StyleAliases expanded;
+  std::unordered_set<std::string> expanding;
+  std::function<const std::string*(std::string_view)> expandAlias = [&](std::string_view name) -> const std::string* {
+    std::string key(name);
+    auto done = expanded.find(key);
+    if (done != expanded.end()) return &done->second;
+
+    auto alias = aliases.find(key);
+    if (alias == aliases.end()) return nullptr;
+    if (!expanding.insert(key).second) throw std::runtime_error("Style alias \"" + key + "\" refers back to itself.");
+
+    StyleTree tree;
+    tree.parse(alias->second);
+    auto& result = expanded[key] = tree.substitute(expandAlias);
+    expanding.erase(key);
+    return &result;
+  };
+
+  StyleTree tree;
+  for (ConfigModel::BladeArray& bladeArray : config.bladeArrays) {
+    for (ConfigModel::Preset& preset : bladeArray.presets) {
+      for (wxString& style : preset.styles) {
+        tree.parse(style.ToStdString());
+        style = tree.substitute(expandAlias);
       }
     }
   }
+}
 
+bool Configuration::endOfSection(const Lexer::Token& token, int32_t& depth) {
+  if (token.type != Lexer::Token::Type::DIRECTIVE) return false;
+  if (token.text.rfind("#if", 0) == 0) depth++;
+  else if (token.text.rfind("#endif", 0) == 0 && depth-- == 0) return true;
+  return false;
+}
+bool Configuration::readInitializer(Lexer::Stream& stream, TokenRanges& elements, std::string* comments) {
+  int32_t depth{0};
+  auto elementBegin = stream.position();
+  bool hasCode{false};
+  auto pushElement = [&](size_t elementEnd) {
+    if (hasCode) elements.emplace_back(elementBegin, elementEnd);
+    elementBegin = elementEnd + 1;
+    hasCode = false;
+  };
+
+  while (!stream.eof()) {
+    auto position = stream.position();
+    const auto& token = stream.next();
+    if (token.type == Lexer::Token::Type::COMMENT) {
+      if (comments == nullptr) continue;
+      comments->append(token.text);
+      if (token.text.rfind("//", 0) == 0) comments->push_back('\n');
+      continue;
+    }
+    if (token.type == Lexer::Token::Type::DIRECTIVE) {
+      stream.seek(position);
+      return false;
+    }
 
-# undef CHKSECT
-# undef RUNTOSECTION
+    if (token.isPunct('(') || token.isPunct('{') || token.is(Lexer::Token::Type::TEMPLATE_OPEN)) {
+      depth++;
+    } else if (token.isPunct(')') || token.isPunct('}') || token.is(Lexer::Token::Type::TEMPLATE_CLOSE)) {
+      if (depth == 0) {
+        pushElement(position);
+        return token.isPunct('}');
+      }
+      depth--;
+    } else if (depth == 0 && token.isPunct(',')) {
+      pushElement(position);
+      continue;
+    }
+    hasCode = true;
+  }
+  return false;
 }
-void Configuration::replaceStyles(const std::string& styleName, const std::string& styleFill, EditorWindow* editor) {
-  std::string styleCheck;
-  for (PresetsPage::PresetConfig& preset : editor->bladesPage->bladeArrayDlg->bladeArrays[editor->bladesPage->bladeArray->entry()->GetSelection()].presets) {
-    for (wxString& style : preset.styles) {
-          styleCheck = (style.find(styleName) == std::string::npos) ? style.ToStdString() : style.substr(style.find(styleName)).ToStdString();
-      while (styleCheck != style) {
-        // If there are no comments in the style, we're fine.
-        // if the start of the next comment comes before the end of a comment, we *should* be outside the comment, and we're good to go.
-        // This potentially could be broken though...
-        if (style.find("/*") == std::string::npos || styleCheck.find("/*") <= styleCheck.find("*/")) {
-          style.replace(style.find(styleCheck), styleName.length(), styleFill);
-        }
-        styleCheck = styleCheck.find(styleName) == std::string::npos ? style.ToStdString() : style.substr(styleCheck.find(styleName)).ToStdString();
+Configuration::TokenRanges Configuration::templateArgs(const Lexer& lexer, size_t begin, size_t end) {
+  const auto& tokens = lexer.getTokens();
+  TokenRanges args;
+  int32_t depth{0};
+  bool open{false};
+  size_t argBegin{0};
+
+  for (auto index = begin; index < end && index < tokens.size(); index++) {
+    const auto& token = tokens.at(index);
+    if (token.type == Lexer::Token::Type::COMMENT) continue;
+    if (!open) {
+      if (token.type == Lexer::Token::Type::TEMPLATE_OPEN) {
+        open = true;
+        argBegin = index + 1;
+      }
+      continue;
+    }
+
+    if (token.isPunct('(') || token.isPunct('{') || token.is(Lexer::Token::Type::TEMPLATE_OPEN)) {
+      depth++;
+    } else if (token.isPunct(')') || token.isPunct('}') || token.is(Lexer::Token::Type::TEMPLATE_CLOSE)) {
+      if (depth == 0) {
+        if (index > argBegin) args.emplace_back(argBegin, index);
+        return args;
       }
+      depth--;
+    } else if (depth == 0 && token.isPunct(',')) {
+      args.emplace_back(argBegin, index);
+      argBegin = index + 1;
     }
   }
+  return args;
 }
+std::string Configuration::codeText(const Lexer& lexer, size_t begin, size_t end) {
+  const auto& tokens = lexer.getTokens();
+  if (end > tokens.size()) end = tokens.size();
+  while (begin < end && tokens.at(begin).type == Lexer::Token::Type::COMMENT) begin++;
+  while (end > begin && tokens.at(end - 1).type == Lexer::Token::Type::COMMENT) end--;
+  if (begin == end) return {};
+
+  std::string text;
+  auto copyFrom = tokens.at(begin).offset;
+  for (auto index = begin; index < end; index++) {
+    if (tokens.at(index).type != Lexer::Token::Type::COMMENT) continue;
+    text.append(lexer.slice(copyFrom, tokens.at(index).offset));
+    copyFrom = tokens.at(index).end();
+  }
+  text.append(lexer.slice(copyFrom, tokens.at(end - 1).end()));
+  return text;
+}
+
+# define FAIL(msg) \
+  error = msg; \
+  return false;
 
-bool Configuration::runPreChecks(EditorWindow* editor) {
-  if (editor->bladesPage->bladeArrayDlg->enableDetect->GetValue() && editor->bladesPage->bladeArrayDlg->detectPin->entry()->GetValue() == "") {
-    ERR("Blade Detect Pin cannot be empty.");
+bool Configuration::runPreChecks(const ConfigModel& config, std::string& error) {
+  const auto& awareness{config.bladeAwareness};
+  // e.g. a CONFIG_PRESETS section without any Preset arrays; everything below assumes one
+  if (config.bladeArrays.empty()) {
+    FAIL("Config must have at least one Blade Array.");
+  }
+  if (awareness.enableDetect && awareness.detectPin.empty()) {
+    FAIL("Blade Detect Pin cannot be empty.");
   }
-  if (editor->bladesPage->bladeArrayDlg->enableID->GetValue() && editor->bladesPage->bladeArrayDlg->IDPin->entry()->GetValue() == "") {
-    ERR("Blade ID Pin cannot be empty.");
+  if (awareness.enableID && awareness.IDPin.empty()) {
+    FAIL("Blade ID Pin cannot be empty.");
   }
-  if ([&]() { for (const BladeArrayDlg::BladeArray& array : editor->bladesPage->bladeArrayDlg->bladeArrays) if (array.name == "") return true; return false; }()) {
-    ERR("Blade Array Name cannot be empty.");
+  if ([&]() { for (const ConfigModel::BladeArray& array : config.bladeArrays) if (array.name == "") return true; return false; }()) {
+    FAIL("Blade Array Name cannot be empty.");
   }
-  if (editor->bladesPage->bladeArrayDlg->enableID->GetValue() && editor->bladesPage->bladeArrayDlg->mode->entry()->GetStringSelection() == BLADE_ID_MODE_BRIDGED && editor->bladesPage->bladeArrayDlg->pullupPin->entry()->GetValue() == "") {
-    ERR("Pullup Pin cannot be empty.");
+  if (awareness.enableID && awareness.mode == BLADE_ID_MODE_BRIDGED && awareness.pullupPin.empty()) {
+    FAIL("Pullup Pin cannot be empty.");
   }
-  if (editor->bladesPage->bladeArrayDlg->enableDetect->GetValue() && editor->bladesPage->bladeArrayDlg->enableID->GetValue() && editor->bladesPage->bladeArrayDlg->IDPin->entry()->GetValue() == editor->bladesPage->bladeArrayDlg->detectPin->entry()->GetValue()) {
-    ERR("Blade ID Pin and Blade Detect Pin cannot be the same.");
+  if (awareness.enableDetect && awareness.enableID && awareness.IDPin == awareness.detectPin) {
+    FAIL("Blade ID Pin and Blade Detect Pin cannot be the same.");
   }
   if ([&]() -> bool {
-        auto getNumBlades = [](const BladeArrayDlg::BladeArray& array) {
+        auto getNumBlades = [](const ConfigModel::BladeArray& array) {
           int32_t numBlades = 0;
-          for (const BladesPage::BladeConfig& blade : array.blades) {
+          for (const ConfigModel::Blade& blade : array.blades) {
             blade.isSubBlade ? numBlades += blade.subBlades.size() : numBlades++;
           }
           return numBlades;
         };
 
-        int32_t lastNumBlades = getNumBlades(editor->bladesPage->bladeArrayDlg->bladeArrays.at(0));
-        for (const BladeArrayDlg::BladeArray& array : editor->bladesPage->bladeArrayDlg->bladeArrays) {
+        int32_t lastNumBlades = getNumBlades(config.bladeArrays.at(0));
+        for (const ConfigModel::BladeArray& array : config.bladeArrays) {
           if (getNumBlades(array) != lastNumBlades) return true;
           lastNumBlades = getNumBlades(array);
         }
         return false;
       }()) {
-    ERR("All Blade Arrays must be the same length.\n\nPlease add/remove blades to make them equal");
+    FAIL("All Blade Arrays must be the same length.\n\nPlease add/remove blades to make them equal");
   }
 
-  for (auto& bladeArray : editor->bladesPage->bladeArrayDlg->bladeArrays) {
+  for (auto& bladeArray : config.bladeArrays) {
       for (uint32_t idx = 0; idx < bladeArray.blades.size(); idx++) {
           if (bladeArray.blades.at(idx).type == BD_QUADSTAR && bladeArray.blades.at(idx).powerPins.size() != 4) {
-              ERR(BD_QUADSTAR " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 4 power pins selected.");
+              FAIL(BD_QUADSTAR " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 4 power pins selected.");
           }
           if (bladeArray.blades.at(idx).type == BD_TRISTAR && bladeArray.blades.at(idx).powerPins.size() != 3) {
-              ERR(BD_TRISTAR " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 3 power pins selected.");
+              FAIL(BD_TRISTAR " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 3 power pins selected.");
           }
           if (bladeArray.blades.at(idx).type == BD_SINGLELED && bladeArray.blades.at(idx).powerPins.size() != 1) {
-              ERR(BD_SINGLELED " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 1 power pin selected.");
+              FAIL(BD_SINGLELED " blade " + std::to_string(idx) + " in array \"" + bladeArray.name.ToStdString() + "\" should have 1 power pin selected.");
           }
       }
       for (auto& preset : bladeArray.presets) {
           for (auto& style : preset.styles) {
-              auto styleBegin = style.find("Style");
-              auto styleEnd = style.find("()");
-              if (styleBegin == std::string::npos || styleEnd == std::string::npos || styleBegin > styleEnd) {
-                  if (style == "&style_pov" || style == "&style_charging") continue;
-                  ERR("Malformed bladestyle in preset \"" + preset.name.ToStdString() + "\" in blade array \"" + bladeArray.name.ToStdString() + "\"");
+              StyleTree tree;
+              if (!tree.parse(style.ToStdString())) {
+                  FAIL("Malformed bladestyle in preset \"" + preset.name.ToStdString() + "\" in blade array \"" + bladeArray.name.ToStdString() + "\":\n" + tree.getError());
+              }
+              if (!tree.isStyle()) {
+                  FAIL("Malformed bladestyle in preset \"" + preset.name.ToStdString() + "\" in blade array \"" + bladeArray.name.ToStdString() + "\"");
               }
           }
       }
@@ -754,6 +804,7 @@ bool Configuration::runPreChecks(EditorWindow* editor) {
 
   return true;
 }
+# undef FAIL
 
 const Configuration::MapPair& Configuration::findInVMap(const Configuration::VMap& map, const std::string& search) {
   return *std::find_if(map.begin(), map.end(), [&](const MapPair& pair) { return (pair.second == search || pair.first == search); });
@@ -3,11 +3,13 @@
 
 #pragma once
 
-#include "editor/pages/bladespage.h"
+#include "core/config/configmodel.h"
 #include "editor/editorwindow.h"
+#include "core/utilities/bufferedwriter.h"
+#include "core/utilities/lexer.h"
 
 #include <string>
-#include <fstream>
+#include <unordered_map>
 #include <wx/spinctrl.h>
 #include <wx/checkbox.h>
 #include <wx/radiobut.h>
@@ -22,6 +24,11 @@ public:
   static bool readConfig(const std::string&, EditorWindow* editorWindow);
   static bool importConfig(EditorWindow* editorWindow);
 
+  // Model-only versions, these don't need any UI.
+  static bool outputConfig(const std::string&, const ConfigModel&, std::string& error);
+  static bool readConfig(const std::string&, ConfigModel&, std::string& error);
+  static bool runPreChecks(const ConfigModel&, std::string& error);
+
   typedef std::pair<const std::string, const std::string> MapPair;
   typedef std::vector<MapPair> VMap;
   static const MapPair& findInVMap(const VMap&, const std::string& search);
@@ -44,31 +51,36 @@ private:
   Configuration();
   Configuration(const Configuration&) = delete;
 
-  static bool runPreChecks(EditorWindow*);
+  static void outputConfigTop(BufferedWriter&, const ConfigModel&);
+  static void outputConfigTopGeneral(BufferedWriter&, const ConfigModel&);
+  static void outputConfigTopCustom(BufferedWriter&, const ConfigModel&);
+  static void outputConfigTopPropSpecific(BufferedWriter&, const ConfigModel&);
+  static void outputConfigProp(BufferedWriter&, const ConfigModel&);
+  static void outputConfigPresets(BufferedWriter&, const ConfigModel&);
+  static void outputConfigPresetsStyles(BufferedWriter&, const ConfigModel&);
+  static void outputConfigPresetsBlades(BufferedWriter&, const ConfigModel&);
+  static void genWS281X(BufferedWriter&, const ConfigModel::Blade&);
+  static void genSubBlades(BufferedWriter&, const ConfigModel::Blade&);
+  static void outputConfigButtons(BufferedWriter&, const ConfigModel&);
+
+  typedef std::pair<size_t, size_t> TokenRange;
+  typedef std::vector<TokenRange> TokenRanges;
+
+  static void readConfigTop(Lexer::Stream&, ConfigModel&, std::vector<std::string>& defines);
+  static void readConfigProp(Lexer::Stream&, ConfigModel&);
+  static void readConfigPresets(Lexer::Stream&, ConfigModel&);
+  typedef std::unordered_map<std::string, std::string> StyleAliases;
 
-  static void outputConfigTop(std::ofstream&, EditorWindow*);
-  static void outputConfigTopGeneral(std::ofstream&, EditorWindow*);
-  static void outputConfigTopCustom(std::ofstream&, EditorWindow*);
-  static void outputConfigTopBladeAwareness(std::ofstream&, EditorWindow*);
-  static void outputConfigTopPropSpecific(std::ofstream&, EditorWindow*);
-  static void outputConfigTopSA22C(std::ofstream&, EditorWindow*);
-  static void outputConfigTopFett263(std::ofstream&, EditorWindow*);
-  static void outputConfigTopBC(std::ofstream&, EditorWindow*);
-  static void outputConfigTopCaiwyn(std::ofstream&, EditorWindow*);
-  static void outputConfigProp(std::ofstream&, EditorWindow*);
-  static void outputConfigPresets(std::ofstream&, EditorWindow*);
-  static void outputConfigPresetsStyles(std::ofstream&, EditorWindow*);
-  static void outputConfigPresetsBlades(std::ofstream&, EditorWindow*);
-  static void genWS281X(std::ofstream&, const BladesPage::BladeConfig&);
-  static void genSubBlades(std::ofstream&, const BladesPage::BladeConfig&);
-  static void outputConfigButtons(std::ofstream&, EditorWindow*);
+  static void readConfigStyles(Lexer::Stream&, StyleAliases&);
+  static void expandStyleAliases(const StyleAliases&, ConfigModel&);
+  static void readPresetArray(Lexer::Stream&, ConfigModel&);
+  static void readBladeArray(Lexer::Stream&, ConfigModel&);
+  static void setCustomDefines(const std::vector<std::string>& defines, ConfigModel&);
 
-  static void readConfigTop(std::ifstream&, EditorWindow*);
-  static void readConfigProp(std::ifstream&, EditorWindow*);
-  static void readConfigPresets(std::ifstream&, EditorWindow*);
-  static void readConfigStyles(std::ifstream&, EditorWindow*);
-  static void replaceStyles(const std::string&, const std::string&, EditorWindow*);
-  static void readPresetArray(std::ifstream&, EditorWindow*);
-  static void readBladeArray(std::ifstream&, EditorWindow*);
-  static void setCustomDefines(EditorWindow* editor);
+  // Returns true on the #endif closing the current section, tracking nested #if's in depth.
+  static bool endOfSection(const Lexer::Token&, int32_t& depth);
+  // Splits a brace initializer (stream positioned after the opening brace) into its top-level elements.
+  static bool readInitializer(Lexer::Stream&, TokenRanges&, std::string* comments = nullptr);
+  static TokenRanges templateArgs(const Lexer&, size_t begin, size_t end);
+  static std::string codeText(const Lexer&, size_t begin, size_t end);
 };
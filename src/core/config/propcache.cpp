@@ -0,0 +1,304 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "core/config/propcache.h"
+
+#include "core/defines.h"
+#include "core/utilities/bufferedwriter.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#define PROPCACHE_MAGIC "PCPD"
+// Bump whenever PropFile::Definition or the parsing that fills it changes
+#define PROPCACHE_VERSION 3
+
+namespace PropCache {
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    int64_t mtime;
+    uint64_t size;
+    uint64_t hash;
+  };
+
+  class Writer {
+  public:
+    template<typename T>
+    void put(const T& value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void put(const std::string& str) {
+      put<uint32_t>(str.size());
+      data.append(str);
+    }
+    void put(const std::vector<std::string>& strings) {
+      put<uint32_t>(strings.size());
+      for (const auto& str : strings) put(str);
+    }
+
+    std::string data;
+  };
+
+  class Reader {
+  public:
+    Reader(const std::string& data) : pos(data.data()), end(data.data() + data.size()) {}
+
+    template<typename T>
+    bool get(T& value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      if (static_cast<size_t>(end - pos) < sizeof(T)) return ok = false;
+      std::memcpy(&value, pos, sizeof(T));
+      pos += sizeof(T);
+      return true;
+    }
+    bool get(std::string& str) {
+      uint32_t size{0};
+      if (!get(size) || static_cast<size_t>(end - pos) < size) return ok = false;
+      str.assign(pos, size);
+      pos += size;
+      return true;
+    }
+    bool get(std::vector<std::string>& strings) {
+      uint32_t count{0};
+      if (!getCount(count)) return false;
+      strings.resize(count);
+      for (auto& str : strings) if (!get(str)) return false;
+      return true;
+    }
+    // Every element takes at least a byte, so this catches garbage counts before allocating
+    bool getCount(uint32_t& count) {
+      if (!get(count) || static_cast<size_t>(end - pos) < count) return ok = false;
+      return true;
+    }
+    bool atEnd() const { return pos == end; }
+
+    bool ok{true};
+
+  private:
+    const char* pos;
+    const char* end;
+  };
+
+  std::string getPath(const std::string& pconfPath);
+  uint64_t hash(const std::string&);
+  bool readFile(const std::string& path, std::string& contents);
+
+  void putNode(Writer&, const FileParse::Node&);
+  bool getNode(Reader&, FileParse::Node&);
+  void putDefinition(Writer&, const PropFile::Definition&);
+  bool getDefinition(Reader&, PropFile::Definition&);
+}
+
+bool PropCache::load(const std::string& pconfPath, PropFile::Definition& definition) {
+  std::string cache;
+  if (!readFile(getPath(pconfPath), cache)) return false;
+
+  Reader reader(cache);
+  Header header;
+  if (
+      !reader.get(header) ||
+      std::memcmp(header.magic, PROPCACHE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != PROPCACHE_VERSION
+     ) return false;
+
+  std::string version;
+  if (!reader.get(version) || version != VERSION) return false;
+
+  const int64_t mtime{wxFileModificationTime(pconfPath)};
+  const uint64_t size{static_cast<uint64_t>(wxFileName::GetSize(pconfPath).GetValue())};
+  bool touched{false};
+  if (mtime != header.mtime || size != header.size) {
+    // Copied or touched files keep their cache as long as the contents are the same
+    std::string contents;
+    if (!readFile(pconfPath, contents) || hash(contents) != header.hash) return false;
+    touched = true;
+  }
+
+  if (!getDefinition(reader, definition) || !reader.atEnd()) {
+    definition = PropFile::Definition{};
+    return false;
+  }
+
+  if (touched) store(pconfPath, definition);
+  return true;
+}
+
+void PropCache::store(const std::string& pconfPath, const PropFile::Definition& definition) {
+  std::string contents;
+  if (!readFile(pconfPath, contents)) return;
+
+  Header header;
+  std::memcpy(header.magic, PROPCACHE_MAGIC, sizeof(header.magic));
+  header.version = PROPCACHE_VERSION;
+  header.mtime = wxFileModificationTime(pconfPath);
+  header.size = contents.size();
+  header.hash = hash(contents);
+
+  Writer writer;
+  writer.put(header);
+  writer.put(std::string(VERSION));
+  putDefinition(writer, definition);
+
+  if (!wxDirExists(PROPCACHE_DIR)) wxFileName::Mkdir(PROPCACHE_DIR, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+  BufferedWriter output;
+  output << writer.data;
+  // Not fatal, it'll just be parsed again next time
+  if (!output.commit(getPath(pconfPath))) std::cerr << "Could not write prop cache for \"" << pconfPath << "\"." << std::endl;
+}
+
+std::string PropCache::getPath(const std::string& pconfPath) {
+  return PROPCACHE_DIR + wxFileName(pconfPath).GetName().ToStdString() + ".bin";
+}
+uint64_t PropCache::hash(const std::string& data) {
+  // FNV-1a
+  uint64_t state{0xcbf29ce484222325};
+  for (const char chr : data) {
+    state ^= static_cast<uint8_t>(chr);
+    state *= 0x100000001b3;
+  }
+  return state;
+}
+bool PropCache::readFile(const std::string& path, std::string& contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+void PropCache::putNode(Writer& writer, const FileParse::Node& node) {
+  writer.put(node.name);
+  writer.put(node.label);
+  writer.put(node.value);
+  writer.put(node.text);
+  writer.put(node.line);
+  writer.put(node.isSection);
+  writer.put<uint32_t>(node.children.size());
+  for (const auto& child : node.children) putNode(writer, child);
+}
+bool PropCache::getNode(Reader& reader, FileParse::Node& node) {
+  uint32_t numChildren{0};
+  reader.get(node.name);
+  reader.get(node.label);
+  reader.get(node.value);
+  reader.get(node.text);
+  reader.get(node.line);
+  reader.get(node.isSection);
+  if (!reader.ok || !reader.getCount(numChildren)) return false;
+
+  node.children.resize(numChildren);
+  for (auto& child : node.children) if (!getNode(reader, child)) return false;
+  return true;
+}
+
+void PropCache::putDefinition(Writer& writer, const PropFile::Definition& definition) {
+  writer.put(definition.name);
+  writer.put(definition.fileName);
+  writer.put(definition.info);
+
+  writer.put<uint32_t>(definition.settings.size());
+  for (const auto& [ key, setting ] : definition.settings) {
+    writer.put(key);
+    writer.put(setting.name);
+    writer.put(setting.define);
+    writer.put(setting.description);
+    writer.put(setting.required);
+    writer.put(setting.requiredAny);
+    writer.put(setting.disables);
+    writer.put(setting.min);
+    writer.put(setting.max);
+    writer.put(setting.increment);
+    writer.put(setting.defaultVal);
+    writer.put(setting.others);
+    writer.put(setting.isDefault);
+    writer.put(setting.shouldOutput);
+    writer.put(static_cast<uint8_t>(setting.type));
+  }
+
+  putNode(writer, definition.layout);
+
+  for (const auto& buttonArray : definition.buttons) {
+    writer.put<uint32_t>(buttonArray.size());
+    for (const auto& [ state, buttons ] : buttonArray) {
+      writer.put(state);
+      writer.put<uint32_t>(buttons.size());
+      for (const auto& button : buttons) {
+        writer.put(button.name);
+        writer.put(button.relevantSettings);
+        writer.put<uint32_t>(button.descriptions.size());
+        for (const auto& [ predicates, description ] : button.descriptions) {
+          writer.put<uint64_t>(predicates);
+          writer.put(description);
+        }
+      }
+    }
+  }
+}
+bool PropCache::getDefinition(Reader& reader, PropFile::Definition& definition) {
+  reader.get(definition.name);
+  reader.get(definition.fileName);
+  reader.get(definition.info);
+
+  uint32_t numSettings{0};
+  if (!reader.getCount(numSettings)) return false;
+  for (uint32_t idx = 0; idx < numSettings; idx++) {
+    std::string key;
+    PropFile::Setting setting;
+    uint8_t type{0};
+    reader.get(key);
+    reader.get(setting.name);
+    reader.get(setting.define);
+    reader.get(setting.description);
+    reader.get(setting.required);
+    reader.get(setting.requiredAny);
+    reader.get(setting.disables);
+    reader.get(setting.min);
+    reader.get(setting.max);
+    reader.get(setting.increment);
+    reader.get(setting.defaultVal);
+    reader.get(setting.others);
+    reader.get(setting.isDefault);
+    reader.get(setting.shouldOutput);
+    reader.get(type);
+    if (!reader.ok || type > static_cast<uint8_t>(PropFile::Setting::SettingType::DECIMAL)) return false;
+    setting.type = static_cast<PropFile::Setting::SettingType>(type);
+    definition.settings.emplace(std::move(key), std::move(setting));
+  }
+
+  if (!getNode(reader, definition.layout)) return false;
+
+  for (auto& buttonArray : definition.buttons) {
+    uint32_t numStates{0};
+    if (!reader.getCount(numStates)) return false;
+    buttonArray.resize(numStates);
+    for (auto& [ state, buttons ] : buttonArray) {
+      uint32_t numButtons{0};
+      reader.get(state);
+      if (!reader.getCount(numButtons)) return false;
+      buttons.resize(numButtons);
+      for (auto& button : buttons) {
+        uint32_t numDescriptions{0};
+        reader.get(button.name);
+        reader.get(button.relevantSettings);
+        if (!reader.getCount(numDescriptions)) return false;
+        for (uint32_t idx = 0; idx < numDescriptions; idx++) {
+          uint64_t predicates{0};
+          std::string description;
+          reader.get(predicates);
+          reader.get(description);
+          if (!reader.ok) return false;
+          button.descriptions.emplace(predicates, std::move(description));
+        }
+      }
+    }
+  }
+
+  return reader.ok;
+}
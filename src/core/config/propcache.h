@@ -0,0 +1,16 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include "core/config/propfile.h"
+
+#include <string>
+
+// Parsed prop configs in a compact binary form, so opening an editor doesn't
+// have to parse every .pconf again. An entry is used if the .pconf's mtime and
+// size match, or failing that, if its contents still hash the same.
+namespace PropCache {
+  [[nodiscard]] bool load(const std::string& pconfPath, PropFile::Definition&);
+  void store(const std::string& pconfPath, const PropFile::Definition&);
+} // namespace PropCache
@@ -4,43 +4,87 @@
 #include "core/config/propfile.h"
 
 #include "core/defines.h"
+#include "core/config/propcache.h"
 #include "core/utilities/fileparse.h"
 #include "ui/pcspinctrl.h"
 #include "ui/pcspinctrldouble.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <unordered_set>
 #include <wx/tooltip.h>
 #include <wx/statbox.h>
 
-PropFile::PropFile(wxWindow* parent) : wxPanel(parent, wxID_ANY) {
-  settings = new SettingMap;
-  buttons = new std::array<ButtonArray, 4>;
+PropFile::PropFile(wxWindow* parent, std::shared_ptr<const Definition> _definition) : wxPanel(parent, wxID_ANY), definition(std::move(_definition)) {
+  auto numSettings{definition->settings.size()};
+  states.resize(numSettings, nullptr);
+  active.resize(numSettings, false);
+  numDisabling.resize(numSettings, 0);
+  numRequiredActive.resize(numSettings, 0);
+
+  for (const auto& [ key, setting ] : definition->settings) {
+    auto& state{settings.emplace(key, setting).first->second};
+    states.at(setting.id) = &state;
+  }
+  updateDependencies();
+}
+PropFile::SettingState::SettingState(const Setting& _setting) : setting(_setting) {
+  switch (setting.type) {
+    case Setting::SettingType::TOGGLE:
+    case Setting::SettingType::OPTION:
+      value = setting.isDefault;
+      break;
+    case Setting::SettingType::NUMERIC:
+    case Setting::SettingType::DECIMAL:
+      value = setting.defaultVal;
+      break;
+  }
 }
-PropFile::~PropFile() {
-  delete settings;
-  delete buttons;
+PropFile::~PropFile() {}
+
+void PropFile::buildLayout() {
+  if (sizer != nullptr) return;
+
+  readLayout(definition->layout);
+  updateDependencies();
 }
 
-std::string PropFile::getName() const { return name; }
-std::string PropFile::getFileName() const { return fileName; }
-std::string PropFile::getInfo() const { return info; }
-std::string PropFile::Setting::getOutput() const {
-  switch (type) {
-    case SettingType::TOGGLE:
-      return static_cast<wxCheckBox*>(control)->GetValue() ? define : "";
-    case SettingType::OPTION:
-      return static_cast<wxRadioButton*>(control)->GetValue() ? define : "";
-    case SettingType::NUMERIC:
-      return define + " " + std::to_string(static_cast<pcSpinCtrl*>(control)->entry()->GetValue());
-    case SettingType::DECIMAL:
-      return define + " " + std::to_string(static_cast<pcSpinCtrlDouble*>(control)->entry()->GetValue());
+std::string PropFile::getName() const { return definition->name; }
+std::string PropFile::getFileName() const { return definition->fileName; }
+std::string PropFile::getInfo() const { return definition->info; }
+std::string PropFile::SettingState::getOutput() const {
+  if (control == nullptr) {
+    switch (setting.type) {
+      case Setting::SettingType::TOGGLE:
+      case Setting::SettingType::OPTION:
+        return value ? setting.define : "";
+      case Setting::SettingType::NUMERIC:
+        return setting.define + " " + std::to_string(static_cast<int32_t>(value));
+      case Setting::SettingType::DECIMAL:
+        return setting.define + " " + std::to_string(value);
+    }
+  }
+
+  switch (setting.type) {
+    case Setting::SettingType::TOGGLE:
+      return static_cast<wxCheckBox*>(control)->GetValue() ? setting.define : "";
+    case Setting::SettingType::OPTION:
+      return static_cast<wxRadioButton*>(control)->GetValue() ? setting.define : "";
+    case Setting::SettingType::NUMERIC:
+      return setting.define + " " + std::to_string(static_cast<pcSpinCtrl*>(control)->entry()->GetValue());
+    case Setting::SettingType::DECIMAL:
+      return setting.define + " " + std::to_string(static_cast<pcSpinCtrlDouble*>(control)->entry()->GetValue());
   }
 
   return {};
 }
-void PropFile::Setting::enable(bool enable) const {
-  switch(type) {
+void PropFile::SettingState::enable(bool enable) const {
+  if (control == nullptr) return;
+
+  switch(setting.type) {
     case PropFile::Setting::SettingType::TOGGLE:
       static_cast<wxCheckBox*>(control)->Enable(enable);
       break;
@@ -56,111 +100,188 @@ void PropFile::Setting::enable(bool enable) const {
 
   }
 }
-void PropFile::Setting::setValue(double value) const {
-  switch (type) {
-    case SettingType::TOGGLE:
+void PropFile::SettingState::setValue(double _value) {
+  value = _value;
+  if (control == nullptr) return;
+
+  switch (setting.type) {
+    case Setting::SettingType::TOGGLE:
       static_cast<wxCheckBox*>(control)->SetValue(value);
       break;
-    case SettingType::OPTION:
-      static_cast<wxRadioButton*>(control)->SetValue(value);
+    case Setting::SettingType::OPTION:
+      // Radio buttons can only be selected, selecting one clears the rest of the group
+      if (value) static_cast<wxRadioButton*>(control)->SetValue(true);
       break;
-    case SettingType::NUMERIC:
+    case Setting::SettingType::NUMERIC:
       static_cast<pcSpinCtrl*>(control)->entry()->SetValue(value);
       break;
-    case SettingType::DECIMAL:
+    case Setting::SettingType::DECIMAL:
       static_cast<pcSpinCtrlDouble*>(control)->entry()->SetValue(value);
       break;
   }
 }
-PropFile::SettingMap* PropFile::getSettings() { return settings; }
-const std::array<PropFile::ButtonArray, 4>* PropFile::getButtons() { return buttons; }
-bool PropFile::Setting::checkRequiredSatisfied(const std::unordered_map<std::string, Setting>& settings) const {
-  if (!requiredAny.empty()) {
-    for (const auto& require : requiredAny) {
-      auto key = settings.find(require);
-      if (key == settings.end()) continue;
-      if (!key->second.getOutput().empty()) return true;
-    }
+PropFile::StateMap* PropFile::getSettings() { return &settings; }
+const std::array<PropFile::ButtonArray, 4>* PropFile::getButtons() { return &definition->buttons; }
+bool PropFile::SettingState::isSet() const {
+  switch (setting.type) {
+    case Setting::SettingType::TOGGLE:
+      return control ? static_cast<wxCheckBox*>(control)->GetValue() : value;
+    case Setting::SettingType::OPTION:
+      return control ? static_cast<wxRadioButton*>(control)->GetValue() : value;
+    case Setting::SettingType::NUMERIC:
+    case Setting::SettingType::DECIMAL:
+      return true;
+  }
 
-    return false;
-  } else {
-    for (const auto& require : required) {
-      auto key = settings.find(require);
-      if (key == settings.end()) return false;
-      if (key->second.getOutput().empty()) return false;
-    }
+  return false;
+}
 
-    return true;
+void PropFile::updateDependencies() {
+  std::fill(numDisabling.begin(), numDisabling.end(), 0);
+  std::fill(numRequiredActive.begin(), numRequiredActive.end(), 0);
+
+  const auto& dependencies{definition->dependencies};
+  for (uint32_t id = 0; id < states.size(); id++) {
+    active[id] = states[id]->isSet();
+    if (!active[id]) continue;
+
+    for (auto disable : dependencies.disables[id]) numDisabling[disable]++;
+    for (auto dependent : dependencies.requiredBy[id]) numRequiredActive[dependent]++;
+  }
+
+  for (uint32_t id = 0; id < states.size(); id++) {
+    states[id]->enable(isEnabled(id));
   }
 }
+void PropFile::settingChanged(const void* control) {
+  auto idIt = controlIDs.find(control);
+  if (idIt == controlIDs.end()) return;
+
+  std::vector<uint32_t> affected;
+  propagate(idIt->second, affected);
+  // Selecting an option silently deselects the rest of its group
+  for (auto other : definition->dependencies.group[idIt->second]) propagate(other, affected);
+
+  for (auto id : affected) states[id]->enable(isEnabled(id));
+}
+void PropFile::propagate(uint32_t id, std::vector<uint32_t>& affected) {
+  bool isActive{states[id]->isSet()};
+  if (isActive == active[id]) return;
+  active[id] = isActive;
+
+  const auto& dependencies{definition->dependencies};
+  for (auto disable : dependencies.disables[id]) {
+    isActive ? numDisabling[disable]++ : numDisabling[disable]--;
+    affected.push_back(disable);
+  }
+  for (auto dependent : dependencies.requiredBy[id]) {
+    isActive ? numRequiredActive[dependent]++ : numRequiredActive[dependent]--;
+    affected.push_back(dependent);
+  }
+}
+bool PropFile::isEnabled(const SettingState& state) const { return isEnabled(state.setting.id); }
+bool PropFile::isEnabled(uint32_t id) const {
+  const auto& dependencies{definition->dependencies};
+  if (numDisabling[id]) return false;
+  if (dependencies.requireAny[id]) return numRequiredActive[id] > 0;
+  return !dependencies.requireMissing[id] && numRequiredActive[id] == dependencies.numRequired[id];
+}
 
 
 PropFile* PropFile::createPropConfig(const std::string& name, wxWindow* _parent) {
+  auto definition = getDefinition(name);
+  if (!definition) return nullptr;
+
+  // Controls aren't made until the prop is first selected, see buildLayout()
+  auto prop = new PropFile(_parent, std::move(definition));
+  prop->Show(false);
+
+  return prop;
+}
+std::shared_ptr<const PropFile::Definition> PropFile::getDefinition(const std::string& name) {
+  // Only held weakly here, so it's freed once the last editor using it is gone
+  static std::unordered_map<std::string, std::weak_ptr<const Definition>> definitions;
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+
+  if (auto existing = definitions[name].lock()) return existing;
+
   std::cout << "Reading prop config: \"" << name << "\"..." << std::endl;
   std::string pathname = PROPCONFIG_DIR + name + ".pconf";
 
-  std::ifstream configFile(pathname);
+  auto definition = std::make_shared<Definition>();
+  if (!PropCache::load(pathname, *definition)) {
+    if (!readDefinition(name, pathname, *definition)) return nullptr;
+    PropCache::store(pathname, *definition);
+  }
+  compileDependencies(*definition);
+  std::cout << "Finished reading prop config." << std::endl;
+
+  definitions[name] = definition;
+  return definition;
+}
+bool PropFile::readDefinition(const std::string& name, const std::string& path, Definition& definition) {
+  std::ifstream configFile(path);
   if (!configFile.is_open()) {
-    error("Could not open prop config file \"" + pathname + "\", aborting...");
-    return nullptr;
+    error("Could not open prop config file \"" + path + "\", aborting...");
+    return false;
   }
 
-  std::vector<std::string> config;
-  std::string temp;
-  while (!configFile.eof()) {
-    getline(configFile, temp);
-    config.push_back(temp.substr(0, temp.find("//")));
+  FileParse::Node config;
+  std::string parseError;
+  if (!FileParse::parseTree(configFile, config, parseError)) {
+    error("Prop config file \"" + name + "\" is malformed (" + parseError + "), aborting...");
+    return false;
   }
   configFile.close();
 
-  auto prop = new PropFile(_parent);
-
-  if (!prop->readName(config)) {
+  if (!readName(config, definition)) {
     error("Prop config file \"" + name + "\" does not have section \"NAME\", aborting...");
-    return nullptr;
+    return false;
   }
-  if (!prop->readFileName(config)) {
+  if (!readFileName(config, definition)) {
     error("Prop config file \"" + name + "\" does not have section \"FILENAME\", aborting...");
-    return nullptr;
+    return false;
   }
-  if (!prop->readInfo(config)) {
-    prop->info = "Prop has no additional info.";
+  if (!readInfo(config, definition)) {
+    definition.info = "Prop has no additional info.";
     warning("Prop config file \"" + name + "\" does not have optional section \"INFO\", skipping...");
   }
-  if (!prop->readSettings(config)) {
+  if (!readSettings(config, definition)) {
     warning("Prop config file \"" + name + "\" does not have optional section \"SETTINGS\", skipping...");
   }
-  if (!prop->readLayout(config)) {
+  if (auto layout = config.find("LAYOUT")) {
+    definition.layout = *layout;
+  } else {
     warning("Prop config file \"" + name + "\" does not have optional section \"LAYOUT\", skipping...");
   }
-  if (!prop->readButtons(config)) {
+  if (!readButtons(config, definition)) {
     warning("Prop config file \"" + name + "\" does not have optional section \"BUTTONS\", skipping...");
   }
+  pruneUnused(definition);
 
-  prop->pruneUnused();
-  prop->Show(false);
-  std::cout << "Finished reading prop config." << std::endl;
-
-  return prop;
+  return true;
 }
 
-bool PropFile::readName(std::vector<std::string>& config) {
-  name = FileParse::parseEntry("NAME", config);
-  if (name.empty()) return false;
+bool PropFile::readName(const FileParse::Node& config, Definition& definition) {
+  definition.name = config.entry("NAME");
+  if (definition.name.empty()) return false;
   return true;
 }
-bool PropFile::readFileName(std::vector<std::string>& config) {
-  fileName = FileParse::parseEntry("FILENAME", config);
-  if (fileName.empty()) return false;
+bool PropFile::readFileName(const FileParse::Node& config, Definition& definition) {
+  definition.fileName = config.entry("FILENAME");
+  if (definition.fileName.empty()) return false;
   return true;
 }
-bool PropFile::readInfo(std::vector<std::string>& config) {
-  auto section = FileParse::extractSection("INFO", config);
-  if (section.empty()) return false;
+bool PropFile::readInfo(const FileParse::Node& config, Definition& definition) {
+  auto& info{definition.info};
+  auto section = config.find("INFO");
+  if (section == nullptr || !section->isSection) return false;
 
   size_t lineBegin;
   size_t lineEnd;
-  for (const auto& line : section) {
+  for (const auto& child : section->children) {
+    const auto& line = child.text;
     lineBegin = line.find("\"");
     lineEnd = line.rfind("\"");
     if (lineBegin == std::string::npos || lineBegin == lineEnd) continue;
@@ -172,205 +293,187 @@ bool PropFile::readInfo(std::vector<std::string>& config) {
 
   return true;
 }
-bool PropFile::readSettings(std::vector<std::string>& config) {
-  std::vector<std::string> settingsSection = FileParse::extractSection("SETTINGS", config);
-  std::vector<std::string> section;
+bool PropFile::readSettings(const FileParse::Node& config, Definition& definition) {
+  auto settingsSection = config.find("SETTINGS");
+  if (settingsSection == nullptr) return false;
   std::vector<std::pair<std::string, Setting>> tempSettings;
 
-  bool read{true};
-  while (read) {
-    read = false;
-    for (auto it = settingsSection.begin(); it < settingsSection.end(); it++) {
-      if (!(section = FileParse::extractSection("TOGGLE", settingsSection)).empty()) {
-        read = true;
-        Setting setting;
-        if (!parseSettingCommon(setting, section)) continue;
-        setting.type = Setting::SettingType::TOGGLE;
-        setting.disables = FileParse::parseListEntry("DISABLE", section);
+  auto readRange = [](Setting& setting, const FileParse::Node& section) {
+    double entry;
+    if ((entry = section.numEntry("MIN")) > 0) setting.min = entry;
+    if ((entry = section.numEntry("MAX")) > 0) setting.max = entry;
+    if ((entry = section.numEntry("INCREMENT")) > 0) setting.increment = entry;
+    if ((entry = section.numEntry("DEFAULT")) > 0) setting.defaultVal = entry;
+  };
 
-        tempSettings.push_back({ setting.define, setting });
-      }
-      if (!(section = FileParse::extractSection("OPTION", settingsSection)).empty()) {
-        read = true;
-        std::vector<std::string> selection;
-        bool isFirst{true};
-
-        while (!(selection = FileParse::extractSection("SELECTION", section)).empty()) {
-          Setting setting;
-          if (!parseSettingCommon(setting, selection)) continue;
-          setting.type = Setting::SettingType::OPTION;
-          if (isFirst) {
-            isFirst = false;
-            setting.isDefault = true;
-          }
-
-          setting.disables = FileParse::parseListEntry("DISABLE", selection);
-          auto outputEntry = FileParse::parseEntry("OUTPUT", selection);
-          setting.shouldOutput = (outputEntry.empty() || outputEntry == "TRUE");
-
-          tempSettings.push_back({setting.define, setting});
-        }
-      }
-      if (!(section = FileParse::extractSection("NUMERIC", settingsSection)).empty()) {
-        read = true;
-        Setting setting;
-        if (!parseSettingCommon(setting, section)) continue;
-        setting.type = Setting::SettingType::NUMERIC;
+  for (const auto& section : settingsSection->children) {
+    if (!section.isSection) continue;
 
-        double entry;
-        if ((entry = FileParse::parseNumEntry("MIN", section)) > 0) setting.min = entry;
-        if ((entry = FileParse::parseNumEntry("MAX", section)) > 0) setting.max = entry;
-        if ((entry = FileParse::parseNumEntry("INCREMENT", section)) > 0) setting.increment = entry;
-        if ((entry = FileParse::parseNumEntry("DEFAULT", section)) > 0) setting.defaultVal = entry;
+    if (section.name == "TOGGLE") {
+      Setting setting;
+      if (!parseSettingCommon(setting, section)) continue;
+      setting.type = Setting::SettingType::TOGGLE;
+      setting.disables = section.listEntry("DISABLE");
+
+      tempSettings.push_back({ setting.define, setting });
+    } else if (section.name == "OPTION") {
+      bool isFirst{true};
+      auto groupStart = tempSettings.size();
+
+      for (const auto& selection : section.children) {
+        if (!selection.isSection || selection.name != "SELECTION") continue;
 
-        tempSettings.push_back({setting.define, setting});
-      }
-      if (!(section = FileParse::extractSection("DECIMAL", settingsSection)).empty()) {
-        read = true;
         Setting setting;
-        if (!parseSettingCommon(setting, section)) continue;
-        setting.type = Setting::SettingType::DECIMAL;
+        if (!parseSettingCommon(setting, selection)) continue;
+        setting.type = Setting::SettingType::OPTION;
+        if (isFirst) {
+          isFirst = false;
+          setting.isDefault = true;
+        }
 
-        double entry;
-        if ((entry = FileParse::parseNumEntry("MIN", section)) > 0) setting.min = entry;
-        if ((entry = FileParse::parseNumEntry("MAX", section)) > 0) setting.max = entry;
-        if ((entry = FileParse::parseNumEntry("INCREMENT", section)) > 0) setting.increment = entry;
-        if ((entry = FileParse::parseNumEntry("DEFAULT", section)) > 0) setting.defaultVal = entry;
+        setting.disables = selection.listEntry("DISABLE");
+        auto outputEntry = selection.entry("OUTPUT");
+        setting.shouldOutput = (outputEntry.empty() || outputEntry == "TRUE");
 
         tempSettings.push_back({setting.define, setting});
       }
+
+      for (auto option = groupStart; option < tempSettings.size(); option++) {
+        for (auto other = groupStart; other < tempSettings.size(); other++) {
+          if (other != option) tempSettings[option].second.others.push_back(tempSettings[other].first);
+        }
+      }
+    } else if (section.name == "NUMERIC") {
+      Setting setting;
+      if (!parseSettingCommon(setting, section)) continue;
+      setting.type = Setting::SettingType::NUMERIC;
+      readRange(setting, section);
+
+      tempSettings.push_back({setting.define, setting});
+    } else if (section.name == "DECIMAL") {
+      Setting setting;
+      if (!parseSettingCommon(setting, section)) continue;
+      setting.type = Setting::SettingType::DECIMAL;
+      readRange(setting, section);
+
+      tempSettings.push_back({setting.define, setting});
+    } else {
+      warning("Unknown settings section \"" + section.name + "\" on line " + std::to_string(section.line) + ", skipping...");
     }
   }
 
-  settings->clear();
-  settings->insert(tempSettings.begin(), tempSettings.end());
+  definition.settings.clear();
+  definition.settings.insert(tempSettings.begin(), tempSettings.end());
 
   return true;
 }
-bool PropFile::parseSettingCommon(Setting& setting, std::vector<std::string>& search) {
-  setting.define = FileParse::parseLabel(search.at(0));
+bool PropFile::parseSettingCommon(Setting& setting, const FileParse::Node& section) {
+  setting.define = section.label;
   std::string toRemove = " ";
   setting.define.erase(std::remove_if(setting.define.begin(), setting.define.end(), [&toRemove](char c) { return toRemove.find(c) != std::string::npos; }), setting.define.end());
   if (setting.define.empty()) {
-    warning("Entry \"" + setting.name + "\" has empty define, skipping...");
+    warning("Entry on line " + std::to_string(section.line) + " has empty define, skipping...");
     return false;
   }
-  search.erase(search.begin()); // Erase label so we don't accidentally read it as the wrong thing later
 
-  setting.name = FileParse::parseEntry("NAME", search);
+  setting.name = section.entry("NAME");
   if (setting.name.empty()) {
-    warning("Skipping entry with no name...");
+    warning("Skipping entry with no name on line " + std::to_string(section.line) + "...");
     return false;
   }
-  setting.description = FileParse::parseEntry("DESCRIPTION", search);
+  setting.description = section.entry("DESCRIPTION");
   size_t nlPos;
   while ((nlPos = setting.description.find("\\n")) != std::string::npos) {
     setting.description.replace(nlPos, 2, "\n");
   }
-  setting.requiredAny = FileParse::parseListEntry("REQUIREANY", search);
-  setting.required = FileParse::parseListEntry("REQUIRE", search);
+  setting.requiredAny = section.listEntry("REQUIREANY");
+  setting.required = section.listEntry("REQUIRE");
 
   return true;
 }
-bool PropFile::readLayout(std::vector<std::string>& config) {
+bool PropFile::readLayout(const FileParse::Node& layout) {
   sizer = new wxBoxSizer(wxVERTICAL);
 
-  auto layoutSection = FileParse::extractSection("LAYOUT", config);
-  parseLayoutSection(layoutSection, sizer, this);
+  parseLayoutSection(layout, sizer, this);
 
   SetSizerAndFit(sizer);
   return true;
 }
-bool PropFile::readButtons(std::vector<std::string>& config) {
-  bool hasButtons{false};
-  for (const auto& line : config) {
-    if (line.find("BUTTONS") != std::string::npos) {
-      hasButtons = true;
-      break;
-    }
-  }
-  if (!hasButtons) return false;
+bool PropFile::readButtons(const FileParse::Node& config, Definition& definition) {
+  if (config.find("BUTTONS") == nullptr) return false;
 
-  parseButtons(config);
+  parseButtons(config, definition);
 
   return true;
 }
-void PropFile::parseButtons(std::vector<std::string>& config) {
-  while (!false) {
-    auto buttonSection = FileParse::extractSection("BUTTONS", config);
-    if (buttonSection.empty()) break;
+void PropFile::parseButtons(const FileParse::Node& config, Definition& definition) {
+  for (const auto& buttonSection : config.children) {
+    if (!buttonSection.isSection || buttonSection.name != "BUTTONS") continue;
 
-    auto numStart = buttonSection.at(0).find("{");
-    auto numEnd = buttonSection.at(0).find("}");
+    auto numStart = buttonSection.text.find("{");
+    auto numEnd = buttonSection.text.find("}");
 
     if (numStart == std::string::npos || numEnd == std::string::npos) {
-      error("Button section missing number indicator, skipping...");
+      error("Button section on line " + std::to_string(buttonSection.line) + " missing number indicator, skipping...");
       continue;
     }
 
-    if (!std::isdigit(buttonSection.at(0).at(numStart + 1))) {
-      error("Button section number indicator malformed, skipping...");
+    if (!std::isdigit(buttonSection.text.at(numStart + 1))) {
+      error("Button section number indicator on line " + std::to_string(buttonSection.line) + " malformed, skipping...");
       continue;
     }
 
-    int32_t numButtons = std::stoi(buttonSection.at(0).substr(numStart + 1));
+    int32_t numButtons = std::stoi(buttonSection.text.substr(numStart + 1));
     if (numButtons < 0 || numButtons > 3) {
       error("Button section number indicator \"" + std::to_string(numButtons) + "\" out of range, skipping...");
       continue;
     }
 
-    buttonSection.erase(buttonSection.begin()); // Prevent BUTTONS from being read as a BUTTON entry
+    for (const auto& stateSection : buttonSection.children) {
+      if (!stateSection.isSection || stateSection.name != "STATE") continue;
 
-    while (!false) {
-      auto stateSection = FileParse::extractSection("STATE", buttonSection);
-      if (stateSection.empty()) break;
-      auto label = FileParse::parseLabel(stateSection.at(0));
-      if (label.empty()) {
-        error("Button array #" + std::to_string(numButtons) + " has unnamed/malformed state, skipping...");
+      if (stateSection.label.empty()) {
+        error("Button array #" + std::to_string(numButtons) + " has unnamed/malformed state on line " + std::to_string(stateSection.line) + ", skipping...");
         continue;
       }
-      buttons->at(numButtons).push_back({label, {}});
+      auto& buttonArray{definition.buttons.at(numButtons)};
+      buttonArray.push_back({stateSection.label, {}});
 
-      parseButtonSection(stateSection, numButtons, buttons->at(numButtons).size() - 1);
+      parseButtonSection(stateSection, buttonArray, buttonArray.size() - 1);
     }
   }
 }
-void PropFile::parseButtonSection(std::vector<std::string>& buttonSection, const int32_t& numButtons, const int32_t& state) {
-  while (!buttonSection.empty()) {
-    if (buttonSection.at(0).find("BUTTON") == std::string::npos) {
-      buttonSection.erase(buttonSection.begin());
-      continue;
-    }
-
-    auto section = FileParse::extractSection("BUTTON", buttonSection);
-    if (section.empty()) continue;
+void PropFile::parseButtonSection(const FileParse::Node& stateSection, ButtonArray& buttonArray, const int32_t& state) {
+  for (const auto& section : stateSection.children) {
+    if (!section.isSection || section.name != "BUTTON") continue;
 
     Button newButton;
-    newButton.name =  FileParse::parseLabel(section.at(0));
+    newButton.name = section.label;
     if (newButton.name.empty()) {
-      error("Button entry has missing name, skipping...");
+      error("Button entry on line " + std::to_string(section.line) + " has missing name, skipping...");
       continue;
     }
 
     parseButtonDescriptions(newButton, section);
-    parseButtonRelevantSettings(newButton);
 
-    buttons->at(numButtons).at(state).second.push_back(newButton);
+    buttonArray.at(state).second.push_back(newButton);
   }
 }
-void PropFile::parseButtonDescriptions(PropFile::Button& newButton, std::vector<std::string>& section) {
-  while (!false) {
-    std::string label;
-    auto description = FileParse::parseEntry("DESCRIPTION", section, label);
-    if (description.empty()) break;
+void PropFile::parseButtonDescriptions(PropFile::Button& newButton, const FileParse::Node& section) {
+  for (const auto& entry : section.children) {
+    if (entry.isSection || entry.name != "DESCRIPTION") continue;
+
+    auto description = FileParse::parseValue(entry);
+    if (description.empty()) continue;
 
+    auto label = entry.label;
     if (label.empty()) {
-      if (newButton.descriptions.find({}) != newButton.descriptions.end()) {
+      if (newButton.descriptions.find(0) != newButton.descriptions.end()) {
         warning("Overriding duplicate default description for button \"" + newButton.name + "\", there should be only one default per button...");
       }
-      newButton.descriptions.insert({{}, description});
+      newButton.descriptions.insert({0, description});
     } else {
-      std::vector<std::string> predicates;
+      uint64_t predicates{0};
 
       // Put back parsed-out quotes
       label.insert(label.begin(), '"');
@@ -379,96 +482,149 @@ void PropFile::parseButtonDescriptions(PropFile::Button& newButton, std::vector<
       while (label.find("\"") != std::string::npos) {
         auto predicateBegin = label.find_first_of("\"");
         auto predicateEnd = label.find_first_of("\"", predicateBegin + 1);
-        predicates.push_back(label.substr(predicateBegin + 1, predicateEnd - predicateBegin - 1));
+        auto predicate = label.substr(predicateBegin + 1, predicateEnd - predicateBegin - 1);
         label.erase(predicateBegin, predicateEnd + 1);
+
+        size_t bit = std::find(newButton.relevantSettings.begin(), newButton.relevantSettings.end(), predicate) - newButton.relevantSettings.begin();
+        if (bit == newButton.relevantSettings.size()) newButton.relevantSettings.push_back(predicate);
+        if (bit >= 64) {
+          warning("Button \"" + newButton.name + "\" has more than 64 relevant settings, skipping description on line " + std::to_string(entry.line) + "...");
+          predicates = 0;
+          break;
+        }
+        predicates |= 1ULL << bit;
       }
-      newButton.descriptions.insert({predicates, description});
+      if (predicates) newButton.descriptions.insert({predicates, description});
     }
   }
 }
-void PropFile::parseButtonRelevantSettings(PropFile::Button& newButton) {
-  for (const auto& [ predicates, description ] : newButton.descriptions) {
-    for (const auto& predicate : predicates) {
-      if ([&predicate, &newButton]() { for (const auto& setting : newButton.relevantSettings) if (setting == predicate) return false; return true; }()) {
-        newButton.relevantSettings.push_back(predicate);
+
+void PropFile::compileDependencies(Definition& definition) {
+  auto& dependencies{definition.dependencies};
+  auto numSettings{definition.settings.size()};
+  dependencies = {};
+  dependencies.disables.resize(numSettings);
+  dependencies.requiredBy.resize(numSettings);
+  dependencies.group.resize(numSettings);
+  dependencies.numRequired.resize(numSettings, 0);
+  dependencies.requireAny.resize(numSettings, false);
+  dependencies.requireMissing.resize(numSettings, false);
+
+  uint32_t nextID{0};
+  for (auto& [ key, setting ] : definition.settings) setting.id = nextID++;
+
+  auto getID = [&definition](const std::string& key) -> int64_t {
+    auto setting = definition.settings.find(key);
+    return setting == definition.settings.end() ? -1 : setting->second.id;
+  };
+  // Duplicate entries would throw off the counts
+  auto addUnique = [](std::vector<uint32_t>& ids, uint32_t id) {
+    if (std::find(ids.begin(), ids.end(), id) != ids.end()) return false;
+    ids.push_back(id);
+    return true;
+  };
+
+  for (const auto& [ key, setting ] : definition.settings) {
+    for (const auto& disable : setting.disables) {
+      auto id = getID(disable);
+      if (id >= 0) addUnique(dependencies.disables[setting.id], id);
+    }
+    for (const auto& other : setting.others) {
+      auto id = getID(other);
+      if (id >= 0) addUnique(dependencies.group[setting.id], id);
+    }
+
+    // REQUIREANY takes precedence, and ignores settings which don't exist
+    dependencies.requireAny[setting.id] = !setting.requiredAny.empty();
+    for (const auto& require : setting.requiredAny.empty() ? setting.required : setting.requiredAny) {
+      auto id = getID(require);
+      if (id < 0) {
+        if (setting.requiredAny.empty()) dependencies.requireMissing[setting.id] = true;
+        continue;
       }
+      if (addUnique(dependencies.requiredBy[id], setting.id)) dependencies.numRequired[setting.id]++;
     }
   }
 }
+void PropFile::pruneUnused(Definition& definition) {
+  std::unordered_set<std::string> used;
+  std::function<void(const FileParse::Node&)> findUsed = [&](const FileParse::Node& section) {
+    for (const auto& child : section.children) {
+      if (child.isSection && (child.name == "HORIZONTAL" || child.name == "VERTICAL")) findUsed(child);
+      else if (child.name == "OPTION") used.insert(child.label);
+    }
+  };
+  findUsed(definition.layout);
 
-void PropFile::pruneUnused() {
-  for (auto setting = settings->begin(); setting != settings->end();) {
-    if (setting->second.control != nullptr) {
+  for (auto setting = definition.settings.begin(); setting != definition.settings.end();) {
+    if (used.find(setting->first) != used.end()) {
       setting++;
       continue;
     }
     warning("Removing unused setting \"" + setting->second.name + "\"...");
-    setting = settings->erase(setting);
+    setting = definition.settings.erase(setting);
   }
 }
 
-bool PropFile::parseLayoutSection(std::vector<std::string>& section, wxSizer* sizer, wxWindow* parent) {
+bool PropFile::parseLayoutSection(const FileParse::Node& section, wxSizer* sizer, wxWindow* parent) {
 # define ITEMBORDER wxSizerFlags(0).Border(wxBOTTOM | wxLEFT | wxRIGHT, 5)
-  auto createToggle = [](Setting& setting, wxWindow* parent, wxSizer* sizer) {
-    setting.control = new wxCheckBox(parent, wxID_ANY, setting.name);
-    static_cast<wxCheckBox*>(setting.control)->SetToolTip(new wxToolTip(setting.description));
-    sizer->Add(static_cast<wxCheckBox*>(setting.control), ITEMBORDER);
+  auto createToggle = [](SettingState& state, wxWindow* parent, wxSizer* sizer) {
+    const auto& setting{state.setting};
+    state.control = new wxCheckBox(parent, wxID_ANY, setting.name);
+    static_cast<wxCheckBox*>(state.control)->SetToolTip(new wxToolTip(setting.description));
+    sizer->Add(static_cast<wxCheckBox*>(state.control), ITEMBORDER);
   };
-  auto createNumeric = [](Setting& setting, wxWindow* parent, wxSizer* sizer) {
+  auto createNumeric = [](SettingState& state, wxWindow* parent, wxSizer* sizer) {
+    const auto& setting{state.setting};
     auto entry = new pcSpinCtrl(parent, wxID_ANY, setting.name, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, setting.min, setting.max, setting.defaultVal);
-    setting.control = entry;
-    static_cast<pcSpinCtrl*>(setting.control)->entry()->SetIncrement(setting.increment);
-    static_cast<pcSpinCtrl*>(setting.control)->SetToolTip(new wxToolTip(setting.description));
+    state.control = entry;
+    static_cast<pcSpinCtrl*>(state.control)->entry()->SetIncrement(setting.increment);
+    static_cast<pcSpinCtrl*>(state.control)->SetToolTip(new wxToolTip(setting.description));
     sizer->Add(entry, ITEMBORDER);
   };
-  auto createDecimal = [](Setting& setting, wxWindow* parent, wxSizer* sizer) {
+  auto createDecimal = [](SettingState& state, wxWindow* parent, wxSizer* sizer) {
+    const auto& setting{state.setting};
     auto entry = new pcSpinCtrlDouble(parent, wxID_ANY, setting.name, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, setting.min, setting.max, setting.defaultVal);
-    setting.control = entry;
-    static_cast<pcSpinCtrlDouble*>(setting.control)->entry()->SetIncrement(setting.increment);
-    static_cast<pcSpinCtrlDouble*>(setting.control)->SetToolTip(new wxToolTip(setting.description));
+    state.control = entry;
+    static_cast<pcSpinCtrlDouble*>(state.control)->entry()->SetIncrement(setting.increment);
+    static_cast<pcSpinCtrlDouble*>(state.control)->SetToolTip(new wxToolTip(setting.description));
     sizer->Add(entry, ITEMBORDER);
   };
-  auto createOption = [](Setting& setting, wxWindow* parent, wxSizer* sizer) {
-    setting.control = new wxRadioButton(parent, wxID_ANY, setting.name);
-    static_cast<wxRadioButton*>(setting.control)->SetToolTip(new wxToolTip(setting.description));
-    sizer->Add(static_cast<wxRadioButton*>(setting.control), ITEMBORDER);
+  auto createOption = [](SettingState& state, wxWindow* parent, wxSizer* sizer) {
+    const auto& setting{state.setting};
+    state.control = new wxRadioButton(parent, wxID_ANY, setting.name);
+    static_cast<wxRadioButton*>(state.control)->SetToolTip(new wxToolTip(setting.description));
+    sizer->Add(static_cast<wxRadioButton*>(state.control), ITEMBORDER);
   };
 # undef ITEMBORDER
 
-  while (!section.empty()) {
-    if (section.begin()->find("HORIZONTAL") != std::string::npos || section.begin()->find("VERTICAL") != std::string::npos) {
-      auto isHorizontal = section.begin()->find("HORIZONTAL") != std::string::npos;
-      auto label = FileParse::parseLabel(*section.begin());
-      auto newSection = FileParse::extractSection(isHorizontal ? "HORIZONTAL" : "VERTICAL", section);
-      newSection.erase(newSection.begin()); // Erase HORIZONTAL or VERTICAL header to prevent infinite recursion.
-      if (label.empty()) { // If no label
+  for (const auto& child : section.children) {
+    if (child.isSection && (child.name == "HORIZONTAL" || child.name == "VERTICAL")) {
+      auto isHorizontal = child.name == "HORIZONTAL";
+      if (child.label.empty()) { // If no label
         auto newSizer = new wxBoxSizer(isHorizontal ? wxHORIZONTAL : wxVERTICAL);
-        parseLayoutSection(newSection, newSizer, parent);
+        parseLayoutSection(child, newSizer, parent);
         sizer->Add(newSizer, wxSizerFlags(0).Expand());
       } else { // Has label
-        auto newSizer = new wxStaticBoxSizer(isHorizontal ? wxHORIZONTAL : wxVERTICAL, parent, label);
-        parseLayoutSection(newSection, newSizer, newSizer->GetStaticBox());
+        auto newSizer = new wxStaticBoxSizer(isHorizontal ? wxHORIZONTAL : wxVERTICAL, parent, child.label);
+        parseLayoutSection(child, newSizer, newSizer->GetStaticBox());
         sizer->Add(newSizer, wxSizerFlags(0).Border(wxALL, 5).Expand());
       }
     }
-    else if (section.begin()->find("OPTION") != std::string::npos) {
-      auto key = settings->find(FileParse::parseLabel(*section.begin()));
-      if (key == settings->end()) {
-        warning(R"(Option ")" + FileParse::parseLabel(*section.begin()) + R"(" not found in settings, skipping...)");
-        section.erase(section.begin());
+    else if (child.name == "OPTION") {
+      auto key = settings.find(child.label);
+      if (key == settings.end()) {
+        warning(R"(Option ")" + child.label + R"(" on line )" + std::to_string(child.line) + R"( not found in settings, skipping...)");
         continue;
       }
-      switch (key->second.type) {
+      switch (key->second.setting.type) {
         case Setting::SettingType::TOGGLE: createToggle(key->second, parent, sizer); break;
         case Setting::SettingType::NUMERIC: createNumeric(key->second, parent, sizer); break;
         case Setting::SettingType::DECIMAL: createDecimal(key->second, parent, sizer); break;
         case Setting::SettingType::OPTION: createOption(key->second, parent, sizer); break;
       }
-      if (key->second.isDefault) key->second.setValue(true);
-      section.erase(section.begin());
-    }
-    else {
-      section.erase(section.begin());
+      key->second.setValue(key->second.value);
+      controlIDs.emplace(key->second.control, key->second.setting.id);
     }
   }
 
@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include "core/utilities/fileparse.h"
+
 #include <string>
 #include <vector>
 #include <array>
+#include <memory>
 #include <unordered_map>
 #include <wx/sizer.h>
 #include <wx/checkbox.h>
@@ -13,76 +16,101 @@
 #include <wx/combobox.h>
 #include <wx/panel.h>
 
-namespace std {
-  template <>
-  struct hash<std::vector<std::string>> {
-    size_t operator()(const std::vector<std::string>& vector) const {
-      size_t hash = 0;
-      for (const auto& string : vector) {
-        hash ^= std::hash<std::string>{}(string) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-      }
-      return hash;
-    }
-  };
-}
-
 class PropFile : public wxPanel {
 public:
   ~PropFile();
   struct Setting;
   typedef std::unordered_map<std::string, Setting> SettingMap;
+  struct SettingState;
+  typedef std::unordered_map<std::string, SettingState> StateMap;
   struct Button;
   typedef std::vector<std::pair<std::string, std::vector<Button>>> ButtonArray;
 
+  // Everything read from a .pconf, before any UI gets made for it.
+  // Shared (read-only) by every editor that has the prop loaded.
+  struct Definition {
+    std::string name{};
+    std::string fileName{};
+    std::string info{};
+    SettingMap settings{};
+    FileParse::Node layout{};
+    std::array<ButtonArray, 4> buttons{};
+
+    // REQUIRE/REQUIREANY/DISABLE (and option groups) by Setting::id,
+    // compiled from the settings after they're read.
+    struct Dependencies {
+      std::vector<std::vector<uint32_t>> disables{};
+      std::vector<std::vector<uint32_t>> requiredBy{};
+      std::vector<std::vector<uint32_t>> group{};
+      std::vector<uint32_t> numRequired{};
+      std::vector<bool> requireAny{};
+      std::vector<bool> requireMissing{};
+    } dependencies{};
+  };
+
   static PropFile* createPropConfig(const std::string&, wxWindow*);
+  // Loaded once and kept for as long as any editor uses it
+  static std::shared_ptr<const Definition> getDefinition(const std::string& name);
+  static bool readDefinition(const std::string& name, const std::string& path, Definition&);
+
+  // Creates the setting controls, only done once the prop is actually shown.
+  void buildLayout();
+
+  // Re-evaluates only what depends on the setting that owns control, after it's changed.
+  void settingChanged(const void* control);
+  // Re-evaluates everything, use after changing values directly.
+  void updateDependencies();
+  // Whether the setting's requirements are met and nothing disables it.
+  bool isEnabled(const SettingState&) const;
 
   std::string getName() const;
   std::string getFileName() const;
   std::string getInfo() const;
-  SettingMap* getSettings();
+  StateMap* getSettings();
   const std::array<ButtonArray, 4>* getButtons();
 
 private:
   PropFile() = delete;
-  PropFile(wxWindow*);
+  PropFile(wxWindow*, std::shared_ptr<const Definition>);
 
-  std::string name{};
-  std::string fileName{};
-  std::string info{};
-  SettingMap* settings{nullptr};
-  std::array<ButtonArray, 4>* buttons{nullptr};
+  const std::shared_ptr<const Definition> definition;
+  StateMap settings{};
+  // Per-editor dependency state, indexed by Setting::id
+  std::vector<SettingState*> states{};
+  std::vector<bool> active{};
+  std::vector<uint32_t> numDisabling{};
+  std::vector<uint32_t> numRequiredActive{};
+  std::unordered_map<const void*, uint32_t> controlIDs{};
+
+  void propagate(uint32_t id, std::vector<uint32_t>& affected);
+  bool isEnabled(uint32_t id) const;
 
   wxBoxSizer* sizer{nullptr};
 
-  bool readName(std::vector<std::string>&);
-  bool readFileName(std::vector<std::string>&);
-  bool readInfo(std::vector<std::string>&);
-  bool readSettings(std::vector<std::string>&);
+  static bool readName(const FileParse::Node&, Definition&);
+  static bool readFileName(const FileParse::Node&, Definition&);
+  static bool readInfo(const FileParse::Node&, Definition&);
+  static bool readSettings(const FileParse::Node&, Definition&);
 
-  bool readLayout(std::vector<std::string>&);
-  bool parseLayoutSection(std::vector<std::string>&, wxSizer*, wxWindow*);
+  bool readLayout(const FileParse::Node&);
+  bool parseLayoutSection(const FileParse::Node&, wxSizer*, wxWindow*);
 
-  bool readButtons(std::vector<std::string>&);
-  void parseButtons(std::vector<std::string>&);
-  void parseButtonSection(std::vector<std::string>&, const int32_t&, const int32_t&);
-  void parseButtonDescriptions(PropFile::Button&, std::vector<std::string>&);
-  void parseButtonRelevantSettings(PropFile::Button&);
+  static bool readButtons(const FileParse::Node&, Definition&);
+  static void parseButtons(const FileParse::Node&, Definition&);
+  static void parseButtonSection(const FileParse::Node&, ButtonArray&, const int32_t&);
+  static void parseButtonDescriptions(PropFile::Button&, const FileParse::Node&);
 
-  void pruneUnused();
+  static void pruneUnused(Definition&);
+  static void compileDependencies(Definition&);
 
   static void warning(const std::string&);
   static void error(const std::string&);
 
-  [[nodiscard]] static bool parseSettingCommon(Setting&, std::vector<std::string>&);
+  [[nodiscard]] static bool parseSettingCommon(Setting&, const FileParse::Node&);
 };
 
 
 struct PropFile::Setting {
-  void setValue(double) const;
-  void enable(bool = true) const;
-  std::string getOutput() const;
-  bool checkRequiredSatisfied(const std::unordered_map<std::string, Setting>&) const;
-
   std::string name{};
   std::string define{};
   std::string description{};
@@ -90,7 +118,6 @@ struct PropFile::Setting {
   std::vector<std::string> required{};
   std::vector<std::string> requiredAny{};
   std::vector<std::string> disables{};
-  bool disabled{false};
 
   double min{0};
   double max{100};
@@ -101,12 +128,30 @@ struct PropFile::Setting {
   bool isDefault{false};
   bool shouldOutput{true};
 
+  // Assigned by compileDependencies()
+  uint32_t id{0};
+
   enum class SettingType {
     TOGGLE,
     OPTION,
     NUMERIC,
     DECIMAL,
   } type{SettingType::TOGGLE};
+};
+
+// What one editor has for a Setting
+struct PropFile::SettingState {
+  SettingState(const Setting&);
+
+  void setValue(double);
+  void enable(bool = true) const;
+  std::string getOutput() const;
+  // Same as !getOutput().empty(), without building the string
+  bool isSet() const;
+
+  const Setting& setting;
+  // Kept here until the control is made, afterwards the control has the real value
+  double value{0};
 
   // Tried using a union... it broke wx
   void* control{nullptr};
@@ -115,5 +160,6 @@ struct PropFile::Setting {
 struct PropFile::Button {
   std::string name{};
   std::vector<std::string> relevantSettings{};
-  std::unordered_map<std::vector<std::string>, std::string> descriptions{};
+  // Keyed by which relevantSettings are active, bit n for relevantSettings[n]
+  std::unordered_map<uint64_t, std::string> descriptions{};
 };
@@ -4,13 +4,15 @@
 #include "core/config/settings.h"
 
 #include "core/config/configuration.h"
-#include "editor/editorwindow.h"
-#include "editor/pages/generalpage.h"
-#include "editor/dialogs/bladearraydlg.h"
 
 #include <cstring>
 
-Settings::Settings(EditorWindow* _parent) : parent(_parent) {
+Settings::Settings(ConfigModel& _config) : config(_config) {
+  linkDefines();
+  setCustomInputParsers();
+  setCustomOutputParsers();
+}
+Settings::Settings(const ConfigModel& _config) : ownConfig(_config), config(ownConfig) {
   linkDefines();
   setCustomInputParsers();
   setCustomOutputParsers();
@@ -22,95 +24,92 @@ Settings::~Settings() {
 void Settings::linkDefines() {
 # define ENTRY(name, ...) { name, new ProffieDefine(name, __VA_ARGS__) }
 # define CHECKER(name) [&](const ProffieDefine* name) -> bool
-# define IDSETTING(setting) parent->bladesPage->bladeArrayDlg->setting->GetValue()
+# define GENERAL(setting) &config.general.setting
+# define IDSETTING(setting) config.bladeAwareness.setting
 
   generalDefines = {
                     // General
-                    ENTRY("NUM_BLADES", -1,( pcSpinCtrl*)nullptr, CHECKER(){ return true; }),
-                    ENTRY("NUM_BUTTONS", 2, parent->generalPage->buttons, CHECKER(){ return true; }),
-                    ENTRY("VOLUME", 1500, parent->generalPage->volume, CHECKER(){ return true; }),
-                    ENTRY("CLASH_THRESHOLD_G", 3.0, parent->generalPage->clash, CHECKER(){ return true; }),
-                    ENTRY("SAVE_COLOR_CHANGE", true, parent->generalPage->colorSave),
-                    ENTRY("SAVE_PRESET", true, parent->generalPage->presetSave),
-                    ENTRY("SAVE_VOLUME", true, parent->generalPage->volumeSave),
-                    ENTRY("SAVE_STATE", false, (wxCheckBox*)nullptr, CHECKER(){ return false; }),
-
-                    ENTRY("ENABLE_SSD1306", false, parent->generalPage->enableOLED),
-
-                    ENTRY("DISABLE_COLOR_CHANGE", false, parent->generalPage->disableColor),
-                    ENTRY("DISABLE_TALKIE", false, parent->generalPage->noTalkie),
-                    ENTRY("DISABLE_BASIC_PARSER_STYLES", true, parent->generalPage->noBasicParsers),
-                    ENTRY("DISABLE_DIAGNOSTIC_COMMANDS", true, parent->generalPage->disableDiagnosticCommands),
-
-                    ENTRY("ORIENTATION", Configuration::Orientation.begin()->first, parent->generalPage->orientation, CHECKER(){ return true; }),
-                    ENTRY("PLI_OFF_TIME", 2, parent->generalPage->pliTime, CHECKER(){ return true; }),
-                    ENTRY("IDLE_OFF_TIME", 15, parent->generalPage->idleTime, CHECKER(){ return true; }),
-                    ENTRY("MOTION_TIMEOUT", 10, parent->generalPage->motionTime, CHECKER(){ return true; }),
-
-                    ENTRY("BLADE_DETECT_PIN", "", parent->bladesPage->bladeArrayDlg->detectPin, CHECKER(){ return IDSETTING(enableDetect); }),
-                    ENTRY("BLADE_ID_CLASS", "", parent->bladesPage->bladeArrayDlg->mode, CHECKER(){ return IDSETTING(enableID); }),
-                    ENTRY("ENABLE_POWER_FOR_ID", false, parent->bladesPage->bladeArrayDlg->enablePowerForID, CHECKER(def){ return IDSETTING(enableID) && def->getState(); }),
-                    ENTRY("BLADE_ID_SCAN_MILLIS", 1000, parent->bladesPage->bladeArrayDlg->scanIDMillis, CHECKER(){ return IDSETTING(enableID) && IDSETTING(continuousScans); }),
-                    ENTRY("BLADE_ID_TIMES", 10, parent->bladesPage->bladeArrayDlg->numIDTimes, CHECKER(){ return IDSETTING(enableID) && IDSETTING(continuousScans); }),
+                    ENTRY("NUM_BLADES", (int32_t*)nullptr, CHECKER(){ return true; }),
+                    ENTRY("NUM_BUTTONS", GENERAL(buttons), CHECKER(){ return true; }),
+                    ENTRY("VOLUME", GENERAL(volume), CHECKER(){ return true; }),
+                    ENTRY("CLASH_THRESHOLD_G", GENERAL(clash), CHECKER(){ return true; }),
+                    ENTRY("SAVE_COLOR_CHANGE", GENERAL(colorSave)),
+                    ENTRY("SAVE_PRESET", GENERAL(presetSave)),
+                    ENTRY("SAVE_VOLUME", GENERAL(volumeSave)),
+                    ENTRY("SAVE_STATE", (bool*)nullptr, CHECKER(){ return false; }),
+
+                    ENTRY("ENABLE_SSD1306", GENERAL(enableOLED)),
+
+                    ENTRY("DISABLE_COLOR_CHANGE", GENERAL(disableColor)),
+                    ENTRY("DISABLE_TALKIE", GENERAL(noTalkie)),
+                    ENTRY("DISABLE_BASIC_PARSER_STYLES", GENERAL(noBasicParsers)),
+                    ENTRY("DISABLE_DIAGNOSTIC_COMMANDS", GENERAL(disableDiagnosticCommands)),
+
+                    ENTRY("ORIENTATION", GENERAL(orientation), CHECKER(){ return true; }),
+                    ENTRY("PLI_OFF_TIME", GENERAL(pliTime), CHECKER(){ return true; }),
+                    ENTRY("IDLE_OFF_TIME", GENERAL(idleTime), CHECKER(){ return true; }),
+                    ENTRY("MOTION_TIMEOUT", GENERAL(motionTime), CHECKER(){ return true; }),
+
+                    ENTRY("BLADE_DETECT_PIN", &IDSETTING(detectPin), CHECKER(){ return IDSETTING(enableDetect); }),
+                    ENTRY("BLADE_ID_CLASS", &IDSETTING(mode), CHECKER(){ return IDSETTING(enableID); }),
+                    ENTRY("ENABLE_POWER_FOR_ID", &IDSETTING(enablePowerForID), CHECKER(def){ return IDSETTING(enableID) && def->getState(); }),
+                    ENTRY("BLADE_ID_SCAN_MILLIS", &IDSETTING(scanIDMillis), CHECKER(){ return IDSETTING(enableID) && IDSETTING(continuousScans); }),
+                    ENTRY("BLADE_ID_TIMES", &IDSETTING(numIDTimes), CHECKER(){ return IDSETTING(enableID) && IDSETTING(continuousScans); }),
                     };
 
 # undef ENTRY
 # undef CHECKER
+# undef GENERAL
 # undef IDSETTING
 }
 
 void Settings::setCustomInputParsers() {
   generalDefines["NUM_BLADES"]->overrideParser ([&](const ProffieDefine* def, const std::string& input) -> bool {
-    auto key = ProffieDefine::parseKey(input);
-    if (key.first != def->getName()) return false;
-
-    numBlades = std::stoi(key.second);
-    return true;
+    // Always recalculated from the blade arrays
+    return ProffieDefine::parseKey(input).first == def->getName();
   });
   generalDefines["SAVE_STATE"]->overrideParser([&](const ProffieDefine* def, const std::string& input) -> bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
 
-    parent->generalPage->colorSave->SetValue(true);
-    parent->generalPage->presetSave->SetValue(true);
-    parent->generalPage->volumeSave->SetValue(true);
+    config.general.colorSave = true;
+    config.general.presetSave = true;
+    config.general.volumeSave = true;
     return true;
   });
   generalDefines["ORIENTATION"]->overrideParser([&](const ProffieDefine* def, const std::string& input) -> bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
 
-    parent->generalPage->orientation->entry()->SetStringSelection(Configuration::findInVMap(Configuration::Orientation, key.second).first);
+    config.general.orientation = Configuration::findInVMap(Configuration::Orientation, key.second).second;
     return true;
   });
-  generalDefines["ORIENTATION"]->overrideOutput([&](const ProffieDefine* def) -> std::string {
-    return {def->getName() + " " + Configuration::findInVMap(Configuration::Orientation, def->getString()).second};
-  });
   generalDefines["BLADE_DETECT_PIN"]->overrideParser([&](const ProffieDefine* def, const std::string& input) -> bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
     
-    parent->bladesPage->bladeArrayDlg->enableDetect->SetValue(true);
-    parent->bladesPage->bladeArrayDlg->detectPin->entry()->SetValue(key.second);
+    config.bladeAwareness.enableDetect = true;
+    config.bladeAwareness.detectPin = key.second;
     return true;
   });
   generalDefines["BLADE_ID_CLASS"]->overrideParser([&](const ProffieDefine* def, const std::string& input) -> bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
     
-    parent->bladesPage->bladeArrayDlg->enableID->SetValue(true);
+    auto& bladeID = config.bladeAwareness;
+    bladeID.enableID = true;
     key.second = std::strtok(key.second.data(), "< ");
     if (key.second == "SnapshotBladeID") {
-      parent->bladesPage->bladeArrayDlg->mode->entry()->SetStringSelection(BLADE_ID_MODE_SNAPSHOT);
-      parent->bladesPage->bladeArrayDlg->IDPin->entry()->SetValue(std::strtok(nullptr, "<> "));
+      bladeID.mode = BLADE_ID_MODE_SNAPSHOT;
+      bladeID.IDPin = std::strtok(nullptr, "<> ");
     } else if (key.second == "ExternalPullupBladeID") {
-      parent->bladesPage->bladeArrayDlg->mode->entry()->SetStringSelection(BLADE_ID_MODE_EXTERNAL);
-      parent->bladesPage->bladeArrayDlg->IDPin->entry()->SetValue(std::strtok(nullptr, "<, "));
-      parent->bladesPage->bladeArrayDlg->pullupResistance->entry()->SetValue(std::stod(std::strtok(nullptr, ",> ")));
+      bladeID.mode = BLADE_ID_MODE_EXTERNAL;
+      bladeID.IDPin = std::strtok(nullptr, "<, ");
+      bladeID.pullupResistance = std::stoi(std::strtok(nullptr, ",> "));
     } else if (key.second == "BridgedPullupBladeID") {
-      parent->bladesPage->bladeArrayDlg->mode->entry()->SetStringSelection(BLADE_ID_MODE_BRIDGED);
-      parent->bladesPage->bladeArrayDlg->IDPin->entry()->SetValue(std::strtok(nullptr, "<, "));
-      parent->bladesPage->bladeArrayDlg->pullupPin->entry()->SetValue(std::strtok(nullptr, ",> "));
+      bladeID.mode = BLADE_ID_MODE_BRIDGED;
+      bladeID.IDPin = std::strtok(nullptr, "<, ");
+      bladeID.pullupPin = std::strtok(nullptr, ",> ");
     }
     return true;
   });
@@ -118,33 +117,30 @@ void Settings::setCustomInputParsers() {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
     
-    parent->bladesPage->bladeArrayDlg->scanIDMillis->entry()->SetValue(std::stoi(key.second));
-    parent->bladesPage->bladeArrayDlg->continuousScans->SetValue(true);
+    config.bladeAwareness.scanIDMillis = std::stoi(key.second);
+    config.bladeAwareness.continuousScans = true;
     return true;
   });
   generalDefines["BLADE_ID_TIMES"]->overrideParser([&](const ProffieDefine* def, const std::string& input) ->bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
     
-    parent->bladesPage->bladeArrayDlg->numIDTimes->entry()->SetValue(std::stoi(key.second));
-    parent->bladesPage->bladeArrayDlg->continuousScans->SetValue(true);
+    config.bladeAwareness.numIDTimes = std::stoi(key.second);
+    config.bladeAwareness.continuousScans = true;
     return true;
   });
   generalDefines["ENABLE_POWER_FOR_ID"]->overrideParser([&](const ProffieDefine* def, const std::string& input) -> bool {
     auto key = ProffieDefine::parseKey(input);
     if (key.first != def->getName()) return false;
     
-    parent->bladesPage->bladeArrayDlg->enablePowerForID->SetValue(true);
+    config.bladeAwareness.enablePowerForID = true;
     std::strtok(key.second.data(), "<");
     char* pwrPinTest = std::strtok(nullptr, "<>, ");
     while (pwrPinTest != nullptr) {
       key.second = pwrPinTest;
-      if (key.second == "bladePowerPin1") parent->bladesPage->bladeArrayDlg->powerPin1->SetValue(true);
-      if (key.second == "bladePowerPin2") parent->bladesPage->bladeArrayDlg->powerPin2->SetValue(true);
-      if (key.second == "bladePowerPin3") parent->bladesPage->bladeArrayDlg->powerPin3->SetValue(true);
-      if (key.second == "bladePowerPin4") parent->bladesPage->bladeArrayDlg->powerPin4->SetValue(true);
-      if (key.second == "bladePowerPin5") parent->bladesPage->bladeArrayDlg->powerPin5->SetValue(true);
-      if (key.second == "bladePowerPin6") parent->bladesPage->bladeArrayDlg->powerPin6->SetValue(true);
+      for (size_t pin = 0; pin < config.bladeAwareness.powerPins.size(); pin++) {
+        if (key.second == "bladePowerPin" + std::to_string(pin + 1)) config.bladeAwareness.powerPins[pin] = true;
+      }
 
       pwrPinTest = std::strtok(nullptr, "<>, ");
     }
@@ -153,8 +149,9 @@ void Settings::setCustomInputParsers() {
 }
 void Settings::setCustomOutputParsers() {
   generalDefines["NUM_BLADES"]->overrideOutput([&](const ProffieDefine* def) -> std::string {
+    // All arrays are the same length, runPreChecks makes sure of it
     int32_t numBlades = 0;
-    for (const BladesPage::BladeConfig& blade : parent->bladesPage->bladeArrayDlg->bladeArrays[parent->bladesPage->bladeArray->entry()->GetSelection()].blades) numBlades += blade.subBlades.size() > 0 ? blade.subBlades.size() : 1;
+    for (const auto& blade : config.bladeArrays.front().blades) numBlades += blade.subBlades.size() > 0 ? blade.subBlades.size() : 1;
     return def->getName() + " " + std::to_string(numBlades);
   });
   generalDefines["PLI_OFF_TIME"]->overrideOutput([](const ProffieDefine* def) -> std::string {
@@ -167,23 +164,20 @@ void Settings::setCustomOutputParsers() {
     return def->getName() + " " + std::to_string(def->getNum()) + " * 60 * 1000";
   });
   generalDefines["BLADE_ID_CLASS"]->overrideOutput([&](const ProffieDefine* def) -> std::string {
-    auto mode = parent->bladesPage->bladeArrayDlg->mode->entry()->GetStringSelection();
+    const auto& bladeID = config.bladeAwareness;
     std::string returnVal = def->getName() + " ";
-    if (mode == BLADE_ID_MODE_SNAPSHOT) returnVal + "SnapshotBladeID<" + parent->bladesPage->bladeArrayDlg->IDPin->entry()->GetValue() + ">";
-    else if (mode == BLADE_ID_MODE_BRIDGED) returnVal + "ExternalPullupBladeID<" + parent->bladesPage->bladeArrayDlg->IDPin->entry()->GetValue() + ", " + parent->bladesPage->bladeArrayDlg->pullupResistance->entry()->GetTextValue() + ">";
-    else if (mode == BLADE_ID_MODE_EXTERNAL) returnVal + "BridgedPullupBladeID<" + parent->bladesPage->bladeArrayDlg->IDPin->entry()->GetValue() + ", " + parent->bladesPage->bladeArrayDlg->pullupPin->entry()->GetValue();
+    if (bladeID.mode == BLADE_ID_MODE_SNAPSHOT) returnVal += "SnapshotBladeID<" + bladeID.IDPin + ">";
+    else if (bladeID.mode == BLADE_ID_MODE_EXTERNAL) returnVal += "ExternalPullupBladeID<" + bladeID.IDPin + ", " + std::to_string(bladeID.pullupResistance) + ">";
+    else if (bladeID.mode == BLADE_ID_MODE_BRIDGED) returnVal += "BridgedPullupBladeID<" + bladeID.IDPin + ", " + bladeID.pullupPin + ">";
 
     return returnVal;
   });
   generalDefines["ENABLE_POWER_FOR_ID"]->overrideOutput([&](const ProffieDefine* def) -> std::string {
     std::string returnVal = def->getName() + " PowerPINS<";
     std::vector<std::string> powerPins;
-    if (parent->bladesPage->bladeArrayDlg->powerPin1->GetValue()) powerPins.push_back("bladePowerPin1");
-    if (parent->bladesPage->bladeArrayDlg->powerPin2->GetValue()) powerPins.push_back("bladePowerPin2");
-    if (parent->bladesPage->bladeArrayDlg->powerPin3->GetValue()) powerPins.push_back("bladePowerPin3");
-    if (parent->bladesPage->bladeArrayDlg->powerPin4->GetValue()) powerPins.push_back("bladePowerPin4");
-    if (parent->bladesPage->bladeArrayDlg->powerPin5->GetValue()) powerPins.push_back("bladePowerPin5");
-    if (parent->bladesPage->bladeArrayDlg->powerPin6->GetValue()) powerPins.push_back("bladePowerPin6");
+    for (size_t pin = 0; pin < config.bladeAwareness.powerPins.size(); pin++) {
+      if (config.bladeAwareness.powerPins[pin]) powerPins.push_back("bladePowerPin" + std::to_string(pin + 1));
+    }
 
     for (int32_t pin = 0; pin < static_cast<int32_t>(powerPins.size()); pin++) {
       returnVal += powerPins.at(pin);
@@ -219,38 +213,30 @@ void Settings::parseDefines(std::vector<std::string>& _defList) {
 }
 
 int32_t Settings::ProffieDefine::getNum() const {
-  if (type != Type::NUMERIC) return 0;
-  return const_cast<pcSpinCtrl*>(static_cast<const pcSpinCtrl*>(element))->entry()->GetValue();
+  if (type != Type::NUMERIC || value.num == nullptr) return 0;
+  return *value.num;
 }
 double Settings::ProffieDefine::getDec() const {
-  if (type != Type::DECIMAL) return 0;
-  return const_cast<pcSpinCtrlDouble*>(static_cast<const pcSpinCtrlDouble*>(element))->entry()->GetValue();
+  if (type != Type::DECIMAL || value.dec == nullptr) return 0;
+  return *value.dec;
 }
 bool Settings::ProffieDefine::getState() const {
-  if (type == Type::STATE) return const_cast<wxCheckBox*>(static_cast<const wxCheckBox*>(element))->GetValue();
-  if (type == Type::RADIO) return const_cast<wxRadioButton*>(static_cast<const wxRadioButton*>(element))->GetValue();
-
-  return false;
+  if (type != Type::STATE || value.state == nullptr) return false;
+  return *value.state;
 }
 std::string Settings::ProffieDefine::getString() const {
-  if (type == Type::TEXT) return const_cast<pcTextCtrl*>(static_cast<const pcTextCtrl*>(element))->entry()->GetValue().ToStdString();
-  if (type == Type::COMBO) return const_cast<pcChoice*>(static_cast<const pcChoice*>(element))->entry()->GetStringSelection().ToStdString();
-
-  return "";
+  if (type != Type::TEXT || value.str == nullptr) return "";
+  return *value.str;
 }
 
-Settings::ProffieDefine::ProffieDefine(std::string _name, int32_t _defaultValue, pcSpinCtrl* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                        type(Type::NUMERIC), looseChecking(_loose), defaultValue({ .num = _defaultValue }), identifier(_name), element(_element), checkOutput(_check) {}
-Settings::ProffieDefine::ProffieDefine(std::string _name, double _defaultValue, pcSpinCtrlDouble* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                             type(Type::DECIMAL), looseChecking(_loose), defaultValue({ .dec = _defaultValue }), identifier(_name), element(_element), checkOutput(_check) {}
-Settings::ProffieDefine::ProffieDefine(std::string _name, bool _defaultState, wxCheckBox* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                     type(Type::STATE), looseChecking(_loose), defaultValue({ .state = _defaultState }), identifier(_name), element(_element), checkOutput(_check) {}
-Settings::ProffieDefine::ProffieDefine(std::string _name, bool _defaultState, wxRadioButton* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                        type(Type::RADIO), looseChecking(_loose), defaultValue({ .state = _defaultState }), identifier(_name), element(_element), checkOutput(_check) {}
-Settings::ProffieDefine::ProffieDefine(std::string _name, wxString _defaultSelection, pcChoice* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                             type(Type::COMBO), looseChecking(_loose), defaultValue({ .str = _defaultSelection.ToStdString().data() }), identifier(_name), element(_element), checkOutput(_check) {}
-Settings::ProffieDefine::ProffieDefine(std::string _name, wxString _defaultEntry, pcTextCtrl* _element, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
-                                                                                                                                                                         type(Type::TEXT), looseChecking(_loose), defaultValue({ .str = _defaultEntry.ToStdString().data() }), identifier(_name), element(_element), checkOutput(_check) {}
+Settings::ProffieDefine::ProffieDefine(std::string _name, int32_t* _value, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
+  type(Type::NUMERIC), looseChecking(_loose), value({ .num = _value }), identifier(_name), checkOutput(_check) {}
+Settings::ProffieDefine::ProffieDefine(std::string _name, double* _value, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
+  type(Type::DECIMAL), looseChecking(_loose), value({ .dec = _value }), identifier(_name), checkOutput(_check) {}
+Settings::ProffieDefine::ProffieDefine(std::string _name, bool* _value, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
+  type(Type::STATE), looseChecking(_loose), value({ .state = _value }), identifier(_name), checkOutput(_check) {}
+Settings::ProffieDefine::ProffieDefine(std::string _name, std::string* _value, std::function<bool(const ProffieDefine*)> _check, bool _loose) :
+  type(Type::TEXT), looseChecking(_loose), value({ .str = _value }), identifier(_name), checkOutput(_check) {}
 
 
 std::pair<std::string, std::string> Settings::ProffieDefine::parseKey(const std::string& _input) {
@@ -3,32 +3,35 @@
 
 #pragma once
 
-#include "editor/editorwindow.h"
-#include "ui/pcspinctrl.h"
-#include "ui/pcspinctrldouble.h"
-#include "ui/pctextctrl.h"
+#include "core/config/configmodel.h"
 
 #include <cstdint>
 #include <cstring>
-#include <wx/checkbox.h>
-#include <wx/radiobut.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #define PDEF_DEFAULT_CHECK [](const ProffieDefine* def) -> bool { return def->getState(); }
 
+// General defines ProffieConfig understands, each bound to a field of the model.
 class Settings {
 public:
-    Settings(EditorWindow*);
+    // Bound to the model, parseDefines() fills it in.
+    Settings(ConfigModel&);
+    // Only for output, bound to a copy of the model.
+    Settings(const ConfigModel&);
     ~Settings();
 
+    // Reads known defines into the model, leaving the rest in the list
     void parseDefines(std::vector<std::string>&);
 
     class ProffieDefine;
     std::unordered_map<std::string, ProffieDefine*> generalDefines{};
-    std::vector<std::string> readDefines{};
-    int32_t numBlades{0};
 
 private:
-    EditorWindow* parent{nullptr};
+    ConfigModel ownConfig{};
+    ConfigModel& config;
 
     void linkDefines();
     void setCustomInputParsers();
@@ -39,32 +42,27 @@ class Settings::ProffieDefine {
 private:
     enum class Type {
         STATE,
-        RADIO,
         NUMERIC,
         DECIMAL,
-        COMBO,
         TEXT
     } const type{Type::STATE};
     const bool looseChecking{false};
 
     const union {
-        int32_t num;
-        double dec;
-        bool state;
-        char* str;
-    } defaultValue{0};
+        int32_t* num;
+        double* dec;
+        bool* state;
+        std::string* str;
+    } value{nullptr};
 
     const std::string identifier{};
-    const void* element{nullptr};
 
 public:
 
-    ProffieDefine(std::string name, int32_t defaultValue, pcSpinCtrl* element, std::function<bool(const ProffieDefine*)> check, bool loose = false);
-    ProffieDefine(std::string name, double defaultValue, pcSpinCtrlDouble* element, std::function<bool(const ProffieDefine*)> check, bool loose = false);
-    ProffieDefine(std::string name, bool defaultState, wxCheckBox* element, std::function<bool(const ProffieDefine*)> check = PDEF_DEFAULT_CHECK, bool loose = false);
-    ProffieDefine(std::string name, bool defaultState, wxRadioButton* element, std::function<bool(const ProffieDefine*)> check = PDEF_DEFAULT_CHECK, bool loose = false);
-    ProffieDefine(std::string name, wxString defaultSelection, pcChoice* element, std::function<bool(const ProffieDefine*)> check, bool loose = false);
-    ProffieDefine(std::string name, wxString defaultEntry, pcTextCtrl* element, std::function<bool(const ProffieDefine*)> check, bool loose = false);
+    ProffieDefine(std::string name, int32_t* value, std::function<bool(const ProffieDefine*)> check, bool loose = false);
+    ProffieDefine(std::string name, double* value, std::function<bool(const ProffieDefine*)> check, bool loose = false);
+    ProffieDefine(std::string name, bool* value, std::function<bool(const ProffieDefine*)> check = PDEF_DEFAULT_CHECK, bool loose = false);
+    ProffieDefine(std::string name, std::string* value, std::function<bool(const ProffieDefine*)> check, bool loose = false);
 
     static std::pair<std::string, std::string> parseKey(const std::string&);
 
@@ -75,22 +73,16 @@ public:
 
         switch (def->type) {
             case Type::STATE:
-                const_cast<wxCheckBox*>(static_cast<const wxCheckBox*>(def->element))->SetValue(true);
-                break;
-            case Type::RADIO:
-                const_cast<wxRadioButton*>(static_cast<const wxRadioButton*>(def->element))->SetValue(true);
+                *def->value.state = true;
                 break;
             case Type::NUMERIC:
-                const_cast<pcSpinCtrl*>(static_cast<const pcSpinCtrl*>(def->element))->entry()->SetValue(stoi(key.second));
+                *def->value.num = stoi(key.second);
                 break;
             case Type::DECIMAL:
-                const_cast<pcSpinCtrlDouble*>(static_cast<const pcSpinCtrlDouble*>(def->element))->entry()->SetValue(stod(key.second));
-                break;
-            case Type::COMBO:
-                const_cast<pcChoice*>(static_cast<const pcChoice*>(def->element))->entry()->SetStringSelection(key.second);
+                *def->value.dec = stod(key.second);
                 break;
             case Type::TEXT:
-                const_cast<pcTextCtrl*>(static_cast<const pcTextCtrl*>(def->element))->entry()->SetValue(key.second);
+                *def->value.str = key.second;
                 break;
         }
 
@@ -102,11 +94,9 @@ public:
             return def->identifier + " " + std::to_string(def->getNum());
             case Type::DECIMAL:
             return def->identifier + " " + std::to_string(def->getDec());
-            case Type::COMBO:
             case Type::TEXT:
             return def->identifier + " " + def->getString();
             case Type::STATE:
-            case Type::RADIO:
             default:
             return def->identifier;
         }
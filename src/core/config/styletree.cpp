@@ -0,0 +1,248 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "core/config/styletree.h"
+
+bool StyleTree::parse(const std::string& style) {
+  ownLexer.readString(style);
+  return parse(ownLexer, 0, ownLexer.getTokens().size());
+}
+bool StyleTree::parse(const Lexer& _lexer, size_t _begin, size_t _end) {
+  lexer = &_lexer;
+  begin = _begin;
+  end = _end < lexer->getTokens().size() ? _end : lexer->getTokens().size();
+  nodes.clear();
+  nodes.reserve((end - begin) / 2 + 1);
+  error.clear();
+
+  auto index = begin;
+  if (parseNode(index) == NONE) return false;
+  index = skipComments(index);
+  if (index < end) return fail(index, "Unexpected");
+  return true;
+}
+
+const Lexer& StyleTree::getLexer() const { return *lexer; }
+const std::vector<StyleTree::Node>& StyleTree::getNodes() const { return nodes; }
+const StyleTree::Node* StyleTree::getRoot() const { return nodes.empty() || !error.empty() ? nullptr : &nodes.front(); }
+const std::string& StyleTree::getError() const { return error; }
+
+std::string_view StyleTree::getName(const Node& node) const {
+  const auto& tokens = lexer->getTokens();
+  auto nameBegin = node.begin;
+  if (node.type == Node::Type::REFERENCE) nameBegin = skipComments(nameBegin + 1);
+  if (nameBegin >= node.end) return {};
+
+  auto nameEnd = nameBegin + 1;
+  if (node.type == Node::Type::IDENTIFIER || node.type == Node::Type::REFERENCE) {
+    while (nameEnd + 1 < node.end && tokens[nameEnd].is(Lexer::Token::Type::PUNCTUATION, "::") && tokens[nameEnd + 1].type == Lexer::Token::Type::IDENTIFIER) nameEnd += 2;
+  }
+  return lexer->slice(tokens[nameBegin].offset, tokens[nameEnd - 1].end());
+}
+std::string StyleTree::getText(const Node& node) const {
+  const auto& tokens = lexer->getTokens();
+  auto textBegin = skipComments(node.begin);
+  auto textEnd = static_cast<size_t>(node.end);
+  while (textEnd > textBegin && tokens[textEnd - 1].type == Lexer::Token::Type::COMMENT) textEnd--;
+  if (textBegin >= textEnd) return {};
+
+  std::string text;
+  auto copyFrom = tokens[textBegin].offset;
+  for (auto index = textBegin; index < textEnd; index++) {
+    if (tokens[index].type != Lexer::Token::Type::COMMENT) continue;
+    text.append(lexer->slice(copyFrom, tokens[index].offset));
+    copyFrom = tokens[index].end();
+  }
+  text.append(lexer->slice(copyFrom, tokens[textEnd - 1].end()));
+  return text;
+}
+std::string StyleTree::getText() const {
+  auto root = getRoot();
+  return root == nullptr ? std::string{} : getText(*root);
+}
+std::string_view StyleTree::getSource() const {
+  if (begin >= end) return {};
+  const auto& tokens = lexer->getTokens();
+  return lexer->slice(tokens[begin].offset, tokens[end - 1].end());
+}
+std::string StyleTree::getComments() const {
+  const auto& tokens = lexer->getTokens();
+  auto commentsEnd = nodes.empty() ? end : nodes.front().begin;
+  std::string comments;
+  for (auto index = begin; index < commentsEnd; index++) {
+    if (tokens[index].type != Lexer::Token::Type::COMMENT) continue;
+    comments.append(tokens[index].text);
+    if (tokens[index].text.rfind("//", 0) == 0) comments.push_back('\n');
+  }
+  return comments;
+}
+
+bool StyleTree::isStyle() const {
+  auto root = getRoot();
+  if (root == nullptr) return false;
+  if (root->type == Node::Type::REFERENCE) return true;
+  return root->type == Node::Type::IDENTIFIER && root->invoked && getName(*root).find("Style") != std::string_view::npos;
+}
+
+std::string StyleTree::substitute(const std::function<const std::string*(std::string_view)>& lookup) const {
+  if (begin >= end) return {};
+  const auto& tokens = lexer->getTokens();
+  std::string output;
+  auto copyFrom = tokens[begin].offset;
+  const Lexer::Token* previous{nullptr};
+  for (auto index = begin; index < end; index++) {
+    const auto& token = tokens[index];
+    if (token.type == Lexer::Token::Type::COMMENT) continue;
+
+    // Leave qualified names (Color8::GRB) and references (&style_pov) alone
+    auto qualified = previous != nullptr && (previous->is(Lexer::Token::Type::PUNCTUATION, "::") || previous->isPunct('&'));
+    previous = &token;
+    if (token.type != Lexer::Token::Type::IDENTIFIER || qualified) continue;
+
+    auto replacement = lookup(token.text);
+    if (replacement == nullptr) continue;
+
+    output.append(lexer->slice(copyFrom, token.offset));
+    output.append(*replacement);
+    copyFrom = token.end();
+  }
+  output.append(lexer->slice(copyFrom, tokens[end - 1].end()));
+  return output;
+}
+
+size_t StyleTree::skipComments(size_t index) const {
+  const auto& tokens = lexer->getTokens();
+  while (index < end && tokens[index].type == Lexer::Token::Type::COMMENT) index++;
+  return index;
+}
+
+int32_t StyleTree::parseNode(size_t& index) {
+  const auto& tokens = lexer->getTokens();
+  index = skipComments(index);
+  if (index >= end) {
+    fail(index, "Unexpected end of style");
+    return NONE;
+  }
+
+  auto nodeIdx = static_cast<int32_t>(nodes.size());
+  nodes.push_back(Node{});
+  nodes[nodeIdx].begin = index;
+
+  auto consumeName = [&]() {
+    index++;
+    while (index + 1 < end && tokens[index].is(Lexer::Token::Type::PUNCTUATION, "::") && tokens[index + 1].type == Lexer::Token::Type::IDENTIFIER) index += 2;
+  };
+
+  const auto& token = tokens[index];
+  if (token.isPunct('&')) {
+    index = skipComments(index + 1);
+    if (index >= end || tokens[index].type != Lexer::Token::Type::IDENTIFIER) {
+      fail(index, "Expected style name after");
+      return NONE;
+    }
+    nodes[nodeIdx].type = Node::Type::REFERENCE;
+    consumeName();
+  } else if (token.type == Lexer::Token::Type::STRING) {
+    nodes[nodeIdx].type = Node::Type::STRING;
+    index++;
+  } else if (token.type == Lexer::Token::Type::NUMBER) {
+    nodes[nodeIdx].type = Node::Type::NUMBER;
+    index++;
+  } else if ((token.isPunct('-') || token.isPunct('+')) && index + 1 < end && tokens[index + 1].type == Lexer::Token::Type::NUMBER) {
+    nodes[nodeIdx].type = Node::Type::NUMBER;
+    index += 2;
+  } else if (token.type == Lexer::Token::Type::IDENTIFIER) {
+    nodes[nodeIdx].type = Node::Type::IDENTIFIER;
+    consumeName();
+
+    index = skipComments(index);
+    if (index < end && tokens[index].type == Lexer::Token::Type::TEMPLATE_OPEN) {
+      auto args = parseList(index, '>');
+      if (!error.empty()) return NONE;
+      nodes[nodeIdx].templated = true;
+      nodes[nodeIdx].firstArg = args;
+    }
+    index = skipComments(index);
+    if (index < end && tokens[index].isPunct('(')) {
+      auto args = parseList(index, ')');
+      if (!error.empty()) return NONE;
+      nodes[nodeIdx].invoked = true;
+      nodes[nodeIdx].firstCallArg = args;
+    }
+  } else if (token.isPunct('(')) {
+    // Parenthesized arithmetic, e.g. Int<(32768 * 3) / 4>
+    index++;
+    if (parseNode(index) == NONE) return NONE;
+    index = skipComments(index);
+    if (index >= end || !tokens[index].isPunct(')')) {
+      fail(index, index >= end ? "Missing \")\"" : "Expected \")\" before");
+      return NONE;
+    }
+    nodes[nodeIdx].type = Node::Type::EXPRESSION;
+    index++;
+  } else {
+    fail(index, "Unexpected");
+    return NONE;
+  }
+
+  // Simple arithmetic in arguments, e.g. Int<32768 / 2>
+  auto next = skipComments(index);
+  while (next < end && tokens[next].type == Lexer::Token::Type::PUNCTUATION && tokens[next].text.size() == 1 && std::string_view("+-*/%|").find(tokens[next].text[0]) != std::string_view::npos) {
+    index = next + 1;
+    if (parseNode(index) == NONE) return NONE;
+    nodes[nodeIdx].type = Node::Type::EXPRESSION;
+    next = skipComments(index);
+  }
+
+  nodes[nodeIdx].end = index;
+  return nodeIdx;
+}
+int32_t StyleTree::parseList(size_t& index, char close) {
+  const auto& tokens = lexer->getTokens();
+  auto isClose = [&](const Lexer::Token& token) {
+    return close == '>' ? token.type == Lexer::Token::Type::TEMPLATE_CLOSE : token.isPunct(close);
+  };
+
+  index = skipComments(index + 1); // Opening bracket
+  if (index < end && isClose(tokens[index])) {
+    index++;
+    return NONE;
+  }
+
+  int32_t first{NONE};
+  int32_t last{NONE};
+  while (true) {
+    auto arg = parseNode(index);
+    if (arg == NONE) return NONE;
+    if (last == NONE) first = arg;
+    else nodes[last].next = arg;
+    last = arg;
+
+    index = skipComments(index);
+    if (index >= end) {
+      fail(index, std::string("Missing \"") + close + "\"");
+      return NONE;
+    }
+    if (isClose(tokens[index])) {
+      index++;
+      return first;
+    }
+    if (!tokens[index].isPunct(',')) {
+      fail(index, "Unexpected");
+      return NONE;
+    }
+    index++;
+  }
+}
+bool StyleTree::fail(size_t index, const std::string& message) {
+  if (!error.empty()) return false;
+  const auto& tokens = lexer->getTokens();
+  if (index >= end || index >= tokens.size()) {
+    error = message;
+    return false;
+  }
+
+  auto lineOffset = begin < tokens.size() ? tokens[begin].line - 1 : 0;
+  error = message + " \"" + std::string(tokens[index].text) + "\" on line " + std::to_string(tokens[index].line - lineOffset);
+  return false;
+}
@@ -0,0 +1,82 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include "core/utilities/lexer.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Syntax tree for a single blade style, e.g. `StylePtr<Layers<Black, ...>>()` or `&style_pov`.
+// Nodes live in one flat vector and link to each other by index, so a whole style
+// is parsed in one pass with a single allocation for the tree.
+class StyleTree {
+public:
+  struct Node;
+  static constexpr int32_t NONE{-1};
+
+  StyleTree() = default;
+  StyleTree(const StyleTree&) = delete;
+  StyleTree(StyleTree&&) = delete;
+
+  // Parse a style stored as text.
+  bool parse(const std::string&);
+  // Parse a range of an already tokenized source. The lexer must outlive the tree.
+  bool parse(const Lexer&, size_t begin, size_t end);
+
+  const Lexer& getLexer() const;
+  const std::vector<Node>& getNodes() const;
+  const Node* getRoot() const;
+  const std::string& getError() const;
+
+  std::string_view getName(const Node&) const;
+  // Source of the node (or whole style) with comments removed.
+  std::string getText(const Node&) const;
+  std::string getText() const;
+  // Full source of the style, including any comments.
+  std::string_view getSource() const;
+  // Comments found before the style itself, one line comment per line.
+  std::string getComments() const;
+
+  // Either a reference to a style object or an invoked template with "Style" in its name.
+  bool isStyle() const;
+  // Rebuild the source, replacing every identifier for which the lookup returns a value.
+  std::string substitute(const std::function<const std::string*(std::string_view)>& lookup) const;
+
+private:
+  Lexer ownLexer{};
+  const Lexer* lexer{&ownLexer};
+  size_t begin{0};
+  size_t end{0};
+  std::vector<Node> nodes{};
+  std::string error{};
+
+  size_t skipComments(size_t) const;
+  int32_t parseNode(size_t&);
+  int32_t parseList(size_t&, char close);
+  bool fail(size_t, const std::string&);
+};
+
+struct StyleTree::Node {
+  enum class Type : uint8_t {
+    IDENTIFIER,
+    NUMBER,
+    STRING,
+    REFERENCE,
+    EXPRESSION,
+  } type{Type::IDENTIFIER};
+  bool templated{false};
+  bool invoked{false};
+
+  // Token range [begin, end) covered by this node.
+  uint32_t begin{0};
+  uint32_t end{0};
+
+  int32_t firstArg{NONE};  // Template arguments
+  int32_t firstCallArg{NONE};
+  int32_t next{NONE};
+};
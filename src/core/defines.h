@@ -54,6 +54,10 @@
 #define PROFFIEOS_INO PROFFIEOS_PATH "\\ProffieOS.ino"
 #define CONFIG_DIR PROFFIEOS_PATH "\\config\\"
 #define PROPCONFIG_DIR RESOURCES_PATH "props\\"
+#define BUILDCACHE_DIR RESOURCES_PATH "buildcache\\"
+#define BUILD_DIR RESOURCES_PATH "build\\"
+#define BATCH_DIR RESOURCES_PATH "batch\\"
+#define PROPCACHE_DIR RESOURCES_PATH "propcache\\"
 #define DRIVER_INSTALL popen("title ProffieConfig Worker & resources\\windowmode -title \"ProffieConfig Worker\" -mode force_minimized & resources\\proffie-dfu-setup.exe 2>&1", "r")
 #define STYLEEDIT_PATH RESOURCES_PATH "StyleEditor\\style_editor.html"
 #elif defined(__WXGTK__)
@@ -62,6 +66,10 @@
 #define PROFFIEOS_INO PROFFIEOS_PATH "/ProffieOS.ino"
 #define CONFIG_DIR PROFFIEOS_PATH "/config/"
 #define PROPCONFIG_DIR RESOURCES_PATH "props/"
+#define BUILDCACHE_DIR RESOURCES_PATH "buildcache/"
+#define BUILD_DIR RESOURCES_PATH "build/"
+#define BATCH_DIR RESOURCES_PATH "batch/"
+#define PROPCACHE_DIR RESOURCES_PATH "propcache/"
 #define STYLEEDIT_PATH RESOURCES_PATH "StyleEditor/style_editor.html"
 #define DRIVER_INSTALL popen("pkexec cp ~/.arduino15/packages/proffieboard/hardware/stm32l4/3.6/drivers/linux/*rules /etc/udev/rules.d", "r")
 #elif defined(__WXOSX__)
@@ -70,6 +78,10 @@
 #define PROFFIEOS_INO PROFFIEOS_PATH "/ProffieOS.ino"
 #define CONFIG_DIR PROFFIEOS_PATH "/config/"
 #define PROPCONFIG_DIR RESOURCES_PATH "props/"
+#define BUILDCACHE_DIR RESOURCES_PATH "buildcache/"
+#define BUILD_DIR RESOURCES_PATH "build/"
+#define BATCH_DIR RESOURCES_PATH "batch/"
+#define PROPCACHE_DIR RESOURCES_PATH "propcache/"
 #define DRIVER_INSTALL popen("", "r");
 #define STYLEEDIT_PATH RESOURCES_PATH "StyleEditor/style_editor.html"
 #endif
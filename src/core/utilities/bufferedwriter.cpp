@@ -0,0 +1,78 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "core/utilities/bufferedwriter.h"
+
+#include <charconv>
+#include <cstdio>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+void BufferedWriter::clear() { buffer.clear(); }
+const std::string& BufferedWriter::str() const { return buffer; }
+
+BufferedWriter& BufferedWriter::operator<<(std::string_view str) {
+  buffer.append(str);
+  return *this;
+}
+BufferedWriter& BufferedWriter::operator<<(const char* str) { return *this << std::string_view(str); }
+BufferedWriter& BufferedWriter::operator<<(const std::string& str) { return *this << std::string_view(str); }
+BufferedWriter& BufferedWriter::operator<<(const wxString& str) {
+  buffer.append(str.utf8_str());
+  return *this;
+}
+BufferedWriter& BufferedWriter::operator<<(char chr) {
+  buffer.push_back(chr);
+  return *this;
+}
+BufferedWriter& BufferedWriter::operator<<(double value) {
+  // Same formatting an ostream uses by default
+  char str[32];
+  auto length = std::snprintf(str, sizeof(str), "%g", value);
+  if (length > 0) buffer.append(str, static_cast<size_t>(length));
+  return *this;
+}
+
+BufferedWriter& BufferedWriter::appendInteger(int64_t value) {
+  char str[24];
+  auto result = std::to_chars(str, str + sizeof(str), value);
+  buffer.append(str, result.ptr);
+  return *this;
+}
+BufferedWriter& BufferedWriter::appendInteger(uint64_t value) {
+  char str[24];
+  auto result = std::to_chars(str, str + sizeof(str), value);
+  buffer.append(str, result.ptr);
+  return *this;
+}
+
+bool BufferedWriter::commit(const std::string& filePath) const {
+  const auto tmpPath = filePath + ".tmp";
+  auto file = std::fopen(tmpPath.c_str(), "wb");
+  if (file == nullptr) return false;
+
+  auto written = std::fwrite(buffer.data(), 1, buffer.size(), file);
+  bool synced{true};
+# ifndef __WINDOWS__
+  // Otherwise after a crash the rename may have stuck while the contents didn't, leaving an empty file
+  synced = std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+# endif
+  if (std::fclose(file) != 0 || written != buffer.size() || !synced) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+
+# ifdef __WINDOWS__
+  if (!MoveFileExA(tmpPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+# else
+  if (std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+# endif
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
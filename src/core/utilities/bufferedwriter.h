@@ -0,0 +1,41 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <wx/string.h>
+
+// Formats output into one growable buffer, which is then written out in a
+// single call. commit() goes through a temporary file and a rename, so the
+// destination either keeps its old contents or gets all of the new ones.
+class BufferedWriter {
+public:
+  BufferedWriter() = default;
+  BufferedWriter(const BufferedWriter&) = delete;
+
+  // Empties the buffer but keeps its capacity for the next use.
+  void clear();
+  const std::string& str() const;
+
+  BufferedWriter& operator<<(std::string_view);
+  BufferedWriter& operator<<(const char*);
+  BufferedWriter& operator<<(const std::string&);
+  BufferedWriter& operator<<(const wxString&);
+  BufferedWriter& operator<<(char);
+  BufferedWriter& operator<<(double);
+
+  template <typename T, typename std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>, int> = 0>
+  BufferedWriter& operator<<(T value) { return appendInteger(static_cast<std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>(value)); }
+
+  bool commit(const std::string& filePath) const;
+
+private:
+  std::string buffer{};
+
+  BufferedWriter& appendInteger(int64_t);
+  BufferedWriter& appendInteger(uint64_t);
+};
@@ -7,6 +7,11 @@
 #include <cstdint>
 #include <iostream>
 
+namespace FileParse {
+  // Value after the ':' with quotes/junk stripped, empty if there isn't a usable one
+  std::string cleanValue(const std::string& line, int32_t lineNum = 0);
+}
+
 std::vector<std::string> FileParse::extractSection(std::string sectionName, std::vector<std::string>& search) {
   std::vector<std::string> section;
 
@@ -38,43 +43,18 @@ std::vector<std::string> FileParse::extractSection(std::string sectionName, std:
   return section;
 }
 std::string FileParse::parseEntry(std::string entry, std::vector<std::string>& search, std::string& label) {
-  for (auto line = search.begin(); line < search.end(); line++) {
-    if ((*line).find(entry) == std::string::npos) continue;
-
-    size_t index = (*line).find(":");
-    if (index == std::string::npos) {
-      std::cerr << "Malformed entry \"" << *line << "\" found, skipping..." << std::endl;
-      search.erase(line);
-      line = search.begin();
+  for (auto line = search.begin(); line < search.end();) {
+    if ((*line).find(entry) == std::string::npos) {
+      line++;
       continue;
     }
 
-    std::string output = (*line).substr(index + 1);
+    auto output = cleanValue(*line);
     if (output.empty()) {
-      std::cerr << "Empty entry \"" << *line << "\" found, skipping..." << std::endl;
-      search.erase(line);
-      line = search.begin();
+      line = search.erase(line);
       continue;
     }
 
-    if (output.find("\"") != std::string::npos) output = output.substr(output.find_first_of("\"") + 1, output.find_last_of("\"") - output.find_first_of("\"") - 1);
-    else if (output.find("TRUE") != std::string::npos) output = "TRUE";
-    else if (output.find("FALSE") != std::string::npos) output = "FALSE";
-    else {
-      for (auto it = output.begin(); it < output.end(); it++) {
-        if (std::isdigit(*it)) {
-          output = { it, output.end() };
-          break;
-        }
-      }
-      if (!std::isdigit(output.at(0))) {
-        std::cerr << "Malformed entry \"" << *line << "\" found, skipping..." << std::endl;
-        search.erase(line);
-        line = search.begin();
-        continue;
-      }
-    }
-
     label = FileParse::parseLabel(*line);
     search.erase(line);
 
@@ -96,8 +76,10 @@ bool FileParse::parseBoolEntry(std::string entry, std::vector<std::string>& sear
   return (FileParse::parseEntry(entry, search) == "TRUE");
 }
 std::vector<std::string> FileParse::parseListEntry(std::string entry, std::vector<std::string>& search) {
+  return parseList(parseEntry(entry, search));
+}
+std::vector<std::string> FileParse::parseList(std::string stringList) {
   std::vector<std::string> parsedList;
-  std::string stringList = parseEntry(entry, search);
   const std::string removeChars = " \"";
 
   if (stringList.empty()) return {};
@@ -116,3 +98,108 @@ std::string FileParse::parseLabel(const std::string& entry) {
   if (entry.find("(\"") == std::string::npos || entry.find("\")") == std::string::npos) return {};
   return entry.substr(entry.find("(\"") + 2, entry.find("\")") - entry.find("(\"") - 2);
 }
+
+std::string FileParse::cleanValue(const std::string& line, int32_t lineNum) {
+  const auto where{lineNum ? " on line " + std::to_string(lineNum) : std::string{}};
+  size_t index = line.find(":");
+  if (index == std::string::npos) {
+    std::cerr << "Malformed entry \"" << line << "\"" << where << " found, skipping..." << std::endl;
+    return {};
+  }
+
+  std::string output = line.substr(index + 1);
+  if (output.empty()) {
+    std::cerr << "Empty entry \"" << line << "\"" << where << " found, skipping..." << std::endl;
+    return {};
+  }
+
+  if (output.find("\"") != std::string::npos) output = output.substr(output.find_first_of("\"") + 1, output.find_last_of("\"") - output.find_first_of("\"") - 1);
+  else if (output.find("TRUE") != std::string::npos) output = "TRUE";
+  else if (output.find("FALSE") != std::string::npos) output = "FALSE";
+  else {
+    auto digit = std::find_if(output.begin(), output.end(), [](char c) { return std::isdigit(c); });
+    if (digit == output.end()) {
+      std::cerr << "Malformed entry \"" << line << "\"" << where << " found, skipping..." << std::endl;
+      return {};
+    }
+    output = { digit, output.end() };
+  }
+
+  return output;
+}
+
+bool FileParse::parseTree(std::istream& file, Node& root, std::string& error) {
+  root = Node{};
+  root.isSection = true;
+
+  // Sections open on a line ending in '{' and close on a line starting with '}',
+  // anything else is a child of whatever section is open.
+  std::vector<Node*> open{ &root };
+  std::string line;
+  int32_t lineNum{0};
+  while (std::getline(file, line)) {
+    lineNum++;
+    line = line.substr(0, line.find("//"));
+    const auto begin{line.find_first_not_of(" \t\r")};
+    if (begin == std::string::npos) continue;
+    line = line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1);
+
+    if (line.front() == '}') {
+      if (open.size() == 1) {
+        error = "Unexpected '}' on line " + std::to_string(lineNum);
+        return false;
+      }
+      open.pop_back();
+      continue;
+    }
+
+    Node node;
+    node.line = lineNum;
+    node.text = line;
+    node.label = parseLabel(line);
+    node.name = line.substr(0, std::min(line.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_"), line.size()));
+    node.isSection = line.back() == '{';
+    if (!node.isSection && line.find(':') != std::string::npos) node.value = line.substr(line.find(':') + 1);
+
+    open.back()->children.push_back(std::move(node));
+    // Fine to hold onto, nothing gets added to the parent until this closes
+    if (open.back()->children.back().isSection) open.push_back(&open.back()->children.back());
+  }
+
+  if (open.size() > 1) {
+    error = "Section \"" + open.back()->name + "\" on line " + std::to_string(open.back()->line) + " is never closed";
+    return false;
+  }
+  return true;
+}
+std::string FileParse::parseValue(const Node& node) {
+  return cleanValue(node.text, node.line);
+}
+
+const FileParse::Node* FileParse::Node::find(const std::string& search) const {
+  for (const auto& child : children) {
+    if (child.name == search) return &child;
+  }
+  return nullptr;
+}
+std::string FileParse::Node::entry(const std::string& search) const {
+  for (const auto& child : children) {
+    if (child.isSection || child.name != search) continue;
+
+    auto output = parseValue(child);
+    if (!output.empty()) return output;
+  }
+  return {};
+}
+double FileParse::Node::numEntry(const std::string& search) const {
+  auto output = entry(search);
+  if (!output.empty()) return stod(output);
+
+  return -1;
+}
+bool FileParse::Node::boolEntry(const std::string& search) const {
+  return entry(search) == "TRUE";
+}
+std::vector<std::string> FileParse::Node::listEntry(const std::string& search) const {
+  return parseList(entry(search));
+}
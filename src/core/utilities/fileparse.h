@@ -3,10 +3,36 @@
 
 #pragma once
 
+#include <cstdint>
+#include <istream>
 #include <string>
 #include <vector>
 
 namespace FileParse {
+  // A line of a .pconf style file, or a { } section along with everything in it.
+  struct Node {
+    std::string name{};  // Leading identifier, e.g. "TOGGLE" or "NAME"
+    std::string label{}; // From NAME("label")
+    std::string value{}; // Everything after the first ':' (entries only)
+    std::string text{};  // The whole line, trimmed
+    int32_t line{0};
+    bool isSection{false};
+    std::vector<Node> children{};
+
+    [[nodiscard]] const Node* find(const std::string& name) const;
+    // Same as the functions below, but looks up the first well-formed child entry
+    [[nodiscard]] std::string entry(const std::string& name) const;
+    [[nodiscard]] double numEntry(const std::string& name) const;
+    [[nodiscard]] bool boolEntry(const std::string& name) const;
+    [[nodiscard]] std::vector<std::string> listEntry(const std::string& name) const;
+  };
+  // Builds the whole tree in one pass, children of root are the top-level lines/sections.
+  [[nodiscard]] bool parseTree(std::istream&, Node& root, std::string& error);
+  // Cleaned up value of an entry, empty (with a warning) if malformed
+  [[nodiscard]] std::string parseValue(const Node&);
+  [[nodiscard]] std::vector<std::string> parseList(std::string);
+
+
   [[nodiscard]] std::vector<std::string> extractSection(std::string, std::vector<std::string>&);
   [[nodiscard]] std::string parseEntry(std::string, std::vector<std::string>&);
   [[nodiscard]] std::string parseEntry(std::string, std::vector<std::string>&, std::string&);
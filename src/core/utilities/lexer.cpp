@@ -0,0 +1,186 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "core/utilities/lexer.h"
+
+#include <cctype>
+#include <fstream>
+
+const Lexer::Token Lexer::Stream::endToken{};
+
+bool Lexer::readFile(const std::string& filePath) {
+  std::ifstream file(filePath, std::ios::binary);
+  if (!file.is_open()) return false;
+
+  file.seekg(0, std::ios::end);
+  auto size = file.tellg();
+  if (size < 0) return false;
+  file.seekg(0, std::ios::beg);
+
+  source.resize(static_cast<size_t>(size));
+  file.read(source.data(), size);
+  source.resize(static_cast<size_t>(file.gcount()));
+  file.close();
+
+  tokenize();
+  return true;
+}
+void Lexer::readString(std::string _source) {
+  source = std::move(_source);
+  tokenize();
+}
+
+const std::string& Lexer::getSource() const { return source; }
+const std::vector<Lexer::Token>& Lexer::getTokens() const { return tokens; }
+
+std::string_view Lexer::slice(size_t begin, size_t end) const {
+  if (begin > source.size()) begin = source.size();
+  if (end > source.size()) end = source.size();
+  if (end < begin) end = begin;
+  return std::string_view(source).substr(begin, end - begin);
+}
+std::string_view Lexer::restOfLine(const Token& token) const {
+  auto lineEnd = source.find('\n', token.end());
+  if (lineEnd == std::string::npos) lineEnd = source.size();
+  auto line = slice(token.end(), lineEnd);
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return line;
+}
+
+void Lexer::tokenize() {
+  tokens.clear();
+  tokens.reserve(source.size() / 4);
+
+  const char* data = source.data();
+  const size_t size = source.size();
+  size_t pos{0};
+  int32_t line{1};
+  bool lineStart{true};
+
+  auto isIdentChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+  auto push = [&](Token::Type type, size_t begin, int32_t beginLine) {
+    tokens.push_back({ type, std::string_view(data + begin, pos - begin), begin, beginLine });
+  };
+
+  while (pos < size) {
+    const char c = data[pos];
+    const char next = pos + 1 < size ? data[pos + 1] : '\0';
+    const size_t begin = pos;
+    const int32_t beginLine = line;
+
+    if (c == '\n') {
+      line++;
+      lineStart = true;
+      pos++;
+      continue;
+    }
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      pos++;
+      continue;
+    }
+
+    if (c == '/' && next == '/') {
+      while (pos < size && data[pos] != '\n') pos++;
+      if (pos > begin && data[pos - 1] == '\r') pos--;
+      push(Token::Type::COMMENT, begin, beginLine);
+      continue;
+    }
+    if (c == '/' && next == '*') {
+      pos += 2;
+      while (pos < size && !(data[pos] == '*' && pos + 1 < size && data[pos + 1] == '/')) {
+        if (data[pos] == '\n') line++;
+        pos++;
+      }
+      pos = pos + 2 < size ? pos + 2 : size;
+      push(Token::Type::COMMENT, begin, beginLine);
+      continue;
+    }
+
+    const bool wasLineStart = lineStart;
+    lineStart = false;
+
+    if (c == '#' && wasLineStart) {
+      pos++;
+      while (pos < size && (data[pos] == ' ' || data[pos] == '\t')) pos++;
+      while (pos < size && isIdentChar(data[pos])) pos++;
+      push(Token::Type::DIRECTIVE, begin, beginLine);
+    } else if (c == '"' || c == '\'') {
+      pos++;
+      while (pos < size && data[pos] != c && data[pos] != '\n') {
+        if (data[pos] == '\\' && pos + 1 < size && data[pos + 1] != '\n') pos++;
+        pos++;
+      }
+      if (pos < size && data[pos] == c) pos++;
+      push(Token::Type::STRING, begin, beginLine);
+    } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      while (pos < size && isIdentChar(data[pos])) pos++;
+      push(Token::Type::IDENTIFIER, begin, beginLine);
+    } else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && std::isdigit(static_cast<unsigned char>(next)))) {
+      while (pos < size) {
+        if (isIdentChar(data[pos]) || data[pos] == '.') pos++;
+        else if ((data[pos] == '+' || data[pos] == '-') && (data[pos - 1] == 'e' || data[pos - 1] == 'E')) pos++;
+        else break;
+      }
+      push(Token::Type::NUMBER, begin, beginLine);
+    } else if (c == '<') {
+      pos++;
+      push(Token::Type::TEMPLATE_OPEN, begin, beginLine);
+    } else if (c == '>') {
+      pos++;
+      push(Token::Type::TEMPLATE_CLOSE, begin, beginLine);
+    } else if (c == ':' && next == ':') {
+      pos += 2;
+      push(Token::Type::PUNCTUATION, begin, beginLine);
+    } else {
+      pos++;
+      push(Token::Type::PUNCTUATION, begin, beginLine);
+    }
+  }
+}
+
+std::string_view Lexer::Token::unquoted() const {
+  if (type != Type::STRING || text.size() < 2) return text;
+  auto contents = text.substr(1);
+  if (contents.back() == text.front()) contents.remove_suffix(1);
+  return contents;
+}
+
+Lexer::Stream::Stream(const Lexer& _lexer) : lexer(_lexer), endIndex(_lexer.getTokens().size()) {}
+Lexer::Stream::Stream(const Lexer& _lexer, size_t _begin, size_t _end) : lexer(_lexer), index(_begin), endIndex(_end < _lexer.getTokens().size() ? _end : _lexer.getTokens().size()) {}
+
+bool Lexer::Stream::eof() const { return index >= endIndex; }
+size_t Lexer::Stream::position() const { return index; }
+void Lexer::Stream::seek(size_t _index) { index = _index < endIndex ? _index : endIndex; }
+const Lexer& Lexer::Stream::getLexer() const { return lexer; }
+
+const Lexer::Token& Lexer::Stream::peek(size_t ahead) const {
+  if (index + ahead >= endIndex) return endToken;
+  return lexer.getTokens()[index + ahead];
+}
+const Lexer::Token& Lexer::Stream::next() {
+  if (index >= endIndex) return endToken;
+  return lexer.getTokens()[index++];
+}
+const Lexer::Token& Lexer::Stream::peekCode() const {
+  for (auto idx = index; idx < endIndex; idx++) {
+    if (lexer.getTokens()[idx].type != Token::Type::COMMENT) return lexer.getTokens()[idx];
+  }
+  return endToken;
+}
+const Lexer::Token& Lexer::Stream::nextCode() {
+  while (index < endIndex && lexer.getTokens()[index].type == Token::Type::COMMENT) index++;
+  return next();
+}
+
+void Lexer::Stream::skipLine(int32_t line) {
+  while (index < endIndex && lexer.getTokens()[index].line <= line) index++;
+}
+void Lexer::Stream::skipToEndif() {
+  int32_t depth{1};
+  while (!eof()) {
+    const auto& token = next();
+    if (token.type != Token::Type::DIRECTIVE) continue;
+    if (token.text.rfind("#if", 0) == 0) depth++;
+    else if (token.text.rfind("#endif", 0) == 0 && --depth == 0) return;
+  }
+}
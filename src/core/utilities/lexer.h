@@ -0,0 +1,93 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reads a whole file (or string) once and splits it into C++-ish tokens.
+// Token text views point into the lexer's own copy of the source, so a Lexer
+// must outlive any tokens or views taken from it.
+class Lexer {
+public:
+  struct Token;
+  class Stream;
+
+  Lexer() = default;
+  Lexer(const Lexer&) = delete;
+  Lexer(Lexer&&) = delete;
+
+  bool readFile(const std::string&);
+  void readString(std::string);
+
+  const std::string& getSource() const;
+  const std::vector<Token>& getTokens() const;
+
+  std::string_view slice(size_t begin, size_t end) const;
+  // Source text after the token up to (not including) the end of its line.
+  std::string_view restOfLine(const Token&) const;
+
+private:
+  std::string source{};
+  std::vector<Token> tokens{};
+
+  void tokenize();
+};
+
+struct Lexer::Token {
+  enum class Type {
+    IDENTIFIER,
+    NUMBER,
+    STRING,
+    COMMENT,
+    DIRECTIVE,
+    TEMPLATE_OPEN,
+    TEMPLATE_CLOSE,
+    PUNCTUATION,
+    END,
+  } type{Type::END};
+
+  std::string_view text{};
+  size_t offset{0};
+  int32_t line{0};
+
+  size_t end() const { return offset + text.size(); }
+  bool is(Type _type) const { return type == _type; }
+  bool is(Type _type, std::string_view _text) const { return type == _type && text == _text; }
+  bool isPunct(char punct) const { return type == Type::PUNCTUATION && text.size() == 1 && text[0] == punct; }
+  // Contents of a string literal without the surrounding quotes.
+  std::string_view unquoted() const;
+};
+
+class Lexer::Stream {
+public:
+  Stream(const Lexer&);
+  Stream(const Lexer&, size_t begin, size_t end);
+
+  bool eof() const;
+  size_t position() const;
+  void seek(size_t);
+
+  const Token& peek(size_t ahead = 0) const;
+  const Token& next();
+  // Same as peek/next, but comments are passed over.
+  const Token& peekCode() const;
+  const Token& nextCode();
+
+  // Advance past every remaining token on the given line.
+  void skipLine(int32_t);
+  // Advance to the directive closing the current #if/#ifdef level, consuming it.
+  void skipToEndif();
+
+  const Lexer& getLexer() const;
+
+private:
+  const Lexer& lexer;
+  size_t index{0};
+  size_t endIndex{0};
+
+  static const Token endToken;
+};
@@ -0,0 +1,37 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Fixed-capacity FIFO, once full each push drops the oldest element.
+// Index 0 is always the oldest element still held.
+template <typename T>
+class RingBuffer {
+public:
+  RingBuffer(size_t capacity) : data(capacity ? capacity : 1) {}
+
+  void push(T value) {
+    data[(start + count) % data.size()] = std::move(value);
+    if (count < data.size()) count++;
+    else start = (start + 1) % data.size();
+  }
+  void clear() { start = count = 0; }
+
+  T& operator[](size_t idx) { return data[(start + idx) % data.size()]; }
+  const T& operator[](size_t idx) const { return data[(start + idx) % data.size()]; }
+  T& back() { return (*this)[count - 1]; }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return data.size(); }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == data.size(); }
+
+private:
+  std::vector<T> data;
+  size_t start{0};
+  size_t count{0};
+};
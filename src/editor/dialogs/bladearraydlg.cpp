@@ -19,7 +19,7 @@
 #include <wx/msgdlg.h>
 #endif
 
-BladeArrayDlg::BladeArrayDlg(EditorWindow* _parent) : wxDialog(_parent, wxID_ANY, "Blade Awareness - " + _parent->getOpenConfig(), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER), parent(_parent) {
+BladeArrayDlg::BladeArrayDlg(EditorWindow* _parent) : wxDialog(_parent, wxID_ANY, "Blade Awareness - " + _parent->getOpenConfig(), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER), bladeArrays(_parent->model.bladeArrays), parent(_parent) {
   sizer = new wxBoxSizer(wxVERTICAL);
 
   wxBoxSizer* enableSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -48,6 +48,58 @@ BladeArrayDlg::BladeArrayDlg(EditorWindow* _parent) : wxDialog(_parent, wxID_ANY
   FULLUPDATEWINDOW(this);
 }
 
+void BladeArrayDlg::loadModel(const ConfigModel& config) {
+  const auto& awareness{config.bladeAwareness};
+  enableDetect->SetValue(awareness.enableDetect);
+  detectPin->entry()->SetValue(awareness.detectPin);
+
+  enableID->SetValue(awareness.enableID);
+  mode->entry()->SetStringSelection(awareness.mode);
+  IDPin->entry()->SetValue(awareness.IDPin);
+  pullupResistance->entry()->SetValue(awareness.pullupResistance);
+  pullupPin->entry()->SetValue(awareness.pullupPin);
+
+  enablePowerForID->SetValue(awareness.enablePowerForID);
+  powerPin1->SetValue(awareness.powerPins[0]);
+  powerPin2->SetValue(awareness.powerPins[1]);
+  powerPin3->SetValue(awareness.powerPins[2]);
+  powerPin4->SetValue(awareness.powerPins[3]);
+  powerPin5->SetValue(awareness.powerPins[4]);
+  powerPin6->SetValue(awareness.powerPins[5]);
+
+  continuousScans->SetValue(awareness.continuousScans);
+  numIDTimes->entry()->SetValue(awareness.numIDTimes);
+  scanIDMillis->entry()->SetValue(awareness.scanIDMillis);
+
+  lastArraySelection = -1;
+  update();
+}
+void BladeArrayDlg::saveModel(ConfigModel& config) {
+  auto& awareness{config.bladeAwareness};
+  awareness.enableDetect = enableDetect->GetValue();
+  awareness.detectPin = detectPin->entry()->GetValue().ToStdString();
+
+  awareness.enableID = enableID->GetValue();
+  awareness.mode = mode->entry()->GetStringSelection().ToStdString();
+  awareness.IDPin = IDPin->entry()->GetValue().ToStdString();
+  awareness.pullupResistance = pullupResistance->entry()->GetValue();
+  awareness.pullupPin = pullupPin->entry()->GetValue().ToStdString();
+
+  awareness.enablePowerForID = enablePowerForID->GetValue();
+  awareness.powerPins = {
+    powerPin1->GetValue(),
+    powerPin2->GetValue(),
+    powerPin3->GetValue(),
+    powerPin4->GetValue(),
+    powerPin5->GetValue(),
+    powerPin6->GetValue(),
+  };
+
+  awareness.continuousScans = continuousScans->GetValue();
+  awareness.numIDTimes = numIDTimes->entry()->GetValue();
+  awareness.scanIDMillis = scanIDMillis->entry()->GetValue();
+}
+
 void BladeArrayDlg::bindEvents() {
   Bind(wxEVT_CLOSE_WINDOW, [&](wxCloseEvent& event) {
     if (event.CanVeto()) {
@@ -13,15 +13,13 @@
 #include <wx/combobox.h>
 #include <wx/listbox.h>
 
-constexpr auto BLADE_ID_MODE_SNAPSHOT{"Snapshot"};
-constexpr auto BLADE_ID_MODE_EXTERNAL{"External Pullup"};
-constexpr auto BLADE_ID_MODE_BRIDGED {"Bridged Pullup"};
-
 class BladeArrayDlg : public wxDialog {
 public:
   BladeArrayDlg(EditorWindow*);
 
   void update();
+  void loadModel(const ConfigModel&);
+  void saveModel(ConfigModel&);
 
   wxCheckBox* enableID{nullptr};
   wxCheckBox* enableDetect{nullptr};
@@ -52,14 +50,8 @@ public:
 
   pcTextCtrl* detectPin{nullptr};
 
-  struct BladeArray {
-    wxString name{""};
-    int32_t value{0};
-
-    std::vector<PresetsPage::PresetConfig> presets{};
-    std::vector<BladesPage::BladeConfig> blades{};
-  };
-  std::vector<BladeArray> bladeArrays{BladeArray{"blade_in", 0}};
+  typedef ConfigModel::BladeArray BladeArray;
+  std::vector<BladeArray>& bladeArrays; // Lives in the editor's model
 
   enum {
     ID_NameEntry,
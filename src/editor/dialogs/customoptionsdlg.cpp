@@ -41,6 +41,17 @@ std::vector<std::pair<std::string, std::string>> CustomOptionsDlg::getCustomDefi
   return outputDefines;
 }
 
+void CustomOptionsDlg::setDefines(const std::vector<std::pair<std::string, std::string>>& defines) {
+  for (auto define : customDefines) {
+    optionArea->GetSizer()->Detach(define);
+    define->Destroy();
+  }
+  customDefines.clear();
+
+  for (const auto& [ name, value ] : defines) addDefine(name, value);
+  updateOptions();
+}
+
 void CustomOptionsDlg::bindEvents() {
     Bind(wxEVT_CLOSE_WINDOW, [&](wxCloseEvent& event) {
         updateOptions(true);
@@ -14,6 +14,8 @@ public:
   CustomOptionsDlg(EditorWindow*);
   void addDefine(const std::string&, const std::string& = "");
   std::vector<std::pair<std::string, std::string>> getCustomDefines();
+  // Replaces all current defines
+  void setDefines(const std::vector<std::pair<std::string, std::string>>&);
 
   enum {
     ID_AddDefine,
@@ -7,8 +7,8 @@
 #include "editor/pages/generalpage.h"
 #include "editor/pages/presetspage.h"
 #include "editor/pages/propspage.h"
+#include "editor/dialogs/bladearraydlg.h"
 
-#include "core/config/settings.h"
 #include "core/config/configuration.h"
 #include "core/defines.h"
 #include "core/utilities/misc.h"
@@ -39,7 +39,7 @@ EditorWindow::EditorWindow(const std::string& _configName, wxWindow* parent) : w
   createPages();
   bindEvents();
   createToolTips();
-  settings = new Settings(this);
+  loadModel();
 
 # ifdef __WINDOWS__
   SetIcon( wxICON(IDI_ICON1) );
@@ -47,8 +47,28 @@ EditorWindow::EditorWindow(const std::string& _configName, wxWindow* parent) : w
 # endif
   sizer->SetMinSize(450, -1);
 }
-EditorWindow::~EditorWindow() {
-  delete settings;
+EditorWindow::~EditorWindow() {}
+
+void EditorWindow::loadModel() {
+  // Props first, it claims its defines from the custom ones
+  propsPage->loadModel(model);
+  generalPage->loadModel(model);
+  // Before the dialog, whose update() would otherwise save the old selection into the new arrays
+  bladesPage->loadModel(model);
+  bladesPage->bladeArrayDlg->loadModel(model);
+
+  propsPage->update();
+  bladesPage->update();
+  presetsPage->update();
+}
+void EditorWindow::saveModel() {
+  presetsPage->update();
+  bladesPage->update();
+  bladesPage->bladeArrayDlg->update();
+
+  generalPage->saveModel(model);
+  bladesPage->bladeArrayDlg->saveModel(model);
+  propsPage->saveModel(model);
 }
 
 void EditorWindow::bindEvents() {
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "core/config/configmodel.h"
 #include "ui/pcchoice.h"
 
 #include <wx/frame.h>
@@ -14,7 +15,6 @@ class PropsPage;
 class BladesPage;
 class PresetsPage;
 class BladeArrayDlg;
-class Settings;
 
 class EditorWindow : public wxFrame {
 public:
@@ -23,11 +23,15 @@ public:
 
   const std::string& getOpenConfig();
 
+  // Sync the pages with the model
+  void loadModel();
+  void saveModel();
+  ConfigModel model{};
+
   GeneralPage* generalPage{nullptr};
   PropsPage* propsPage{nullptr};
   BladesPage* bladesPage{nullptr};
   PresetsPage* presetsPage{nullptr};
-  Settings* settings{nullptr};
 
   wxBoxSizer* sizer{nullptr};
 
@@ -249,6 +249,19 @@ void BladesPage::update() {
   setVisibility();
 }
 
+void BladesPage::loadModel(const ConfigModel& model) {
+  // The arrays were replaced, so there's no previous selection to save
+  lastBladeArraySelection = -1;
+
+  for (const auto& array : model.bladeArrays) {
+    for (const auto& blade : array.blades) {
+      for (const auto& powerPin : blade.powerPins) {
+        if (powerPins->FindString(powerPin) == wxNOT_FOUND) powerPins->Append(powerPin);
+      }
+    }
+  }
+}
+
 void BladesPage::saveCurrent() {
   if (lastBladeArraySelection < 0 ||
     lastBladeArraySelection > (int32_t)bladeArrayDlg->bladeArrays.size() ||
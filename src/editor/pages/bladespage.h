@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "core/config/configmodel.h"
 #include "ui/pcspinctrl.h"
 #include "ui/pctextctrl.h"
 #include "ui/pccombobox.h"
@@ -21,13 +22,6 @@
 #include <wx/checklst.h>
 #include <wx/radiobut.h>
 
-#define BD_PIXELRGB "WS281X (RGB)"
-#define BD_PIXELRGBW "WS281X (RGBW)"
-#define BD_TRISTAR "Tri-LED Star"
-#define BD_QUADSTAR "Quad-LED Star"
-#define BD_SINGLELED "Single Color"
-#define BD_NORESISTANCE "<None>"
-
 #define BD_HASSELECTION (bladeSelect->GetSelection() != -1)
 #define BD_SUBHASSELECTION (subBladeSelect->GetSelection() != -1)
 #define BD_ISPIXEL3 (BD_HASSELECTION && bladeArrayDlg->bladeArrays[bladeArray->entry()->GetSelection()].blades[bladeSelect->GetSelection()].type == BD_PIXELRGB)
@@ -47,6 +41,7 @@ public:
   BladesPage(wxWindow*);
 
   void update();
+  void loadModel(const ConfigModel&);
 
   void addBlade();
   void addSubBlade();
@@ -109,35 +104,7 @@ public:
     ID_PowerPinName,
   };
 
-  struct BladeConfig {
-    wxString type{BD_PIXELRGB};
-
-    wxString dataPin{"bladePin"};
-    wxString colorType{"GRB"};
-    int32_t numPixels{0};
-    bool useRGBWithWhite{false};
-
-    wxString Star1{BD_NORESISTANCE};
-    wxString Star2{BD_NORESISTANCE};
-    wxString Star3{BD_NORESISTANCE};
-    wxString Star4{BD_NORESISTANCE};
-    int32_t Star1Resistance{0};
-    int32_t Star2Resistance{0};
-    int32_t Star3Resistance{0};
-    int32_t Star4Resistance{0};
-
-    std::vector<std::string> powerPins;
-
-    bool isSubBlade{false};
-    bool useStride{false};
-    bool useZigZag{false};
-
-    struct subBladeInfo {
-      uint32_t startPixel{0};
-      uint32_t endPixel{0};
-    };
-    std::vector<subBladeInfo> subBlades{};
-  };
+  typedef ConfigModel::Blade BladeConfig;
 
 private:
   EditorWindow* parent{nullptr};
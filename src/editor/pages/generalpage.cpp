@@ -28,6 +28,62 @@ GeneralPage::GeneralPage(EditorWindow* _parent) : wxStaticBoxSizer(wxVERTICAL, _
   createToolTips();
 }
 
+void GeneralPage::loadModel(const ConfigModel& config) {
+  const auto& general{config.general};
+  board->entry()->SetSelection(general.board);
+  massStorage->SetValue(general.massStorage);
+  webUSB->SetValue(general.webUSB);
+
+  orientation->entry()->SetStringSelection(Configuration::findInVMap(Configuration::Orientation, general.orientation).first);
+  buttons->entry()->SetValue(general.buttons);
+  volume->entry()->SetValue(general.volume);
+  clash->entry()->SetValue(general.clash);
+  pliTime->entry()->SetValue(general.pliTime);
+  idleTime->entry()->SetValue(general.idleTime);
+  motionTime->entry()->SetValue(general.motionTime);
+  maxLEDs->entry()->SetValue(general.maxLEDs);
+
+  volumeSave->SetValue(general.volumeSave);
+  presetSave->SetValue(general.presetSave);
+  colorSave->SetValue(general.colorSave);
+  enableOLED->SetValue(general.enableOLED);
+  disableColor->SetValue(general.disableColor);
+  noTalkie->SetValue(general.noTalkie);
+  noBasicParsers->SetValue(general.noBasicParsers);
+  disableDiagnosticCommands->SetValue(general.disableDiagnosticCommands);
+
+  customOptDlg->setDefines(config.customDefines);
+}
+void GeneralPage::saveModel(ConfigModel& config) {
+  auto& general{config.general};
+  general.board = board->entry()->GetSelection();
+  general.massStorage = massStorage->GetValue();
+  general.webUSB = webUSB->GetValue();
+
+  general.orientation = Configuration::findInVMap(Configuration::Orientation, orientation->entry()->GetStringSelection().ToStdString()).second;
+  general.buttons = buttons->entry()->GetValue();
+  general.volume = volume->entry()->GetValue();
+  general.clash = clash->entry()->GetValue();
+  general.pliTime = pliTime->entry()->GetValue();
+  general.idleTime = idleTime->entry()->GetValue();
+  general.motionTime = motionTime->entry()->GetValue();
+  general.maxLEDs = maxLEDs->entry()->GetValue();
+
+  general.volumeSave = volumeSave->GetValue();
+  general.presetSave = presetSave->GetValue();
+  general.colorSave = colorSave->GetValue();
+  general.enableOLED = enableOLED->GetValue();
+  general.disableColor = disableColor->GetValue();
+  general.noTalkie = noTalkie->GetValue();
+  general.noBasicParsers = noBasicParsers->GetValue();
+  general.disableDiagnosticCommands = disableDiagnosticCommands->GetValue();
+
+  config.customDefines.clear();
+  for (const auto& define : customOptDlg->getCustomDefines()) {
+    if (!define.first.empty()) config.customDefines.push_back(define);
+  }
+}
+
 void GeneralPage::bindEvents() {
   GetStaticBox()->Bind(wxEVT_BUTTON, [&](wxCommandEvent){
       if (customOptDlg->IsShown()) customOptDlg->Raise();
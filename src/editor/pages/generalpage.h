@@ -20,6 +20,9 @@ class GeneralPage : public wxStaticBoxSizer {
 public:
   GeneralPage(EditorWindow*);
 
+  void loadModel(const ConfigModel&);
+  void saveModel(ConfigModel&);
+
   pcChoice* board{nullptr};
   wxCheckBox* massStorage{nullptr};
   wxCheckBox* webUSB{nullptr};
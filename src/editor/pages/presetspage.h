@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "core/config/configmodel.h"
 #include "editor/editorwindow.h"
 #include "ui/pctextctrl.h"
 
@@ -35,12 +36,7 @@ public:
   pcTextCtrl* dirInput{nullptr};
   pcTextCtrl* trackInput{nullptr};
 
-  struct PresetConfig {
-    std::vector<wxString> styles{};
-    wxString name{""};
-    wxString dirs{""};
-    wxString track{""};
-  };
+  typedef ConfigModel::Preset PresetConfig;
 
   enum {
     ID_BladeArray,
@@ -7,10 +7,12 @@
 #include "core/appstate.h"
 #include "core/utilities/misc.h"
 #include "core/config/propfile.h"
+#include "core/config/settings.h"
 #include "editor/editorwindow.h"
 #include "editor/pages/generalpage.h"
 #include "ui/pcchoice.h"
 
+#include <cstdlib>
 #include <wx/scrolwin.h>
 #include <wx/sizer.h>
 #include <wx/tooltip.h>
@@ -45,10 +47,11 @@ void PropsPage::bindEvents() {
     update();
     updateSizeAndLayout();
   };
-  auto optionSelectUpdate = [&](wxCommandEvent&) {
+  auto optionSelectUpdate = [&](wxCommandEvent& event) {
     int32_t x, y;
     propsWindow->GetViewStart(&x, &y);
-    update();
+    auto selectedProp = getSelectedProp();
+    if (selectedProp) selectedProp->settingChanged(event.GetEventObject());
     propsWindow->Scroll(x, y);
     parent->Layout();
   };
@@ -108,7 +111,7 @@ void PropsPage::bindEvents() {
                   ) : wxString("Button Configuration Not Supported"));
         textSizer->Add(new wxStaticText(&buttonDialog, wxID_ANY, buttons));
       } else {
-        auto propButtons = activeProp->getButtons()->at(parent->generalPage->buttons->entry()->GetValue());
+        const auto& propButtons = activeProp->getButtons()->at(parent->generalPage->buttons->entry()->GetValue());
 
         if (propButtons.empty()) {
           textSizer->Add(new wxStaticText(&buttonDialog, wxID_ANY, "Selected number of buttons not supported by prop file."));
@@ -124,12 +127,12 @@ void PropsPage::bindEvents() {
             stateSizer->Add(controlSizer);
 
             for (auto& button : stateButtons) {
-              std::vector<std::string> activePredicates{};
-              for (const auto& predicate : button.relevantSettings) {
-                auto setting = activeProp->getSettings()->find(predicate);
+              uint64_t activePredicates{0};
+              for (size_t bit = 0; bit < button.relevantSettings.size() && bit < 64; bit++) {
+                auto setting = activeProp->getSettings()->find(button.relevantSettings[bit]);
                 if (setting == activeProp->getSettings()->end()) continue;
 
-                if (!setting->second.getOutput().empty()) activePredicates.push_back(setting->first);
+                if (setting->second.isSet()) activePredicates |= 1ULL << bit;
               }
 
               auto key = button.descriptions.find(activePredicates);
@@ -200,11 +203,53 @@ void PropsPage::update() {
     prop->SetSize(0, 0);
     if (propSelection->entry()->GetStringSelection() != prop->getName()) continue;
 
-    updateDisables(prop);
+    prop->updateDependencies();
+  }
+}
+void PropsPage::loadModel(ConfigModel& config) {
+  PropFile* selectedProp{nullptr};
+  for (const auto& prop : props) {
+    if (!config.propFile.empty() && prop->getFileName() == config.propFile) selectedProp = prop;
+  }
+  updateSelectedProp(selectedProp ? wxString(selectedProp->getName()) : wxString("Default"));
+  if (selectedProp == nullptr) return;
 
-    for (auto& [ name, setting ] : *prop->getSettings()) {
-      setting.enable(!setting.disabled && setting.checkRequiredSatisfied(*prop->getSettings()));
+  auto propSettings = selectedProp->getSettings();
+  for (auto define = config.customDefines.begin(); define < config.customDefines.end();) {
+    auto key = propSettings->find(define->first);
+    if (key == propSettings->end()) {
+      define++;
+      continue;
     }
+
+    if (
+        key->second.setting.type == PropFile::Setting::SettingType::TOGGLE ||
+        key->second.setting.type == PropFile::Setting::SettingType::OPTION
+       ) {
+      for (const auto& other : key->second.setting.others) {
+        auto otherKey = propSettings->find(other);
+        if (otherKey != propSettings->end()) otherKey->second.setValue(false);
+      }
+      key->second.setValue(true);
+    } else {
+      key->second.setValue(std::strtod(define->second.c_str(), nullptr));
+    }
+    config.propDefines.push_back(*define);
+    define = config.customDefines.erase(define);
+  }
+}
+void PropsPage::saveModel(ConfigModel& config) {
+  config.propDefines.clear();
+  auto selectedProp = getSelectedProp();
+  config.propFile = selectedProp ? selectedProp->getFileName() : "";
+  if (selectedProp == nullptr) return;
+
+  selectedProp->updateDependencies();
+  for (const auto& [ name, state ] : *selectedProp->getSettings()) {
+    if (!selectedProp->isEnabled(state) || !state.setting.shouldOutput) continue;
+
+    auto output = state.getOutput();
+    if (!output.empty()) config.propDefines.push_back(Settings::ProffieDefine::parseKey(output));
   }
 }
 void PropsPage::updateSizeAndLayout() {
@@ -214,20 +259,6 @@ void PropsPage::updateSizeAndLayout() {
   parent->Refresh();
 }
 
-void PropsPage::updateDisables(PropFile* prop) {
-  for (auto& [ name, setting ] : *prop->getSettings()) {
-    setting.disabled = false;
-  }
-  for (auto& [ name, setting ] : *prop->getSettings()) {
-    for (const auto& disable : setting.disables) {
-      auto key = prop->getSettings()->find(disable);
-      if (key == prop->getSettings()->end()) continue;
-
-      key->second.disabled |= !setting.getOutput().empty();
-    }
-  }
-}
-
 const std::vector<PropFile*>& PropsPage::getLoadedProps() { return props; }
 PropFile* PropsPage::getSelectedProp() {
   for (const auto& prop : props) {
@@ -239,7 +270,9 @@ PropFile* PropsPage::getSelectedProp() {
 void PropsPage::updateSelectedProp(const wxString& newProp) {
   if (!newProp.empty()) propSelection->entry()->SetStringSelection(newProp);
   for (auto& prop : props) {
-    prop->Show(propSelection->entry()->GetStringSelection() == prop->getName());
+    auto selected = propSelection->entry()->GetStringSelection() == prop->getName();
+    if (selected) prop->buildLayout();
+    prop->Show(selected);
   }
 }
 void PropsPage::loadProps() {
@@ -21,8 +21,10 @@ public:
   PropsPage(wxWindow*);
 
   void update();
+  // Loading claims the selected prop's defines out of the model's custom defines
+  void loadModel(ConfigModel&);
+  void saveModel(ConfigModel&);
   void updateSizeAndLayout();
-  void updateDisables(PropFile*);
   void updateProps();
   void updateSelectedProp(const wxString& = "");
   PropFile* getSelectedProp();
@@ -2,8 +2,12 @@
 // Copyright (C) 2024 Ryan Ogurek
 
 #include "core/appstate.h"
+#include "tools/headless.h"
+
+#include <iostream>
 
 #include <wx/app.h>
+#include <wx/init.h>
 
 class ProffieConfig : public wxApp {
 public:
@@ -20,10 +24,47 @@ public:
         argv[0].find_last_of("/\\");
         chdir(argv[0].substr(0, argv[0].find_last_of("/\\")).c_str());
 
+#       ifdef __WINDOWS__
+        // Windows has no display to worry about, so --cli just skips the windows
+        headless = Headless::requested(argc, argv);
+        if (headless) return true;
+#       endif
+
         AppState::init();
 
         return true;
     }
+
+#   ifdef __WINDOWS__
+    virtual int OnRun() override {
+        if (headless) return Headless::run(argc, argv);
+        return wxApp::OnRun();
+    }
+
+private:
+    bool headless{false};
+#   endif
 };
 
+#ifdef __WINDOWS__
 wxIMPLEMENT_APP(ProffieConfig);
+#else
+wxIMPLEMENT_APP_NO_MAIN(ProffieConfig);
+
+int main(int argc, char** argv) {
+    if (!Headless::requested(argc, argv)) return wxEntry(argc, argv);
+
+    // Initialize wx as a console app so --cli never needs a display connection
+    wxApp::SetInstance(new wxAppConsole());
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk()) {
+        std::cerr << "Failed to initialize." << std::endl;
+        return 1;
+    }
+
+    const std::string exePath{argv[0]};
+    chdir(exePath.substr(0, exePath.find_last_of('/')).c_str());
+
+    return Headless::run(argc, argv);
+}
+#endif
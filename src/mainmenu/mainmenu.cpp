@@ -12,14 +12,19 @@
 #include "onboard/onboard.h"
 #include "mainmenu/dialogs/addconfig.h"
 #include "tools/arduino.h"
+#include "tools/batchverify.h"
+#include "tools/boardwatcher.h"
+#include "tools/flashqueue.h"
 #include "tools/serialmonitor.h"
 #include "../resources/icons/icon-small.xpm"
 
 #include "ui/pcchoice.h"
 
 #include <wx/event.h>
+#include <wx/filedlg.h>
 #include <wx/menu.h>
 #include <wx/aboutdlg.h>
+#include <wx/choicdlg.h>
 #include <wx/settings.h>
 
 #ifdef __WINDOWS__
@@ -38,6 +43,7 @@ MainMenu::MainMenu(wxWindow* parent) : wxFrame(parent, wxID_ANY, "ProffieConfig"
   createMenuBar();
   createTooltips();
   bindEvents();
+  BoardWatcher::start(this);
   update();
 
 # ifdef __WINDOWS__
@@ -47,6 +53,9 @@ MainMenu::MainMenu(wxWindow* parent) : wxFrame(parent, wxID_ANY, "ProffieConfig"
 
   Show(true);
 }
+MainMenu::~MainMenu() {
+  BoardWatcher::stop(this);
+}
 
 void MainMenu::bindEvents() {
     Bind(wxEVT_CLOSE_WINDOW, [&](wxCloseEvent& event) {
@@ -68,6 +77,13 @@ void MainMenu::bindEvents() {
     }, wxID_ANY);
     Bind(wxEVT_MENU, [&](wxCommandEvent&) { Close(); Onboard::instance = new Onboard(); }, ID_ReRunSetup);
     Bind(wxEVT_MENU, [&](wxCommandEvent&) { Close(true); }, wxID_EXIT);
+    Bind(wxEVT_MENU, [&](wxCommandEvent&) {
+        if (AppState::instance->getConfigFileNames().empty()) {
+            wxMessageDialog(this, "There are no configs to verify.", "Verify All Configs", wxOK | wxCENTER).ShowModal();
+            return;
+        }
+        if (wxMessageDialog(this, "This will compile the last saved version of every config, which may take a while.\n\nContinue?", "Verify All Configs", wxYES_NO | wxCENTER).ShowModal() == wxID_YES) BatchVerify::run(this);
+    }, ID_VerifyAll);
     Bind(wxEVT_MENU, [&](wxCommandEvent&) {
         wxAboutDialogInfo aboutInfo;
         aboutInfo.SetDescription(
@@ -95,6 +111,47 @@ void MainMenu::bindEvents() {
     Bind(wxEVT_BUTTON, [&](wxCommandEvent&) { SerialMonitor::instance = new SerialMonitor(this); SerialMonitor::instance->Close(true); }, ID_OpenSerial);
 #	else
     Bind(wxEVT_BUTTON, [&](wxCommandEvent&) { if (SerialMonitor::instance != nullptr) SerialMonitor::instance->Raise(); else SerialMonitor::instance = new SerialMonitor(this); }, ID_OpenSerial);
+    Bind(wxEVT_BUTTON, [&](wxCommandEvent&) {
+        if (FlashQueue::instance != nullptr) {
+            FlashQueue::instance->Raise();
+            return;
+        }
+        activeEditor->saveModel();
+        FlashQueue::instance = new FlashQueue(this, activeEditor);
+    }, ID_FlashBoards);
+    Bind(wxEVT_MENU, [&](wxCommandEvent&) {
+        if (SerialMonitor::instance != nullptr) {
+            wxMessageDialog(this, "Close the serial monitor before replaying a log.", "Serial Monitor Open", wxOK | wxCENTER).ShowModal();
+            SerialMonitor::instance->Raise();
+            return;
+        }
+
+        wxFileDialog dialog(this, "Replay Serial Capture", "", "", "Serial Log (*.pslog)|*.pslog|All Files|*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+        if (dialog.ShowModal() == wxID_OK) SerialMonitor::instance = new SerialMonitor(this, dialog.GetPath().ToStdString());
+    }, ID_ReplaySerial);
+    Bind(wxEVT_BUTTON, [&](wxCommandEvent&) {
+        if (SerialMonitor::instance != nullptr && (SerialMonitor::instance->isReplay() || !SerialMonitor::instance->isConnected())) {
+            wxMessageDialog(this, SerialMonitor::instance->isReplay() ? "Close the serial replay before pushing presets." : "The serial monitor isn't connected, close it and try again.", "Serial Monitor Open", wxOK | wxCENTER).ShowModal();
+            SerialMonitor::instance->Raise();
+            return;
+        }
+
+        activeEditor->saveModel();
+        const auto& bladeArrays{activeEditor->model.bladeArrays};
+        int32_t arrayIdx{0};
+        if (bladeArrays.size() > 1) {
+            wxArrayString arrayNames;
+            for (const auto& array : bladeArrays) arrayNames.Add(array.name);
+            arrayIdx = wxGetSingleChoiceIndex("Which blade array is the board using?", "Push Presets Live", arrayNames, this);
+            if (arrayIdx < 0) return;
+        }
+
+        if (SerialMonitor::instance == nullptr) SerialMonitor::instance = new SerialMonitor(this);
+        // Couldn't open the port, which it's already said
+        if (!SerialMonitor::instance->isConnected()) return;
+        SerialMonitor::instance->Raise();
+        SerialMonitor::instance->PushPresets(bladeArrays.at(arrayIdx).presets);
+    }, ID_PushPresets);
 #	endif
     Bind(wxEVT_CHOICE, [this](wxCommandEvent&) {
         if (configSelect->entry()->GetStringSelection() == "Select Config...") {
@@ -148,17 +205,36 @@ void MainMenu::bindEvents() {
         if (boardSelect->entry()->GetSelection() == -1) boardSelect->entry()->SetSelection(0);
         update();
     });
+    Bind(BoardWatcher::EVT_ADDED, [this](BoardWatcher::Event& evt) {
+        if (boardSelect->entry()->FindString(evt.board) == wxNOT_FOUND) boardSelect->entry()->Append(evt.board);
+        update();
+    });
+    Bind(BoardWatcher::EVT_REMOVED, [this](BoardWatcher::Event& evt) {
+        auto idx{boardSelect->entry()->FindString(evt.board)};
+        if (idx == wxNOT_FOUND) return;
+        if (boardSelect->entry()->GetSelection() == idx) boardSelect->entry()->SetSelection(0);
+        boardSelect->entry()->Delete(idx);
+        update();
+    });
 }
 
 void MainMenu::createTooltips() {
   TIP(applyButton, "Apply the current configuration to the selected Proffieboard.");
   TIP(boardSelect, "Select the Proffieboard to connect to.\nThis will be an unrecognizable device identifier, but chances are there's only one which will show up.");
   TIP(refreshButton, "Refresh the detected boards.");
+# ifndef __WINDOWS__
+  TIP(flashBoards, "Compile the current configuration once, then flash it to every connected Proffieboard.\nBoards plugged in while the window is open are flashed as well.");
+  TIP(pushPresets, "Update preset names, fonts, and tracks on the board over serial, without recompiling.\nStyle changes still need to be applied to the board.");
+# endif
 }
 
 void MainMenu::createMenuBar() {
   wxMenu *file = new wxMenu;
   file->Append(ID_ReRunSetup, "Re-Run First-Time Setup...", "Install Proffieboard Dependencies and View Tutorial");
+  file->Append(ID_VerifyAll, "Verify All Configs...", "Compile every saved config and report which ones pass");
+# ifndef __WINDOWS__
+  file->Append(ID_ReplaySerial, "Replay Serial Log...", "Play back a serial monitor capture without a board connected");
+# endif
   file->AppendSeparator();
   file->Append(wxID_ABOUT);
   file->Append(ID_Copyright, "Copyright Notice");
@@ -223,8 +299,18 @@ void MainMenu::createUI() {
   openSerial = new wxButton(this, ID_OpenSerial, "Open Serial Monitor");
   openSerial->Disable();
   options->Add(applyButton, wxSizerFlags(0).Border(wxALL, 5).Expand());
+# ifndef __WINDOWS__
+  flashBoards = new wxButton(this, ID_FlashBoards, "Apply Selected Configuration to Multiple Boards...");
+  flashBoards->Disable();
+  options->Add(flashBoards, wxSizerFlags(0).Border(wxALL, 5).Expand());
+# endif
   options->Add(editConfig, wxSizerFlags(0).Border(wxALL, 5).Expand());
   options->Add(openSerial, wxSizerFlags(0).Border(wxALL, 5).Expand());
+# ifndef __WINDOWS__
+  pushPresets = new wxButton(this, ID_PushPresets, "Push Presets Live");
+  pushPresets->Disable();
+  options->Add(pushPresets, wxSizerFlags(0).Border(wxALL, 5).Expand());
+# endif
 
   sizer->Add(headerSection, wxSizerFlags(0).Expand());
   sizer->Add(configSelectSection, wxSizerFlags(0).Border(wxALL, 5).Expand());
@@ -261,4 +347,6 @@ void MainMenu::update() {
   editConfig->Enable(configSelected);
   removeConfig->Enable(configSelected);
   openSerial->Enable(boardSelected && !recoverySelected);
+  if (flashBoards) flashBoards->Enable(configSelected);
+  if (pushPresets) pushPresets->Enable(configSelected && boardSelected && !recoverySelected);
 }
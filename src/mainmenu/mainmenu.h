@@ -13,14 +13,17 @@ class MainMenu : public wxFrame {
 public:
   static MainMenu* instance;
   MainMenu(wxWindow* = nullptr);
+  ~MainMenu() override;
 
   void update();
 
   wxButton* refreshButton{nullptr};
   wxButton* applyButton{nullptr};
+  wxButton* flashBoards{nullptr};
   pcChoice* boardSelect{nullptr};
 
   wxButton* openSerial{nullptr};
+  wxButton* pushPresets{nullptr};
 
   pcChoice* configSelect{nullptr};
   wxButton* addConfig{nullptr};
@@ -35,13 +38,17 @@ public:
     ID_DUMMY2, // on Win32, for some reason ID #1 is triggerred by hitting enter in pcTextCtrl? This is a workaround.
     ID_Copyright,
     ID_ReRunSetup,
+    ID_VerifyAll,
     ID_RefreshDev,
     ID_ApplyChanges,
+    ID_FlashBoards,
     ID_DeviceSelect,
     ID_Docs,
     ID_Issue,
 
     ID_OpenSerial,
+    ID_ReplaySerial,
+    ID_PushPresets,
 
     ID_ConfigSelect,
     ID_AddConfig,
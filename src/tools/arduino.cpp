@@ -5,14 +5,25 @@
 
 #include "core/defines.h"
 #include "core/config/configuration.h"
+#include "core/utilities/bufferedwriter.h"
+#include "core/utilities/lexer.h"
 #include "core/utilities/misc.h"
 #include "core/utilities/progress.h"
 #include "editor/editorwindow.h"
 #include "editor/pages/generalpage.h"
+#include "tools/boardwatcher.h"
+#include "tools/buildcache.h"
+#include "tools/compileoutput.h"
+#include "tools/dfu.h"
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <mutex>
 #include <thread>
 
+#include <wx/filename.h>
+
 #ifdef __WINDOWS__
 #include <windows.h>
 #include <codecvt>
@@ -23,14 +34,38 @@
 
 using namespace std::chrono_literals;
 
+// Most boards are ready well under a second after RebootDFU, but some take several
+#define BOOTLOADER_TIMEOUT 15s
+#define BOOTLOADER_POLL 50ms
+// Without BoardWatcher every look is an arduino-cli run, so just give the board time
+#define BOOTLOADER_DELAY 5s
+#define COMPILE_STEPS_FILE "compile-steps"
+
 namespace Arduino {
     FILE *CLI(const wxString& command);
+    // arduino-cli (dfu-util) flashes whichever bootloader it finds first, so
+    // only one board may be rebooted and flashed through it at a time
+    std::mutex cliUploadLock;
+    // Snapshot of the bootloaders present before rebooting the board on port
+    struct BootloaderWait {
+        bool watched{false};
+        std::string usbPort;
+        std::vector<std::string> existing;
+    };
+    BootloaderWait prepareBootloaderWait(const wxString& port);
+    // Returns as soon as the rebooted board's bootloader can be flashed, false on timeout.
+    // Where BoardWatcher can't scan this only waits BOOTLOADER_DELAY, leaving bootloader as is.
+    bool waitForBootloader(const BootloaderWait&, wxString& bootloader, const ProgressFunc&);
 
     bool updateIno(wxString&, EditorWindow*);
-    bool compile(wxString&, EditorWindow*, Progress* = nullptr);
-    bool upload(wxString&, EditorWindow*, Progress* = nullptr);
     wxString parseError(const wxString&);
 
+    wxString getFQBN(int32_t board);
+    wxString getBoardOptions(int32_t board, bool massStorage, bool webUSB);
+#   ifdef __WINDOWS__
+    bool parseUploadPaths(const std::string&, wxString&, const wxString& = {});
+#   endif
+
     wxDEFINE_EVENT(EVT_INIT_DONE, Event);
     wxDEFINE_EVENT(EVT_APPLY_DONE, Event);
     wxDEFINE_EVENT(EVT_VERIFY_DONE, Event);
@@ -106,6 +141,12 @@ std::vector<wxString> Arduino::getBoards() {
   std::vector<wxString> boards{"Select Board..."};
   char buffer[1024];
 
+  std::vector<std::string> found;
+  if (BoardWatcher::scan(found)) {
+    boards.insert(boards.end(), found.begin(), found.end());
+    return boards;
+  }
+
   FILE *arduinoCli = Arduino::CLI("board list");
 
   if (!arduinoCli) {
@@ -132,10 +173,46 @@ std::vector<wxString> Arduino::getBoards() {
   return boards;
 }
 
+Arduino::BootloaderWait Arduino::prepareBootloaderWait(const wxString& port) {
+  BootloaderWait wait;
+  wait.watched = BoardWatcher::scan(wait.existing);
+  wait.usbPort = BoardWatcher::locate(port.ToStdString()).port;
+  return wait;
+}
+
+bool Arduino::waitForBootloader(const BootloaderWait& wait, wxString& bootloader, const ProgressFunc& onProgress) {
+  if (!wait.watched) {
+    if (onProgress) onProgress(-1, "Waiting for bootloader...");
+    std::this_thread::sleep_for(BOOTLOADER_DELAY);
+    return true;
+  }
+
+  const auto deadline{std::chrono::steady_clock::now() + BOOTLOADER_TIMEOUT};
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (onProgress) onProgress(-1, "Waiting for bootloader...");
+    std::vector<std::string> boards;
+    BoardWatcher::scan(boards);
+    for (const auto& board : boards) {
+      if (board.rfind("BOOTLOADER|", 0) != 0) continue;
+      // Where the board is plugged in is the surest match, otherwise take the first new bootloader
+      if (!wait.usbPort.empty()) {
+        if (BoardWatcher::locate(board).port != wait.usbPort) continue;
+      } else if (std::find(wait.existing.begin(), wait.existing.end(), board) != wait.existing.end()) continue;
+
+      if (!BoardWatcher::isAccessible(board)) continue;
+      bootloader = board;
+      return true;
+    }
+    std::this_thread::sleep_for(BOOTLOADER_POLL);
+  }
+  return false;
+}
+
 void Arduino::applyToBoard(MainMenu* window, EditorWindow* editor) {
     auto progDialog = new Progress(window);
     progDialog->SetTitle("Applying Changes");
 
+    auto boardPath{window->boardSelect->entry()->GetStringSelection()};
     std::thread thread{[=]() {
         auto *evt{new Event(EVT_APPLY_DONE)};
         wxString returnVal;
@@ -143,14 +220,23 @@ void Arduino::applyToBoard(MainMenu* window, EditorWindow* editor) {
         progDialog->emitEvent(0, "Initializing...");
 
         progDialog->emitEvent(10, "Checking board presence...");
-        wxString lastSel = window->boardSelect->entry()->GetStringSelection();
-        window->boardSelect->entry()->Clear();
-        for (const wxString& item : Arduino::getBoards()) {
-            window->boardSelect->entry()->Append(item);
+        bool present{false};
+        if (BoardWatcher::isRunning()) {
+            // The list is already live, nothing to re-enumerate
+            present = BoardWatcher::has(boardPath.ToStdString());
+        } else {
+            wxQueueEvent(window, new Event(EVT_CLEAR_BLIST));
+            for (const wxString& item : Arduino::getBoards()) {
+                if (item == boardPath) present = true;
+                auto appendEvt{new Event(EVT_APPEND_BLIST)};
+                appendEvt->str = item.ToStdString();
+                wxQueueEvent(window, appendEvt);
+            }
+            auto refreshEvt{new Event(EVT_REFRESH_DONE)};
+            refreshEvt->str = boardPath.ToStdString();
+            wxQueueEvent(window, refreshEvt);
         }
-        window->boardSelect->entry()->SetStringSelection(lastSel);
-        if (window->boardSelect->entry()->GetSelection() == -1) {
-            window->boardSelect->entry()->SetSelection(0);
+        if (!present || boardPath == "Select Board...") {
             progDialog->emitEvent(100, "Error!");
             Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, "Please make sure your board is connected and selected, then try again!", "Board Selection Error", wxOK | wxICON_ERROR);
             wxQueueEvent(window, msg);
@@ -176,7 +262,10 @@ void Arduino::applyToBoard(MainMenu* window, EditorWindow* editor) {
         }
 
         progDialog->emitEvent(40, "Compiling ProffieOS...");
-        if (!Arduino::compile(returnVal, editor)) {
+        auto build{getBuild(editor)};
+        if (!Arduino::compile(returnVal, build, [&](int32_t percent, const wxString& message) {
+            progDialog->emitEvent(percent < 0 ? -1 : 40 + percent * 24 / 100, message);
+        })) {
             progDialog->emitEvent(100, "Error");
             Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, "There was an error while compiling:\n\n" + returnVal, "Compile Error");
             wxQueueEvent(window, msg);
@@ -184,65 +273,17 @@ void Arduino::applyToBoard(MainMenu* window, EditorWindow* editor) {
             return;
         }
 
-#   ifdef __WINDOWS__
-        if (window->boardSelect->entry()->GetStringSelection() != "BOOTLOADER RECOVERY") {
-            progDialog->emitEvent(50, "Rebooting Proffieboard...");
-
-            auto serialHandle = CreateFileW(window->boardSelect->entry()->GetStringSelection().ToStdWstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-            if (serialHandle != INVALID_HANDLE_VALUE) {
-                DCB dcbSerialParameters = {};
-                dcbSerialParameters.DCBlength = sizeof(dcbSerialParameters);
-
-                dcbSerialParameters.BaudRate = CBR_115200;
-                dcbSerialParameters.ByteSize = 8;
-                dcbSerialParameters.StopBits = ONESTOPBIT;
-                dcbSerialParameters.Parity = NOPARITY;
-                dcbSerialParameters.fRtsControl = RTS_CONTROL_ENABLE;
-                dcbSerialParameters.fDtrControl = DTR_CONTROL_ENABLE;
-
-                SetCommState(serialHandle, &dcbSerialParameters);
-
-                DWORD bytesHandled;
-                const char* rebootCommand = "RebootDFU\r\n";
-                WriteFile(serialHandle, rebootCommand, strlen(rebootCommand),  &bytesHandled, nullptr);
-
-                CloseHandle(serialHandle);
-                Sleep(5000);
-            }
-        }
-#   endif
-
         progDialog->emitEvent(65, "Uploading to ProffieBoard...");
-#   ifdef __WINDOWS__
-        std::string commandString = R"(title ProffieConfig Worker & resources\windowmode -title "ProffieConfig Worker" -mode force_minimized & )";
-        commandString += (returnVal.substr(returnVal.find("|") + 1) + R"( 0x1209 0x6668 )" + returnVal.substr(0, returnVal.find("|")) + R"( 2>&1)").ToStdString();
-        std::cerr << "UploadCommandString: " << commandString << std::endl;
-
-        auto upload = popen(commandString.c_str(), "r");
-        char buffer[128];
-        std::string error{};
-        while (fgets(buffer, sizeof(buffer), upload) != nullptr) {
-            progDialog->emitEvent(-1, "");
-            error += buffer;
-        }
-
-        if (error.find("File downloaded successfully") == std::string::npos) {
-            progDialog->emitEvent(100, "Error");
-            Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, "There was an error while uploading:\n\n" + Arduino::parseError(error), "Upload Error");
-            wxQueueEvent(window, msg);
-            wxQueueEvent(window, evt);
-            return;
-        }
-
-#   else
-        if (!Arduino::upload(returnVal, editor)) {
+        if (!Arduino::upload(returnVal, build, boardPath, [&](int32_t percent, const wxString& message) {
+            // Stay below 100 so the dialog isn't destroyed before the result is in
+            progDialog->emitEvent(percent < 0 ? -1 : 65 + percent * 34 / 100, message);
+        })) {
             progDialog->emitEvent(100, "Error");
             Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, "There was an error while uploading:\n\n" + returnVal, "Upload Error");
             wxQueueEvent(window, msg);
             wxQueueEvent(window, evt);
             return;
         }
-#   endif
 
         progDialog->emitEvent(100, "Done.");
 
@@ -280,7 +321,11 @@ void Arduino::verifyConfig(wxWindow* parent, EditorWindow* editor) {
         }
 
         progDialog->emitEvent(40, "Compiling ProffieOS...");
-        if (!Arduino::compile(returnVal, editor)) {
+        auto build{getBuild(editor)};
+        if (!Arduino::compile(returnVal, build, [&](int32_t percent, const wxString& message) {
+            // Stay below 100 so the dialog isn't destroyed before the result is in
+            progDialog->emitEvent(percent < 0 ? -1 : 40 + percent * 59 / 100, message);
+        })) {
             progDialog->emitEvent(100, "Error");
             Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, "There was an error while compiling:\n\n"
                                + returnVal, "Compile Error");
@@ -298,166 +343,360 @@ void Arduino::verifyConfig(wxWindow* parent, EditorWindow* editor) {
     thread.detach();
 }
 
-bool Arduino::compile(wxString& _return, EditorWindow* editor, Progress* progDialog) {
-  wxString output;
+bool Arduino::compile(wxString& _return, Build& build, const ProgressFunc& onProgress) {
   char buffer[1024];
 
+  const auto cacheKey{BuildCache::getKey(build.configPath, build.fqbn, build.boardOptions)};
+  // Upload goes by this rather than hashing the config again, which may have been saved since
+  build.cacheKey = cacheKey;
+  build.cacheUse = std::make_shared<BuildCache::Use>(cacheKey);
+  wxString cachedOutput;
+  // Another compile of the same config may finish it while prepare() waits
+  bool cached{BuildCache::lookup(cacheKey, cachedOutput, build.batch)};
+  while (!cached && !BuildCache::prepare(cacheKey)) cached = BuildCache::lookup(cacheKey, cachedOutput, build.batch);
+  if (cached) {
+#   ifdef __WINDOWS__
+    return parseUploadPaths(cachedOutput.ToStdString(), _return, BuildCache::getDir(cacheKey) + "\\ProffieOS.ino.dfu");
+#   else
+    _return = cachedOutput;
+    return true;
+#   endif
+  }
+
+  const auto buildPath{build.buildPath.empty() ? BuildCache::getBuildPath(build.fqbn, build.boardOptions) : build.buildPath};
+  // Another compile of this board setup (e.g. Verify while Apply runs) may be using the shared build path
+  const auto buildPathGuard{BuildCache::lockBuildPath(buildPath)};
   wxString compileCommand = "compile ";
   compileCommand += "-b ";
-  compileCommand += editor->generalPage->board->entry()->GetSelection() == PROFFIEBOARDV1 ? ARDUINOCORE_PBV1 : editor->generalPage->board->entry()->GetSelection() == PROFFIEBOARDV2 ? ARDUINOCORE_PBV2 : ARDUINOCORE_PBV3;
+  compileCommand += build.fqbn;
   compileCommand += " --board-options ";
-  if (editor->generalPage->massStorage->GetValue() && editor->generalPage->webUSB->GetValue()) compileCommand += "usb=cdc_msc_webusb";
-  else if (editor->generalPage->webUSB->GetValue()) compileCommand += "usb=cdc_webusb";
-  else if (editor->generalPage->massStorage->GetValue()) compileCommand += "usb=cdc_msc";
-  else compileCommand += "usb=cdc";
-  if (editor->generalPage->board->entry()->GetSelection() == PROFFIEBOARDV3) compileCommand +=",dosfs=sdmmc1";
-  compileCommand += " " PROFFIEOS_PATH " -v";
-  FILE *arduinoCli = Arduino::CLI(compileCommand);
+  compileCommand += build.boardOptions;
+  compileCommand += " --build-path \"" + buildPath + "\"";
+  compileCommand += " --output-dir \"" + BuildCache::getDir(cacheKey) + "\"";
+  if (build.jobs > 0) compileCommand += wxString::Format(" -j %d", build.jobs);
+  compileCommand += " \"" + build.sketchPath + "\" -v";
+
+  // How far the last compile in this build directory got is what percentages are based on
+  const auto stepsPath{(buildPath + wxFileName::GetPathSeparator() + COMPILE_STEPS_FILE).ToStdString()};
+  uint32_t expectedSteps{0};
+  std::ifstream(stepsPath) >> expectedSteps;
+  CompileOutput::Parser parser([&](const CompileOutput::Update& update) {
+    if (!onProgress) return;
+    wxString message{CompileOutput::getStageName(update.stage)};
+    if (!update.file.empty()) message += ": " + update.file;
+    onProgress(update.percent, message + "...");
+  }, expectedSteps);
 
-  std::string error{};
-  std::wstring paths{};
+  FILE *arduinoCli = Arduino::CLI(compileCommand);
   while(fgets(buffer, sizeof(buffer), arduinoCli) != NULL) {
-    if (progDialog != nullptr) progDialog->emitEvent(-1, ""); // Pulse
-    error += buffer;
-    if (std::strstr(buffer, "error")) {
-      _return = Arduino::parseError(error);
-      return false;
-    }
-#   ifdef __WINDOWS__
-    if (std::strstr(buffer, "ProffieOS.ino.dfu") && std::strstr(buffer, "stm32l4") && std::strstr(buffer, "C:\\")) {
-      std::cerr << "ErrBufferFull: " << error << std::endl;
-      error = buffer;
-      std::cerr << "PathBuffer: " << error << std::endl;
-
-      // Ugly code because Windows wants wchar_t*, which requires (ish) std::wstring's
-      wchar_t shortPath[MAX_PATH];
-      GetShortPathName(std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>().from_bytes(error.substr(error.rfind("C:\\"), error.rfind("ProffieOS.ino.dfu") - error.rfind("C:\\") + 17)).c_str(), shortPath, MAX_PATH);
-      paths = shortPath;
-      paths += L"|";
-      GetShortPathName(std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>().from_bytes(error.substr(1, error.find("windows") + 7 - 1)).c_str(), shortPath, MAX_PATH);
-      paths += shortPath;
-      paths += LR"(\\stm32l4-upload.bat)";
-      std::wcerr << "ParsedPaths: " << paths << std::endl;
-
+    parser.feed(buffer, std::strlen(buffer));
+    if (parser.hasError()) {
       pclose(arduinoCli);
-      _return = paths;
-      return true;
+      BuildCache::discard(cacheKey);
+      _return = Arduino::parseError(parser.getError());
+      return false;
     }
-#   endif
   }
+  parser.finish();
   if (pclose(arduinoCli) != 0) {
-    _return = "Unknown Compile Error";
+    BuildCache::discard(cacheKey);
+    _return = parser.hasError() ? Arduino::parseError(parser.getError()) : wxString{"Unknown Compile Error"};
     return false;
   }
+  std::ofstream(stepsPath) << parser.steps() << std::endl;
 
-
-  _return = error;
 # ifdef __WINDOWS__
-  return false;
+  if (parser.getSummary().find("C:\\") == std::string::npos) {
+    BuildCache::discard(cacheKey);
+    _return = "Could not find upload tools";
+    return false;
+  }
+  BuildCache::store(cacheKey, parser.getSummary(), build.batch);
+  return parseUploadPaths(parser.getSummary(), _return);
 # else
+  BuildCache::store(cacheKey, parser.getSummary(), build.batch);
+  _return = parser.getSummary();
   return true;
-#endif
+# endif
 }
-bool Arduino::upload(wxString& _return, EditorWindow* editor, Progress* progDialog) {
+bool Arduino::upload(wxString& _return, const Build& build, const wxString& port, const ProgressFunc& onProgress) {
     char buffer[1024];
+    const auto& cacheKey{build.cacheKey};
+    // Without it arduino-cli would upload whatever's left in its default build directory
+    if (cacheKey.empty() || !BuildCache::has(cacheKey)) {
+        _return = "Compiled firmware not found, compile the config again.";
+        return false;
+    }
+
+#ifdef __WINDOWS__
+    // From the reboot on, no other board may be in the bootloader until this one's flashed
+    std::lock_guard<std::mutex> uploadGuard(cliUploadLock);
+    if (port != "BOOTLOADER RECOVERY") {
+        const auto bootloaderWait{prepareBootloaderWait(port)};
+        auto serialHandle = CreateFileW(port.ToStdWstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (serialHandle != INVALID_HANDLE_VALUE) {
+            DCB dcbSerialParameters = {};
+            dcbSerialParameters.DCBlength = sizeof(dcbSerialParameters);
+
+            dcbSerialParameters.BaudRate = CBR_115200;
+            dcbSerialParameters.ByteSize = 8;
+            dcbSerialParameters.StopBits = ONESTOPBIT;
+            dcbSerialParameters.Parity = NOPARITY;
+            dcbSerialParameters.fRtsControl = RTS_CONTROL_ENABLE;
+            dcbSerialParameters.fDtrControl = DTR_CONTROL_ENABLE;
+
+            SetCommState(serialHandle, &dcbSerialParameters);
+
+            DWORD bytesHandled;
+            const char* rebootCommand = "RebootDFU\r\n";
+            WriteFile(serialHandle, rebootCommand, strlen(rebootCommand),  &bytesHandled, nullptr);
+
+            CloseHandle(serialHandle);
+            // Upload anyways on timeout, the board may still show up in time
+            wxString bootloader;
+            if (!waitForBootloader(bootloaderWait, bootloader, onProgress)) std::cerr << "Timed out waiting for bootloader on " << port << std::endl;
+        }
+    }
 
-    wxString uploadCommand = "upload ";
-    uploadCommand += PROFFIEOS_PATH;
-    uploadCommand += " --board-options ";
-    if (editor->generalPage->massStorage->GetValue() && editor->generalPage->webUSB->GetValue()) uploadCommand += "usb=cdc_msc_webusb";
-    else if (editor->generalPage->webUSB->GetValue()) uploadCommand += "usb=cdc_webusb";
-    else if (editor->generalPage->massStorage->GetValue()) uploadCommand += "usb=cdc_msc";
-    else uploadCommand += "usb=cdc";
-    if (editor->generalPage->board->entry()->GetStringSelection() == "ProffieBoard V3") uploadCommand +=",dosfs=sdmmc1";
+    // On Windows _return holds the "dfu|bat" paths compile() found
+    std::string commandString = R"(title ProffieConfig Worker & resources\windowmode -title "ProffieConfig Worker" -mode force_minimized & )";
+    commandString += (_return.substr(_return.find("|") + 1) + R"( 0x1209 0x6668 )" + _return.substr(0, _return.find("|")) + R"( 2>&1)").ToStdString();
+    std::cerr << "UploadCommandString: " << commandString << std::endl;
+
+    FILE *arduinoCli = popen(commandString.c_str(), "r");
+#else
+    wxString uploadCommand = "upload \"";
+    uploadCommand += build.sketchPath;
+    uploadCommand += "\" --board-options ";
+    uploadCommand += build.boardOptions;
 
     uploadCommand += " --fqbn ";
-    uploadCommand += editor->generalPage->board->entry()->GetSelection() == 0 ? ARDUINOCORE_PBV1 : editor->generalPage->board->entry()->GetSelection() == 1 ? ARDUINOCORE_PBV2 : ARDUINOCORE_PBV3;
+    uploadCommand += build.fqbn;
+    uploadCommand += " --input-dir \"" + BuildCache::getDir(cacheKey) + "\"";
     uploadCommand += " -v";
 
-#ifndef __WINDOWS__
-    struct termios newtio;
-    auto fd = open(static_cast<MainMenu*>(editor->GetParent())->boardSelect->entry()->GetStringSelection().data(), O_RDWR | O_NOCTTY);
-    if (fd < 0) {
-        std::cout << "err" << std::endl;
-    }
+    // Flash directly when possible. Otherwise, from the reboot on, no other board may
+    // be in the bootloader until this one's flashed, so decide that before rebooting.
+    DFU::Image image;
+    std::string dfuError;
+    std::vector<std::string> boards;
+    const bool direct{DFU::isSupported() && BoardWatcher::scan(boards) && DFU::loadImage(BuildCache::getDir(cacheKey).ToStdString(), image, dfuError)};
+    std::unique_lock<std::mutex> uploadGuard(cliUploadLock, std::defer_lock);
+    if (!direct) uploadGuard.lock();
+
+    wxString bootloader{port};
+    // Already in the bootloader, nothing to reboot
+    if (!port.StartsWith("BOOTLOADER")) {
+        const auto bootloaderWait{prepareBootloaderWait(port)};
+        struct termios newtio;
+        auto fd = open(port.data(), O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            _return = "Could not open " + port;
+            return false;
+        }
 
-    memset(&newtio, 0, sizeof(newtio));
+        memset(&newtio, 0, sizeof(newtio));
 
-    newtio.c_cflag = B115200 | CRTSCTS | CS8 | CLOCAL | CREAD;
-    newtio.c_iflag = IGNPAR;
-    newtio.c_oflag = (tcflag_t) NULL;
-    newtio.c_lflag &= ~ICANON; /* unset canonical */
-    newtio.c_cc[VTIME] = 1; /* 100 millis */
+        newtio.c_cflag = B115200 | CRTSCTS | CS8 | CLOCAL | CREAD;
+        newtio.c_iflag = IGNPAR;
+        newtio.c_oflag = (tcflag_t) NULL;
+        newtio.c_lflag &= ~ICANON; /* unset canonical */
+        newtio.c_cc[VTIME] = 1; /* 100 millis */
 
-    tcflush(fd, TCIFLUSH);
-    tcsetattr(fd, TCSANOW, &newtio);
+        tcflush(fd, TCIFLUSH);
+        tcsetattr(fd, TCSANOW, &newtio);
 
-    char buf[255];
-    while(read(fd, buf, 255));
+        char buf[255];
+        while (read(fd, buf, 255) > 0);
 
-    fsync(fd);
-    write(fd, "\r\n", 2);
-    write(fd, "\r\n", 2);
-    write(fd, "RebootDFU\r\n", 11);
+        fsync(fd);
+        write(fd, "\r\n", 2);
+        write(fd, "\r\n", 2);
+        write(fd, "RebootDFU\r\n", 11);
 
-    // Ensure everything is flushed
-    std::this_thread::sleep_for(50ms);
-    close(fd);
-    std::this_thread::sleep_for(5s);
-#endif
+        // Ensure everything is flushed
+        std::this_thread::sleep_for(50ms);
+        close(fd);
+        // Upload anyways on timeout, the board may still show up in time
+        if (!waitForBootloader(bootloaderWait, bootloader, onProgress)) std::cerr << "Timed out waiting for bootloader on " << port << std::endl;
+    }
 
+    // arduino-cli is only needed when the bootloader can't be found on its own
+    if (direct && bootloader.StartsWith("BOOTLOADER|")) {
+        bool started{false};
+        const bool flashed{DFU::flash(bootloader.ToStdString(), image, dfuError, started, [&](DFU::Stage stage, size_t done, size_t total) {
+            if (!onProgress) return;
+            switch (stage) {
+                case DFU::Stage::ERASE: onProgress(done * 20 / total, "Erasing..."); break;
+                case DFU::Stage::WRITE: onProgress(20 + done * 60 / total, wxString::Format("Writing... (%zu/%zu KB)", done / 1024, total / 1024)); break;
+                case DFU::Stage::VERIFY: onProgress(80 + done * 20 / total, "Verifying..."); break;
+            }
+        })};
+        // If the bootloader couldn't be opened nothing's been erased yet, so arduino-cli can still have a go
+        if (flashed || started) {
+            _return = flashed ? wxString{} : wxString{dfuError};
+            return flashed;
+        }
+        std::cerr << "Direct DFU upload failed, falling back to arduino-cli: " << dfuError << std::endl;
+    }
+
+    if (!uploadGuard.owns_lock()) uploadGuard.lock();
     FILE *arduinoCli = Arduino::CLI(uploadCommand);
+#endif
 
     wxString error{};
     while(fgets(buffer, sizeof(buffer), arduinoCli) != NULL) {
-        if (progDialog != nullptr) progDialog->emitEvent(-1, ""); // Pulse
+        if (onProgress) onProgress(-1, "");
         error += buffer;
+#       ifndef __WINDOWS__
         if (std::strstr(buffer, "error") || std::strstr(buffer, "FAIL")) {
+            pclose(arduinoCli);
             _return = Arduino::parseError(error);
             return false;
         }
+#       endif
     }
+#   ifdef __WINDOWS__
+    pclose(arduinoCli);
+    if (!error.Contains("File downloaded successfully")) {
+        _return = Arduino::parseError(error);
+        return false;
+    }
+#   else
     if (pclose(arduinoCli) != 0) {
         _return = "Unknown Upload Error";
         return false;
     }
+#   endif
 
     _return.clear();
     return true;
 }
-bool Arduino::updateIno(wxString& _return, EditorWindow* _editor) {
-  std::ifstream input(PROFFIEOS_INO);
+bool Arduino::updateIno(wxString& _return, EditorWindow* _editor) { return updateIno(_return, PROFFIEOS_PATH, _editor->getOpenConfig()); }
+bool Arduino::updateIno(wxString& _return, const wxString& sketchPath, const std::string& configName) {
+  const auto inoPath{sketchPath + wxFileName::GetPathSeparator() + "ProffieOS.ino"};
+  std::ifstream input(inoPath.ToStdString());
   if (!input.is_open()) {
     _return = "ERROR OPENING FOR READ";
     return false;
   }
 
   std::string fileData;
-  std::vector<wxString> outputData;
+  std::string inputData;
+  BufferedWriter outputData;
   while(!input.eof()) {
     getline(input, fileData);
-    if (fileData.find(R"(// #define CONFIG_FILE "config/YOUR_CONFIG_FILE_NAME_HERE.h")") != std::string::npos) outputData.push_back("#define CONFIG_FILE \"config/" + _editor->getOpenConfig() + ".h\"");
-    if (fileData.find(R"(#define CONFIG_FILE)") == 0) outputData.push_back("#define CONFIG_FILE \"config/" + _editor->getOpenConfig() + ".h\"");
-    else if (fileData.find(R"(const char version[] = ")" ) != std::string::npos) outputData.push_back(R"(const char version[] = ")" PROFFIEOS_VERSION R"(";)");
-    else outputData.push_back(fileData);
+    inputData += fileData + '\n';
+    if (fileData.find(R"(// #define CONFIG_FILE "config/YOUR_CONFIG_FILE_NAME_HERE.h")") != std::string::npos) outputData << "#define CONFIG_FILE \"config/" << configName << ".h\"\n";
+    if (fileData.find(R"(#define CONFIG_FILE)") == 0) outputData << "#define CONFIG_FILE \"config/" << configName << ".h\"\n";
+    else if (fileData.find(R"(const char version[] = ")" ) != std::string::npos) outputData << R"(const char version[] = ")" PROFFIEOS_VERSION R"(";)" "\n";
+    else outputData << fileData << '\n';
   }
   input.close();
 
+  // Leave the sketch untouched if nothing changed so the persistent build can be reused
+  if (outputData.str() == inputData) {
+    _return.clear();
+    return true;
+  }
 
-  std::ofstream output(PROFFIEOS_INO);
-  if (!output.is_open()) {
+  if (!outputData.commit(inoPath.ToStdString())) {
     _return = "ERROR OPENING FOR WRITE";
     return false;
   }
 
-  for (const wxString& line : outputData) {
-    output << line << std::endl;
+  _return.clear();
+  return true;
+}
+
+wxString Arduino::getFQBN(int32_t board) {
+  switch (board) {
+    case PROFFIEBOARDV1: return ARDUINOCORE_PBV1;
+    case PROFFIEBOARDV2: return ARDUINOCORE_PBV2;
+    default: return ARDUINOCORE_PBV3;
+  }
+}
+wxString Arduino::getBoardOptions(int32_t board, bool massStorage, bool webUSB) {
+  wxString options;
+  if (massStorage && webUSB) options += "usb=cdc_msc_webusb";
+  else if (webUSB) options += "usb=cdc_webusb";
+  else if (massStorage) options += "usb=cdc_msc";
+  else options += "usb=cdc";
+  if (board == PROFFIEBOARDV3) options +=",dosfs=sdmmc1";
+  return options;
+}
+Arduino::Build Arduino::getBuild(EditorWindow* editor) {
+  // Called after outputConfig(), so the model is up to date
+  Build build;
+  const auto& general{editor->model.general};
+  build.configPath = CONFIG_DIR + editor->getOpenConfig() + ".h";
+  build.fqbn = getFQBN(general.board);
+  build.boardOptions = getBoardOptions(general.board, general.massStorage, general.webUSB);
+  return build;
+}
+bool Arduino::readBuild(const std::string& configPath, Build& build) {
+  Lexer lexer;
+  if (!lexer.readFile(configPath)) return false;
+
+  // Same markers Configuration::readConfigTop uses
+  int32_t board{-1};
+  bool massStorage{false};
+  bool webUSB{false};
+  for (const auto& token : lexer.getTokens()) {
+    if (token.type == Lexer::Token::Type::COMMENT && token.text.rfind("//PROFFIECONFIG", 0) == 0) {
+      if (token.text.find("ENABLE_MASS_STORAGE") != std::string_view::npos) massStorage = true;
+      if (token.text.find("ENABLE_WEBUSB") != std::string_view::npos) webUSB = true;
+    } else if (board == -1 && token.is(Lexer::Token::Type::DIRECTIVE, "#include")) {
+      auto include = lexer.restOfLine(token);
+      if (include.find("v1") != std::string_view::npos) board = PROFFIEBOARDV1;
+      else if (include.find("v2") != std::string_view::npos) board = PROFFIEBOARDV2;
+      else if (include.find("v3") != std::string_view::npos) board = PROFFIEBOARDV3;
+    }
+  }
+  if (board == -1) return false;
+
+  build.configPath = configPath;
+  build.fqbn = getFQBN(board);
+  build.boardOptions = getBoardOptions(board, massStorage, webUSB);
+  return true;
+}
+
+# ifdef __WINDOWS__
+bool Arduino::parseUploadPaths(const std::string& output, wxString& _return, const wxString& dfuPath) {
+  // Find the line arduino-cli prints with both the .dfu path and the tools path
+  std::string line;
+  for (size_t lineBegin = 0; lineBegin < output.size();) {
+    auto lineEnd = output.find('\n', lineBegin);
+    if (lineEnd == std::string::npos) lineEnd = output.size();
+    auto candidate = output.substr(lineBegin, lineEnd - lineBegin);
+    if (candidate.find("ProffieOS.ino.dfu") != std::string::npos && candidate.find("stm32l4") != std::string::npos && candidate.find("C:\\") != std::string::npos) {
+      line = candidate;
+      break;
+    }
+    lineBegin = lineEnd + 1;
+  }
+  if (line.empty()) {
+    _return = "Could not find upload tools";
+    return false;
   }
-  output.close();
 
-  _return.clear();
+  // Ugly code because Windows wants wchar_t*, which requires (ish) std::wstring's
+  wchar_t shortPath[MAX_PATH];
+  std::wstring paths{};
+  if (dfuPath.empty()) {
+    GetShortPathName(std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>().from_bytes(line.substr(line.rfind("C:\\"), line.rfind("ProffieOS.ino.dfu") - line.rfind("C:\\") + 17)).c_str(), shortPath, MAX_PATH);
+    paths = shortPath;
+  } else paths = dfuPath.ToStdWstring();
+  paths += L"|";
+  GetShortPathName(std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>().from_bytes(line.substr(1, line.find("windows") + 7 - 1)).c_str(), shortPath, MAX_PATH);
+  paths += shortPath;
+  paths += LR"(\\stm32l4-upload.bat)";
+  std::wcerr << "ParsedPaths: " << paths << std::endl;
+
+  _return = paths;
   return true;
 }
+# endif
 
 wxString Arduino::parseError(const wxString& error) {
   std::cerr << "An arduino task failed with the following error: " << std::endl;
@@ -2,11 +2,16 @@
 // Copyright (C) 2024 Ryan Ogurek
 
 #pragma once
+#include <functional>
+#include <memory>
 #include <vector>
 #include <wx/combobox.h>
 
+#include "core/defines.h"
+#include "core/utilities/progress.h"
 #include "editor/editorwindow.h"
 #include "mainmenu/mainmenu.h"
+#include "tools/buildcache.h"
 
 namespace Arduino {
     void refreshBoards(MainMenu*);
@@ -16,6 +21,34 @@ namespace Arduino {
     void init(wxWindow*);
     std::vector<wxString> getBoards();
 
+    // Everything arduino-cli needs to compile one config
+    struct Build {
+        wxString sketchPath{PROFFIEOS_PATH};
+        std::string configPath;
+        wxString fqbn;
+        wxString boardOptions;
+        wxString buildPath; // Empty for the shared build directory of this board setup
+        int32_t jobs{0};
+        // Cached as a batch entry, see BuildCache::store()
+        bool batch{false};
+
+        // Set by compile(): the cache entry holding the firmware, which is
+        // kept from being pruned for as long as the Build (or a copy) is around
+        std::string cacheKey;
+        std::shared_ptr<BuildCache::Use> cacheUse;
+    };
+    [[nodiscard]] Build getBuild(EditorWindow*);
+    // Fill in board settings from a header previously generated by ProffieConfig.
+    bool readBuild(const std::string& configPath, Build&);
+    // percent is -1 when there's only activity to show, not actual progress.
+    using ProgressFunc = std::function<void(int32_t percent, const wxString& message)>;
+    // On success _return holds the parts of the output needed later (see CompileOutput).
+    bool compile(wxString&, Build&, const ProgressFunc& = nullptr);
+    bool updateIno(wxString&, const wxString& sketchPath, const std::string& configName);
+    // Reboot the board on port into DFU and flash the build, which compile() must have succeeded on.
+    // On Windows _return must hold the upload paths compile() returned.
+    bool upload(wxString&, const Build&, const wxString& port, const ProgressFunc& = nullptr);
+
     enum {
         PROFFIEBOARDV1 = 0,
         PROFFIEBOARDV2 = 1,
@@ -0,0 +1,174 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/batchverify.h"
+
+#include "core/defines.h"
+#include "core/appstate.h"
+#include "core/utilities/misc.h"
+#include "core/utilities/progress.h"
+#include "mainmenu/mainmenu.h"
+#include "tools/arduino.h"
+#include "tools/buildcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <wx/dir.h>
+#include <wx/filename.h>
+
+#define WORKSPACE_VERSION_FILE ".version"
+
+namespace BatchVerify {
+  void parseFlashUsage(const wxString& output, Result&);
+}
+
+void BatchVerify::run(MainMenu* window) {
+  auto progDialog = new Progress(window);
+  progDialog->SetTitle("Verify All Configs");
+
+  const auto configs{AppState::instance->getConfigFileNames()};
+  std::thread thread{[=]() {
+    progDialog->emitEvent(0, "Preparing workspaces...");
+
+    std::mutex progressLock;
+    auto results{verify(configs, [&](size_t done, const Result& result) {
+      std::lock_guard<std::mutex> guard(progressLock);
+      // Stay below 100 so the dialog isn't destroyed before the report is ready
+      progDialog->emitEvent(static_cast<int8_t>(std::min<size_t>(99, done * 100 / configs.size())), "Verified " + result.config + " (" + std::to_string(done) + "/" + std::to_string(configs.size()) + ")");
+    })};
+
+    progDialog->emitEvent(100, "Done.");
+    auto failed{std::count_if(results.begin(), results.end(), [](const Result& result) { return !result.passed; })};
+    Misc::MessageBoxEvent* msg = new Misc::MessageBoxEvent(wxID_ANY, formatReport(results), "Verify All Configs", wxOK | (failed ? wxICON_WARNING : wxICON_INFORMATION));
+    wxQueueEvent(window, msg);
+  }};
+  thread.detach();
+}
+
+std::vector<BatchVerify::Result> BatchVerify::verify(const std::vector<std::string>& configs, const std::function<void(size_t, const Result&)>& onResult) {
+  std::vector<Result> results(configs.size());
+  if (configs.empty()) return results;
+
+  const auto cores{std::max(1u, std::thread::hardware_concurrency())};
+  const auto numWorkers{std::min<size_t>(cores, configs.size())};
+  // Split the cores between the compiles running side by side
+  const auto jobsPerWorker{std::max<int32_t>(1, static_cast<int32_t>(cores / numWorkers))};
+
+  std::atomic<size_t> nextJob{0};
+  std::atomic<size_t> jobsDone{0};
+  auto worker = [&](size_t workerNum) {
+    const wxString workspace{BATCH_DIR + std::to_string(workerNum)};
+    const wxString sketchPath{workspace + wxFileName::GetPathSeparator() + "ProffieOS"};
+    const bool workspaceReady{prepareWorkspace(workspace)};
+
+    for (auto job = nextJob++; job < configs.size(); job = nextJob++) {
+      auto& result{results[job]};
+      result.config = configs[job];
+
+      [&]() {
+        if (!workspaceReady) {
+          result.message = "Could not set up workspace";
+          return;
+        }
+
+        Arduino::Build build;
+        if (!Arduino::readBuild(CONFIG_DIR + result.config + ".h", build)) {
+          result.message = "Could not read board settings from config";
+          return;
+        }
+        build.sketchPath = sketchPath;
+        build.buildPath = BuildCache::getBuildPath(build.fqbn, build.boardOptions, "batch" + std::to_string(workerNum));
+        build.jobs = jobsPerWorker;
+        build.batch = true;
+
+        const wxString workspaceConfig{sketchPath + wxFileName::GetPathSeparator() + "config" + wxFileName::GetPathSeparator() + result.config + ".h"};
+        wxString returnVal;
+        if (!wxCopyFile(build.configPath, workspaceConfig) || !Arduino::updateIno(returnVal, sketchPath, result.config)) {
+          result.message = "Could not copy config into workspace";
+          return;
+        }
+
+        if (!Arduino::compile(returnVal, build)) {
+          result.message = returnVal;
+          return;
+        }
+
+#       ifdef __WINDOWS__
+        // compile() returned the upload paths, the sizes are in the output it cached (which build holds on to)
+        wxString output;
+        if (BuildCache::lookup(build.cacheKey, output, true)) parseFlashUsage(output, result);
+#       else
+        parseFlashUsage(returnVal, result);
+#       endif
+        result.passed = true;
+      }();
+
+      if (onResult) onResult(++jobsDone, result);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t workerNum = 0; workerNum < numWorkers; workerNum++) workers.emplace_back(worker, workerNum);
+  for (auto& thread : workers) thread.join();
+
+  return results;
+}
+
+wxString BatchVerify::formatReport(const std::vector<Result>& results) {
+  wxString report;
+  size_t passed{0};
+  for (const auto& result : results) {
+    if (result.passed) {
+      passed++;
+      report += "PASS  " + result.config;
+      if (result.flashUsed >= 0) report += wxString::Format("  (%d bytes, %d%% flash)", result.flashUsed, result.flashPercent);
+    } else {
+      report += "FAIL  " + result.config + ": " + result.message.BeforeFirst('\n');
+    }
+    report += '\n';
+  }
+  return std::to_string(passed) + " of " + std::to_string(results.size()) + " configs verified successfully.\n\n" + report;
+}
+
+bool BatchVerify::prepareWorkspace(const wxString& workspace) {
+  const wxString sketchPath{workspace + wxFileName::GetPathSeparator() + "ProffieOS"};
+  const auto versionPath{(workspace + wxFileName::GetPathSeparator() + WORKSPACE_VERSION_FILE).ToStdString()};
+
+  std::ifstream versionFile(versionPath);
+  std::string version;
+  if (versionFile.is_open()) std::getline(versionFile, version);
+  versionFile.close();
+  if (version == PROFFIEOS_VERSION) return true;
+
+  // Fresh copy of the sketch, so this worker can point ProffieOS.ino at its own config
+  if (wxDirExists(workspace)) wxFileName::Rmdir(workspace, wxPATH_RMDIR_RECURSIVE);
+  if (!wxFileName::Mkdir(sketchPath, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) return false;
+  wxArrayString files;
+  wxDir::GetAllFiles(PROFFIEOS_PATH, &files, wxEmptyString, wxDIR_FILES | wxDIR_DIRS);
+  for (const auto& file : files) {
+    const wxString destination{sketchPath + file.Mid(std::strlen(PROFFIEOS_PATH))};
+    if (!wxFileName::Mkdir(wxFileName(destination).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) return false;
+    if (!wxCopyFile(file, destination)) return false;
+  }
+
+  std::ofstream(versionPath) << PROFFIEOS_VERSION << std::endl;
+  return true;
+}
+void BatchVerify::parseFlashUsage(const wxString& output, Result& result) {
+  // Sketch uses 214820 bytes (81%) of program storage space. Maximum is 262144 bytes.
+  auto usage{output.Find("Sketch uses ")};
+  if (usage == wxNOT_FOUND) return;
+
+  int32_t used{-1};
+  int32_t percent{-1};
+  if (std::sscanf(output.Mid(usage).ToStdString().c_str(), "Sketch uses %d bytes (%d%%)", &used, &percent) == 2) {
+    result.flashUsed = used;
+    result.flashPercent = percent;
+  }
+}
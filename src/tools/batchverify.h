@@ -0,0 +1,34 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <wx/string.h>
+
+class MainMenu;
+
+// Compiles many saved configs at once, each worker in its own copy of the
+// ProffieOS sketch and its own build directory.
+namespace BatchVerify {
+  struct Result {
+    std::string config;
+    bool passed{false};
+    wxString message{};
+    int32_t flashUsed{-1};
+    int32_t flashPercent{-1};
+  };
+
+  // Verify every config in AppState with a progress dialog, then show the report.
+  void run(MainMenu*);
+  // Blocks until every config is compiled. onResult is called from worker threads.
+  std::vector<Result> verify(const std::vector<std::string>& configs, const std::function<void(size_t done, const Result&)>& onResult = nullptr);
+  [[nodiscard]] wxString formatReport(const std::vector<Result>&);
+
+  // Keeps a private copy of the ProffieOS sketch in workspace/ProffieOS, so its
+  // ProffieOS.ino can point at a different config than everyone else's.
+  bool prepareWorkspace(const wxString& workspace);
+} // namespace BatchVerify
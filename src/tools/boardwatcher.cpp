@@ -0,0 +1,346 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/boardwatcher.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define SERIAL_VID "1209"
+#define SERIAL_PID "6668"
+#define DFU_VID "0483"
+#define DFU_PID "df11"
+
+wxDEFINE_EVENT(BoardWatcher::EVT_ADDED, BoardWatcher::Event);
+wxDEFINE_EVENT(BoardWatcher::EVT_REMOVED, BoardWatcher::Event);
+
+namespace BoardWatcher {
+  std::mutex lock;
+  std::vector<std::string> boards;
+  std::thread thread;
+  bool running{false};
+  std::vector<wxEvtHandler*> targets;
+
+# ifdef __linux__
+  int32_t socketFd{-1};
+  int32_t stopFd{-1};
+
+  void run();
+  void handleUEvent(const char* message, size_t length);
+  // Brings the list back in line with what's connected after events were lost
+  void resync();
+  void added(const std::string& board);
+  void removed(const std::string& board);
+  void post(wxEvtHandler*, wxEventType, const std::string& board);
+
+  std::string readAttribute(const std::string& dir, const char* name);
+  // Walks up from a sysfs device to the USB device it belongs to
+  std::string getUSBDevice(const std::string& sysPath);
+  bool getUSBID(const std::string& sysPath, std::string& vid, std::string& pid);
+# endif
+}
+
+bool BoardWatcher::start(wxEvtHandler* handler) {
+# ifdef __linux__
+  std::lock_guard<std::mutex> guard(lock);
+  if (running) {
+    if (std::find(targets.begin(), targets.end(), handler) == targets.end()) targets.push_back(handler);
+    for (const auto& board : boards) post(handler, EVT_ADDED, board);
+    return true;
+  }
+
+  socketFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+  if (socketFd < 0) return false;
+
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = 1; // Kernel events
+  if (bind(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+    close(socketFd);
+    socketFd = -1;
+    return false;
+  }
+
+  stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (stopFd < 0) {
+    close(socketFd);
+    socketFd = -1;
+    return false;
+  }
+
+  // Listening before scanning, so nothing is missed in between
+  std::vector<std::string> current;
+  scan(current);
+  boards = current;
+  targets = {handler};
+  for (const auto& board : boards) post(handler, EVT_ADDED, board);
+
+  running = true;
+  thread = std::thread{run};
+  return true;
+# else
+  (void)handler;
+  return false;
+# endif
+}
+
+void BoardWatcher::stop(wxEvtHandler* handler) {
+# ifdef __linux__
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    auto entry = std::find(targets.begin(), targets.end(), handler);
+    if (!running || entry == targets.end()) return;
+    targets.erase(entry);
+    if (!targets.empty()) return;
+    running = false;
+  }
+
+  uint64_t one{1};
+  auto res = write(stopFd, &one, sizeof(one));
+  (void)res;
+  if (thread.joinable()) thread.join();
+
+  close(socketFd);
+  close(stopFd);
+  socketFd = stopFd = -1;
+# else
+  (void)handler;
+# endif
+}
+
+bool BoardWatcher::isRunning() {
+  std::lock_guard<std::mutex> guard(lock);
+  return running;
+}
+
+std::vector<std::string> BoardWatcher::getBoards() {
+  std::lock_guard<std::mutex> guard(lock);
+  return boards;
+}
+
+bool BoardWatcher::has(const std::string& board) {
+  std::lock_guard<std::mutex> guard(lock);
+  return std::find(boards.begin(), boards.end(), board) != boards.end();
+}
+
+bool BoardWatcher::scan(std::vector<std::string>& found) {
+# ifdef __linux__
+  found.clear();
+  std::string vid, pid;
+
+  if (auto dir = opendir("/sys/class/tty")) {
+    while (auto entry = readdir(dir)) {
+      if (std::strncmp(entry->d_name, "ttyACM", 6) != 0) continue;
+      if (!getUSBID(std::string("/sys/class/tty/") + entry->d_name, vid, pid)) continue;
+      if (vid == SERIAL_VID && pid == SERIAL_PID) found.push_back(std::string("/dev/") + entry->d_name);
+    }
+    closedir(dir);
+  }
+
+  if (auto dir = opendir("/sys/bus/usb/devices")) {
+    while (auto entry = readdir(dir)) {
+      if (entry->d_name[0] == '.') continue;
+      std::string path{std::string("/sys/bus/usb/devices/") + entry->d_name};
+      if (readAttribute(path, "idVendor") == DFU_VID && readAttribute(path, "idProduct") == DFU_PID) {
+        found.push_back(std::string("BOOTLOADER|") + entry->d_name);
+      }
+    }
+    closedir(dir);
+  }
+
+  std::sort(found.begin(), found.end());
+  return true;
+# else
+  (void)found;
+  return false;
+# endif
+}
+
+BoardWatcher::Location BoardWatcher::locate(const std::string& board) {
+  Location location;
+# ifdef __linux__
+  std::string device;
+  if (board.rfind("BOOTLOADER|", 0) == 0) device = "/sys/bus/usb/devices/" + board.substr(std::strlen("BOOTLOADER|"));
+  else if (board.rfind("/dev/", 0) == 0) device = getUSBDevice("/sys/class/tty/" + board.substr(std::strlen("/dev/")));
+  if (device.empty()) return location;
+
+  location.port = device.substr(device.find_last_of('/') + 1);
+  location.serial = readAttribute(device, "serial");
+# else
+  (void)board;
+# endif
+  return location;
+}
+
+bool BoardWatcher::isAccessible(const std::string& board) {
+# ifdef __linux__
+  std::string node{board};
+  if (board.rfind("BOOTLOADER|", 0) == 0) {
+    const std::string device{"/sys/bus/usb/devices/" + board.substr(std::strlen("BOOTLOADER|"))};
+    const auto bus{readAttribute(device, "busnum")};
+    const auto dev{readAttribute(device, "devnum")};
+    if (bus.empty() || dev.empty()) return false;
+
+    char path[32];
+    std::snprintf(path, sizeof(path), "/dev/bus/usb/%03d/%03d", std::atoi(bus.c_str()), std::atoi(dev.c_str()));
+    node = path;
+  }
+  return access(node.c_str(), R_OK | W_OK) == 0;
+# else
+  (void)board;
+  return true;
+# endif
+}
+
+#ifdef __linux__
+void BoardWatcher::run() {
+  pollfd fds[2]{};
+  fds[0].fd = socketFd;
+  fds[0].events = POLLIN;
+  fds[1].fd = stopFd;
+  fds[1].events = POLLIN;
+
+  char buffer[8192];
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (fds[1].revents & POLLIN) return;
+    if (!(fds[0].revents & POLLIN)) continue;
+
+    bool overflowed{false};
+    while (true) {
+      auto length{recv(socketFd, buffer, sizeof(buffer), 0)};
+      if (length > 0) handleUEvent(buffer, length);
+      else if (length < 0 && errno == ENOBUFS) overflowed = true;
+      else break;
+    }
+    // More events came in than the socket could hold, e.g. a hub full of boards plugged in at once
+    if (overflowed) resync();
+  }
+}
+
+void BoardWatcher::resync() {
+  std::vector<std::string> current;
+  if (!scan(current)) return;
+
+  std::vector<std::string> known;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    known = boards;
+  }
+  for (const auto& board : known) {
+    if (std::find(current.begin(), current.end(), board) == current.end()) removed(board);
+  }
+  for (const auto& board : current) {
+    if (std::find(known.begin(), known.end(), board) == known.end()) added(board);
+  }
+}
+
+void BoardWatcher::handleUEvent(const char* message, size_t length) {
+  std::string action, devPath, subsystem, devName, devType, product;
+  // "action@devpath\0KEY=value\0KEY=value..."
+  for (size_t pos = std::strlen(message) + 1; pos < length; pos += std::strlen(message + pos) + 1) {
+    const char* field{message + pos};
+    auto value = std::strchr(field, '=');
+    if (value == nullptr) continue;
+
+    std::string key(field, value - field);
+    value++;
+    if (key == "ACTION") action = value;
+    else if (key == "DEVPATH") devPath = value;
+    else if (key == "SUBSYSTEM") subsystem = value;
+    else if (key == "DEVNAME") devName = value;
+    else if (key == "DEVTYPE") devType = value;
+    else if (key == "PRODUCT") product = value;
+  }
+  if (action != "add" && action != "remove") return;
+
+  if (subsystem == "tty" && devName.rfind("ttyACM", 0) == 0) {
+    auto board{"/dev/" + devName};
+    if (action == "remove") {
+      removed(board);
+      return;
+    }
+
+    std::string vid, pid;
+    if (getUSBID("/sys" + devPath, vid, pid) && vid == SERIAL_VID && pid == SERIAL_PID) added(board);
+  } else if (subsystem == "usb" && devType == "usb_device") {
+    // PRODUCT is "vid/pid/bcdDevice" in hex without leading zeros, and is there for removes too
+    char* end{nullptr};
+    auto vid = std::strtoul(product.c_str(), &end, 16);
+    auto pid = *end == '/' ? std::strtoul(end + 1, nullptr, 16) : 0;
+    if (vid != std::strtoul(DFU_VID, nullptr, 16) || pid != std::strtoul(DFU_PID, nullptr, 16)) return;
+
+    auto board{"BOOTLOADER|" + devPath.substr(devPath.find_last_of('/') + 1)};
+    if (action == "add") added(board);
+    else removed(board);
+  }
+}
+
+void BoardWatcher::added(const std::string& board) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (std::find(boards.begin(), boards.end(), board) != boards.end()) return;
+  boards.push_back(board);
+  for (auto target : targets) post(target, EVT_ADDED, board);
+}
+
+void BoardWatcher::removed(const std::string& board) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto entry = std::find(boards.begin(), boards.end(), board);
+  if (entry == boards.end()) return;
+  boards.erase(entry);
+  for (auto target : targets) post(target, EVT_REMOVED, board);
+}
+
+void BoardWatcher::post(wxEvtHandler* target, wxEventType type, const std::string& board) {
+  auto evt{new Event(type)};
+  evt->board = board;
+  wxQueueEvent(target, evt);
+}
+
+std::string BoardWatcher::readAttribute(const std::string& dir, const char* name) {
+  std::ifstream file(dir + "/" + name);
+  std::string value;
+  std::getline(file, value);
+  return value;
+}
+
+std::string BoardWatcher::getUSBDevice(const std::string& sysPath) {
+  char resolved[PATH_MAX];
+  if (realpath(sysPath.c_str(), resolved) == nullptr) return {};
+
+  std::string device{resolved};
+  while (device.size() > std::strlen("/sys/devices")) {
+    if (!readAttribute(device, "idVendor").empty()) return device;
+    device.erase(device.find_last_of('/'));
+  }
+  return {};
+}
+
+bool BoardWatcher::getUSBID(const std::string& sysPath, std::string& vid, std::string& pid) {
+  auto device{getUSBDevice(sysPath)};
+  if (device.empty()) return false;
+
+  vid = readAttribute(device, "idVendor");
+  pid = readAttribute(device, "idProduct");
+  return true;
+}
+#endif
@@ -0,0 +1,57 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <wx/event.h>
+
+// Keeps a live list of connected Proffieboards, in serial or bootloader (DFU)
+// mode, by watching kernel hotplug events, so nothing has to go through
+// `arduino-cli board list`.
+//
+// Entries are named the same as Arduino::getBoards() names them: the serial
+// port, or "BOOTLOADER|<usb device>".
+//
+// Only implemented for Linux (netlink uevents), elsewhere start() and scan()
+// return false and the arduino-cli path should be used instead.
+namespace BoardWatcher {
+  struct Event : wxEvent {
+    Event(wxEventType type) : wxEvent(wxID_ANY, type) {}
+
+    [[nodiscard]] wxEvent *Clone() const { return new Event(*this); }
+
+    std::string board;
+  };
+
+  wxDECLARE_EVENT(EVT_ADDED, Event);
+  wxDECLARE_EVENT(EVT_REMOVED, Event);
+
+  // Posts EVT_ADDED to handler for every board already connected, then
+  // EVT_ADDED/EVT_REMOVED as they come and go.
+  //
+  // Every handler started gets events, watching stops once all have stopped.
+  bool start(wxEvtHandler* handler);
+  void stop(wxEvtHandler* handler);
+  bool isRunning();
+
+  // The current list while running.
+  std::vector<std::string> getBoards();
+  bool has(const std::string& board);
+
+  // One-off look at what's connected, without watching.
+  bool scan(std::vector<std::string>& boards);
+
+  // Where a board is plugged in: the USB port ("1-2.3") and the device's
+  // serial number. A board keeps its port when it reboots into the
+  // bootloader and back. Empty if unknown, and always empty off Linux.
+  struct Location {
+    std::string port;
+    std::string serial;
+  };
+  [[nodiscard]] Location locate(const std::string& board);
+  // Whether the board's device node can be opened yet, which can lag behind
+  // the board showing up while udev sets its permissions.
+  [[nodiscard]] bool isAccessible(const std::string& board);
+} // namespace BoardWatcher
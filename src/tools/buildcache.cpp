@@ -0,0 +1,184 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/buildcache.h"
+
+#include "core/defines.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <wx/arrstr.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+
+#define BUILDCACHE_OUTPUT "output.txt"
+#define BUILDCACHE_BATCH "batch"
+#define BUILDCACHE_MAX_ENTRIES 8
+#define BUILD_VERSION_FILE ".version"
+#define BUILD_VERSION PROFFIEOS_VERSION "/" ARDUINO_PBPLUGIN_VERSION
+
+namespace BuildCache {
+  std::mutex lock;
+  // Signaled (with lock) when a compile gives up its key
+  std::condition_variable compileDone;
+  // Keys claimed by prepare(), and keys with a Use, which prune() leaves alone
+  std::set<std::string> building;
+  std::map<std::string, int32_t> inUse;
+  std::map<std::string, std::mutex> buildPathLocks;
+
+  void hash(uint64_t&, const char* data, size_t length);
+  void prune();
+}
+
+void BuildCache::hash(uint64_t& state, const char* data, size_t length) {
+  // FNV-1a
+  for (size_t idx = 0; idx < length; idx++) {
+    state ^= static_cast<uint8_t>(data[idx]);
+    state *= 0x100000001b3;
+  }
+}
+
+std::string BuildCache::getKey(const std::string& configPath, const wxString& fqbn, const wxString& boardOptions) {
+  uint64_t state{0xcbf29ce484222325};
+
+  std::ifstream config(configPath, std::ios::binary);
+  std::string contents{std::istreambuf_iterator<char>(config), std::istreambuf_iterator<char>()};
+  hash(state, contents.data(), contents.size());
+
+  // Separate fields so moving text between them changes the key
+  for (const std::string& field : { fqbn.ToStdString(), boardOptions.ToStdString(), std::string(PROFFIEOS_VERSION), std::string(ARDUINO_PBPLUGIN_VERSION) }) {
+    hash(state, "\0", 1);
+    hash(state, field.data(), field.size());
+  }
+
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016" PRIx64, state);
+  return key;
+}
+wxString BuildCache::getDir(const std::string& key) { return BUILDCACHE_DIR + key; }
+
+bool BuildCache::has(const std::string& key) {
+  std::lock_guard<std::mutex> guard(lock);
+  return wxFileName::FileExists(getDir(key) + wxFileName::GetPathSeparator() + BUILDCACHE_OUTPUT);
+}
+bool BuildCache::lookup(const std::string& key, wxString& output, bool batch) {
+  std::lock_guard<std::mutex> guard(lock);
+  std::ifstream file((getDir(key) + wxFileName::GetPathSeparator() + BUILDCACHE_OUTPUT).ToStdString(), std::ios::binary);
+  if (!file.is_open()) return false;
+
+  output = std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  // Touch the entry so pruning keeps recently used builds around
+  wxFileName(getDir(key), BUILDCACHE_OUTPUT).Touch();
+  const wxFileName batchFile(getDir(key), BUILDCACHE_BATCH);
+  if (!batch && batchFile.FileExists()) wxRemoveFile(batchFile.GetFullPath());
+  return true;
+}
+
+bool BuildCache::prepare(const std::string& key) {
+  std::unique_lock<std::mutex> guard(lock);
+  // Identical configs (e.g. in a batch verify) share a key, only one can compile into it
+  compileDone.wait(guard, [&]() { return building.find(key) == building.end(); });
+  if (wxFileName::FileExists(getDir(key) + wxFileName::GetPathSeparator() + BUILDCACHE_OUTPUT)) return false;
+
+  building.insert(key);
+  if (wxDirExists(getDir(key))) wxFileName::Rmdir(getDir(key), wxPATH_RMDIR_RECURSIVE);
+  wxFileName::Mkdir(getDir(key), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+  return true;
+}
+bool BuildCache::store(const std::string& key, const wxString& output, bool batch) {
+  std::lock_guard<std::mutex> guard(lock);
+  building.erase(key);
+  compileDone.notify_all();
+  // Output is written last, its presence is what marks the entry usable
+  const auto outputPath{(getDir(key) + wxFileName::GetPathSeparator() + BUILDCACHE_OUTPUT).ToStdString()};
+  std::ofstream file(outputPath + ".tmp", std::ios::binary);
+  if (!file.is_open()) return false;
+  file << output;
+  file.close();
+  if (batch) std::ofstream((getDir(key) + wxFileName::GetPathSeparator() + BUILDCACHE_BATCH).ToStdString());
+  if (file.fail() || !wxRenameFile(outputPath + ".tmp", outputPath)) return false;
+
+  prune();
+  return true;
+}
+void BuildCache::discard(const std::string& key) {
+  std::lock_guard<std::mutex> guard(lock);
+  building.erase(key);
+  compileDone.notify_all();
+  // Never complete, so nobody can be reading from it
+  if (wxDirExists(getDir(key))) wxFileName::Rmdir(getDir(key), wxPATH_RMDIR_RECURSIVE);
+}
+
+BuildCache::Use::Use(const std::string& key) : key(key) {
+  std::lock_guard<std::mutex> guard(lock);
+  inUse[key]++;
+}
+BuildCache::Use::~Use() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (--inUse[key] <= 0) inUse.erase(key);
+}
+
+void BuildCache::prune() {
+  wxDir cacheDir(BUILDCACHE_DIR);
+  if (!cacheDir.IsOpened()) return;
+
+  struct Entry {
+    bool batch;
+    wxDateTime modified;
+    wxString name;
+  };
+  std::vector<Entry> entries;
+  wxString entry;
+  for (bool found = cacheDir.GetFirst(&entry, wxEmptyString, wxDIR_DIRS); found; found = cacheDir.GetNext(&entry)) {
+    wxFileName outputFile(BUILDCACHE_DIR + entry, BUILDCACHE_OUTPUT);
+    if (!outputFile.FileExists()) continue; // Could be a compile in progress
+    if (building.find(entry.ToStdString()) != building.end() || inUse.find(entry.ToStdString()) != inUse.end()) continue;
+    entries.push_back({ wxFileName(BUILDCACHE_DIR + entry, BUILDCACHE_BATCH).FileExists(), outputFile.GetModificationTime(), entry });
+  }
+  if (entries.size() <= BUILDCACHE_MAX_ENTRIES) return;
+
+  // Keep regular entries over batch ones, then the most recently used
+  std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+    if (lhs.batch != rhs.batch) return !lhs.batch;
+    return lhs.modified.IsLaterThan(rhs.modified);
+  });
+  for (auto oldEntry = entries.begin() + BUILDCACHE_MAX_ENTRIES; oldEntry != entries.end(); oldEntry++) {
+    wxFileName::Rmdir(BUILDCACHE_DIR + oldEntry->name, wxPATH_RMDIR_RECURSIVE);
+  }
+}
+
+wxString BuildCache::getBuildPath(const wxString& fqbn, const wxString& boardOptions, const wxString& suffix) {
+  // proffieboard:stm32l4:ProffieboardV3-L452RE + usb=cdc_msc,dosfs=sdmmc1 -> ProffieboardV3-L452RE_cdc_msc_sdmmc1
+  wxString name{fqbn.AfterLast(':')};
+  for (const auto& option : wxSplit(boardOptions, ',')) name += '_' + option.AfterFirst('=');
+  if (!suffix.empty()) name += '_' + suffix;
+  const wxString buildPath{BUILD_DIR + name};
+
+  std::lock_guard<std::mutex> guard(lock);
+  const auto versionPath{(buildPath + wxFileName::GetPathSeparator() + BUILD_VERSION_FILE).ToStdString()};
+  std::ifstream versionFile(versionPath);
+  std::string version;
+  if (versionFile.is_open()) std::getline(versionFile, version);
+  versionFile.close();
+  if (version == BUILD_VERSION) return buildPath;
+
+  if (wxDirExists(buildPath)) wxFileName::Rmdir(buildPath, wxPATH_RMDIR_RECURSIVE);
+  wxFileName::Mkdir(buildPath, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+  std::ofstream(versionPath) << BUILD_VERSION << std::endl;
+  return buildPath;
+}
+std::unique_lock<std::mutex> BuildCache::lockBuildPath(const wxString& buildPath) {
+  std::unique_lock<std::mutex> guard(lock);
+  auto& pathLock{buildPathLocks[buildPath.ToStdString()]};
+  guard.unlock();
+  return std::unique_lock<std::mutex>(pathLock);
+}
@@ -0,0 +1,51 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <wx/string.h>
+
+// Finished compiles, stored by a hash of everything that goes into them so an
+// unchanged config can skip straight to upload.
+namespace BuildCache {
+  // Key covering the config header contents, FQBN, board options and ProffieOS/plugin versions.
+  [[nodiscard]] std::string getKey(const std::string& configPath, const wxString& fqbn, const wxString& boardOptions);
+  // Directory the compiled firmware for a key lives in (arduino-cli --output-dir/--input-dir).
+  [[nodiscard]] wxString getDir(const std::string& key);
+
+  [[nodiscard]] bool has(const std::string& key);
+  // Looking up a batch entry for anything but another batch makes it a regular one.
+  [[nodiscard]] bool lookup(const std::string& key, wxString& output, bool batch = false);
+
+  // Claims the key for a compile, clearing out any partial entry and creating
+  // its directory, until store() or discard(). If another compile has the key
+  // this waits for it, and returns false if it left a complete entry to lookup().
+  bool prepare(const std::string& key);
+  // Marks the entry complete. Must only be called once the firmware is in getDir(key).
+  // Batch entries (e.g. from verifying every config) are pruned before any
+  // regular one, so they never push out the builds the user just made.
+  bool store(const std::string& key, const wxString& output, bool batch = false);
+  void discard(const std::string& key);
+
+  // Keeps an entry from being pruned while its firmware is read, e.g. by an upload.
+  class Use {
+  public:
+    Use(const std::string& key);
+    ~Use();
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
+
+  private:
+    std::string key;
+  };
+
+  // Persistent arduino-cli --build-path for a board/options combination, so
+  // unchanged core and library objects are reused between compiles. Wiped
+  // whenever the ProffieOS or plugin version it was built with changes.
+  // Callers compiling in parallel pass a suffix to get a directory of their own.
+  [[nodiscard]] wxString getBuildPath(const wxString& fqbn, const wxString& boardOptions, const wxString& suffix = {});
+  // Held while compiling in a build path, two compiles in one would corrupt each other's objects.
+  [[nodiscard]] std::unique_lock<std::mutex> lockBuildPath(const wxString& buildPath);
+} // namespace BuildCache
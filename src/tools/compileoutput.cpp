@@ -0,0 +1,125 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/compileoutput.h"
+
+#include <algorithm>
+#include <cstring>
+
+// parseError() looks back a few lines, e.g. for "overflowed" before ld's "error"
+#define ERROR_CONTEXT_LINES 20
+// Nobody needs more than this of a single line, long compiler commands are cut
+#define MAX_LINE_LENGTH (16 * 1024)
+
+namespace CompileOutput {
+  // Approximate share of a compile each stage ends at, for when the number of steps isn't known
+  int32_t getStageEnd(Stage);
+  std::string getFileName(const std::string& path);
+}
+
+const char* CompileOutput::getStageName(Stage stage) {
+  switch (stage) {
+    case Stage::STARTING: return "Starting";
+    case Stage::DETECTING_LIBRARIES: return "Detecting libraries";
+    case Stage::PROTOTYPES: return "Generating prototypes";
+    case Stage::SKETCH: return "Compiling ProffieOS";
+    case Stage::LIBRARIES: return "Compiling libraries";
+    case Stage::CORE: return "Compiling core";
+    case Stage::LINKING: return "Linking";
+    case Stage::SIZE: return "Checking size";
+  }
+  return "";
+}
+
+void CompileOutput::Parser::feed(const char* data, size_t length) {
+  for (size_t idx = 0; idx < length; idx++) {
+    if (data[idx] == '\n') {
+      parseLine(partialLine);
+      partialLine.clear();
+    } else if (data[idx] != '\r' && partialLine.size() < MAX_LINE_LENGTH) {
+      partialLine += data[idx];
+    }
+  }
+}
+
+void CompileOutput::Parser::finish() {
+  if (partialLine.empty()) return;
+  parseLine(partialLine);
+  partialLine.clear();
+}
+
+std::string CompileOutput::Parser::getError() const {
+  return errorContext + errorLine + '\n';
+}
+
+void CompileOutput::Parser::parseLine(const std::string& line) {
+  if (errorLine.empty() && line.find("error") != std::string::npos) {
+    errorLine = line;
+    for (const auto& recent : recentLines) errorContext += recent + '\n';
+  }
+  recentLines.push_back(line);
+  if (recentLines.size() > ERROR_CONTEXT_LINES) recentLines.pop_front();
+
+  auto startsWith = [&](const char* prefix) { return line.compare(0, std::strlen(prefix), prefix) == 0; };
+  if (startsWith("Detecting libraries used")) step(Stage::DETECTING_LIBRARIES);
+  else if (startsWith("Generating function prototypes")) step(Stage::PROTOTYPES);
+  else if (startsWith("Compiling sketch")) step(Stage::SKETCH);
+  else if (startsWith("Compiling libraries")) step(Stage::LIBRARIES);
+  else if (startsWith("Compiling library \"")) step(Stage::LIBRARIES, line.substr(std::strlen("Compiling library \""), line.find('"', std::strlen("Compiling library \"")) - std::strlen("Compiling library \"")));
+  else if (startsWith("Compiling core")) step(Stage::CORE);
+  else if (startsWith("Linking everything together")) step(Stage::LINKING);
+  else if (startsWith("Sketch uses") || startsWith("Global variables use")) {
+    if (current.stage != Stage::SIZE) step(Stage::SIZE);
+    summary += line + '\n';
+  } else if (startsWith("Using previously compiled file: ")) {
+    step(current.stage, getFileName(line.substr(std::strlen("Using previously compiled file: "))));
+  } else if (current.stage >= Stage::SKETCH && current.stage <= Stage::CORE && line.find(" -c ") != std::string::npos) {
+    // Compiler command, `... -c "src/file.cpp" -o "build/file.cpp.o"`
+    auto output{line.rfind(" -o ")};
+    if (output != std::string::npos) {
+      auto path{line.substr(output + 4)};
+      path.erase(std::remove(path.begin(), path.end(), '"'), path.end());
+      path = path.substr(0, path.find(' '));
+      step(current.stage, getFileName(path));
+    }
+  }
+
+  // Windows upload needs this one later, see Arduino::parseUploadPaths()
+  if (line.find("ProffieOS.ino.dfu") != std::string::npos && line.find("stm32l4") != std::string::npos) summary += line + '\n';
+}
+
+void CompileOutput::Parser::step(Stage stage, std::string file) {
+  stepCount++;
+  current.stage = stage;
+  current.file = std::move(file);
+
+  if (expectedSteps > 0) {
+    // Different files can be rebuilt from one compile to the next, so never claim to be done early
+    current.percent = std::min<int32_t>(99, stepCount * 100 / expectedSteps);
+  } else {
+    const auto previous{stage == Stage::STARTING ? 0 : getStageEnd(static_cast<Stage>(static_cast<int32_t>(stage) - 1))};
+    current.percent = std::max(current.percent, previous);
+  }
+  if (onUpdate) onUpdate(current);
+}
+
+int32_t CompileOutput::getStageEnd(Stage stage) {
+  switch (stage) {
+    case Stage::STARTING: return 0;
+    case Stage::DETECTING_LIBRARIES: return 10;
+    case Stage::PROTOTYPES: return 15;
+    case Stage::SKETCH: return 50;
+    case Stage::LIBRARIES: return 60;
+    case Stage::CORE: return 85;
+    case Stage::LINKING: return 95;
+    case Stage::SIZE: return 100;
+  }
+  return 0;
+}
+
+std::string CompileOutput::getFileName(const std::string& path) {
+  auto name{path.substr(path.find_last_of("/\\") + 1)};
+  // "file.cpp.o" -> "file.cpp"
+  if (name.size() > 2 && name.compare(name.size() - 2, 2, ".o") == 0) name.resize(name.size() - 2);
+  return name;
+}
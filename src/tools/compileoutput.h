@@ -0,0 +1,71 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+// Follows `arduino-cli compile -v` output as it comes in, turning it into
+// stages and files for progress, without holding on to all of it.
+namespace CompileOutput {
+  enum class Stage {
+    STARTING,
+    DETECTING_LIBRARIES,
+    PROTOTYPES,
+    SKETCH,
+    LIBRARIES,
+    CORE,
+    LINKING,
+    SIZE,
+  };
+
+  struct Update {
+    Stage stage{Stage::STARTING};
+    // Source file or library currently being compiled, if any
+    std::string file{};
+    // -1 when there's no estimate
+    int32_t percent{-1};
+  };
+
+  [[nodiscard]] const char* getStageName(Stage);
+
+  class Parser {
+  public:
+    // expectedSteps is what steps() was after the last compile of the same
+    // build, 0 if unknown, and is what percentages are based on.
+    Parser(std::function<void(const Update&)> onUpdate, uint32_t expectedSteps = 0) : onUpdate(std::move(onUpdate)), expectedSteps(expectedSteps) {}
+
+    void feed(const char* data, size_t length);
+    // Parse anything left without a newline
+    void finish();
+
+    [[nodiscard]] bool hasError() const { return !errorLine.empty(); }
+    // The first error with the lines before it, for Arduino::parseError()
+    [[nodiscard]] std::string getError() const;
+    // Just the lines anything else needs later: the size report, and the .dfu
+    // upload line on Windows. This is what goes in the BuildCache.
+    [[nodiscard]] const std::string& getSummary() const { return summary; }
+    // Stage changes and files seen
+    [[nodiscard]] uint32_t steps() const { return stepCount; }
+
+  private:
+    void parseLine(const std::string& line);
+    void step(Stage, std::string file = {});
+
+    std::function<void(const Update&)> onUpdate;
+    const uint32_t expectedSteps;
+
+    std::string partialLine{};
+    // Kept for error context
+    std::deque<std::string> recentLines{};
+    std::string errorLine{};
+    std::string errorContext{};
+    std::string summary{};
+
+    Update current{};
+    uint32_t stepCount{0};
+  };
+} // namespace CompileOutput
@@ -0,0 +1,426 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/dfu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <linux/usbdevice_fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#define IMAGE_NAME "ProffieOS.ino"
+#define DFUSE_PREFIX "DfuSe"
+#define DFU_SUFFIX_LENGTH 16
+
+#define DFU_INTERFACE 0
+#define DEFAULT_TRANSFER_SIZE 2048
+#define CONTROL_TIMEOUT 5000 // ms
+
+// DFU 1.1 requests
+#define DFU_DNLOAD 1
+#define DFU_UPLOAD 2
+#define DFU_GETSTATUS 3
+#define DFU_CLRSTATUS 4
+#define DFU_ABORT 6
+
+// DfuSe commands, sent as a download to block 0
+#define DFUSE_SET_ADDRESS 0x21
+#define DFUSE_ERASE 0x41
+// Data blocks start at 2, block n is at address + (n - 2) * transferSize
+#define DFUSE_FIRST_BLOCK 2
+
+namespace DFU {
+  enum State : uint8_t {
+    APP_IDLE = 0,
+    APP_DETACH = 1,
+    DFU_IDLE = 2,
+    DNLOAD_SYNC = 3,
+    DNBUSY = 4,
+    DNLOAD_IDLE = 5,
+    MANIFEST_SYNC = 6,
+    MANIFEST = 7,
+    MANIFEST_WAIT_RESET = 8,
+    UPLOAD_IDLE = 9,
+    ERROR = 10,
+  };
+
+  struct Status {
+    uint8_t status{0};
+    uint32_t pollTimeout{0};
+    State state{ERROR};
+  };
+
+  // One run of same-size pages, from the "@Internal Flash /0x08000000/0256*0002Kg" layout
+  struct Sector {
+    uint32_t start;
+    uint32_t count;
+    uint32_t size;
+  };
+
+  bool readFile(const std::string& path, std::string& contents);
+
+# ifdef __linux__
+  class Device {
+  public:
+    ~Device();
+
+    bool open(const std::string& board, std::string& error);
+
+    bool getStatus(Status&);
+    bool clearStatus();
+    bool abort();
+    bool download(uint16_t block, const char* data, uint16_t length);
+    bool upload(uint16_t block, char* data, uint16_t length);
+    // Runs a DfuSe command and waits for it to finish
+    bool command(uint8_t command, uint32_t address, std::string& error);
+    // Waits out busy states, until the device is idle again
+    bool waitIdle(Status&);
+    bool toIdle(std::string& error);
+
+    uint16_t transferSize{DEFAULT_TRANSFER_SIZE};
+    std::vector<Sector> layout;
+
+  private:
+    int32_t control(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, void* data, uint16_t length);
+    bool readDescriptors(std::string& error);
+    std::string getString(uint8_t index);
+
+    int32_t fd{-1};
+    bool claimed{false};
+  };
+
+  bool parseLayout(const std::string& description, std::vector<Sector>&);
+# endif
+}
+
+bool DFU::isSupported() {
+# ifdef __linux__
+  return true;
+# else
+  return false;
+# endif
+}
+
+bool DFU::loadImage(const std::string& outputDir, Image& image, std::string& error) {
+  std::string contents;
+  if (readFile(outputDir + "/" IMAGE_NAME ".bin", contents)) {
+    image.address = 0x08000000;
+    image.data = std::move(contents);
+    return true;
+  }
+
+  if (!readFile(outputDir + "/" IMAGE_NAME ".dfu", contents)) {
+    error = "Could not find compiled firmware in " + outputDir;
+    return false;
+  }
+
+  if (contents.size() < DFU_SUFFIX_LENGTH || contents.compare(contents.size() - 8, 3, "UFD") != 0) {
+    error = "Firmware file has no DFU suffix";
+    return false;
+  }
+  contents.resize(contents.size() - DFU_SUFFIX_LENGTH);
+
+  if (contents.compare(0, std::strlen(DFUSE_PREFIX), DFUSE_PREFIX) != 0) {
+    image.address = 0x08000000;
+    image.data = std::move(contents);
+    return true;
+  }
+
+  // DfuSe prefix (11 bytes), target prefix (274 bytes), then elements of address, size, data.
+  // ProffieOS is always one target with one element.
+  auto getU32 = [&](size_t pos) {
+    uint32_t value{0};
+    for (size_t idx = 0; idx < 4; idx++) value |= static_cast<uint32_t>(static_cast<uint8_t>(contents[pos + idx])) << (idx * 8);
+    return value;
+  };
+  constexpr size_t ELEMENT_OFFSET{11 + 274};
+  if (contents.size() < ELEMENT_OFFSET + 8) {
+    error = "DfuSe firmware file is truncated";
+    return false;
+  }
+  image.address = getU32(ELEMENT_OFFSET);
+  const auto size{getU32(ELEMENT_OFFSET + 4)};
+  if (contents.size() < ELEMENT_OFFSET + 8 + size) {
+    error = "DfuSe firmware file is truncated";
+    return false;
+  }
+  image.data = contents.substr(ELEMENT_OFFSET + 8, size);
+  return true;
+}
+
+bool DFU::flash(const std::string& board, const Image& image, std::string& error, bool& started, const ProgressFunc& onProgress) {
+  started = false;
+# ifdef __linux__
+  auto progress = [&](Stage stage, size_t done) { if (onProgress) onProgress(stage, done, image.data.size()); };
+  if (image.data.empty()) {
+    error = "Firmware is empty";
+    return false;
+  }
+
+  Device device;
+  if (!device.open(board, error) || !device.toIdle(error)) return false;
+
+  started = true;
+  const uint32_t end{image.address + static_cast<uint32_t>(image.data.size())};
+  for (const auto& sector : device.layout) {
+    for (uint32_t page = 0; page < sector.count; page++) {
+      const uint32_t pageStart{sector.start + page * sector.size};
+      if (pageStart + sector.size <= image.address || pageStart >= end) continue;
+      if (!device.command(DFUSE_ERASE, pageStart, error)) return false;
+      progress(Stage::ERASE, std::min<size_t>(image.data.size(), pageStart + sector.size - image.address));
+    }
+  }
+
+  if (!device.command(DFUSE_SET_ADDRESS, image.address, error)) return false;
+  Status status;
+  uint16_t block{DFUSE_FIRST_BLOCK};
+  for (size_t pos = 0; pos < image.data.size(); pos += device.transferSize, block++) {
+    const auto length{static_cast<uint16_t>(std::min<size_t>(device.transferSize, image.data.size() - pos))};
+    if (!device.download(block, image.data.data() + pos, length) || !device.waitIdle(status)) {
+      error = "Write failed at " + std::to_string(image.address + pos);
+      return false;
+    }
+    progress(Stage::WRITE, pos + length);
+  }
+
+  if (!device.toIdle(error) || !device.command(DFUSE_SET_ADDRESS, image.address, error) || !device.toIdle(error)) return false;
+  std::string readBack(device.transferSize, '\0');
+  block = DFUSE_FIRST_BLOCK;
+  for (size_t pos = 0; pos < image.data.size(); pos += device.transferSize, block++) {
+    const auto length{static_cast<uint16_t>(std::min<size_t>(device.transferSize, image.data.size() - pos))};
+    if (!device.upload(block, readBack.data(), length)) {
+      error = "Readback failed at " + std::to_string(image.address + pos);
+      return false;
+    }
+    if (image.data.compare(pos, length, readBack, 0, length) != 0) {
+      error = "Verify failed, flash differs from firmware near " + std::to_string(image.address + pos);
+      return false;
+    }
+    progress(Stage::VERIFY, pos + length);
+  }
+
+  // Zero-length download after setting the address has the bootloader jump to it
+  if (!device.toIdle(error) || !device.command(DFUSE_SET_ADDRESS, image.address, error)) return false;
+  device.download(DFUSE_FIRST_BLOCK, nullptr, 0);
+  device.getStatus(status); // The board resets here, so this usually fails
+  return true;
+# else
+  (void)board;
+  (void)image;
+  (void)onProgress;
+  error = "Direct DFU upload is not supported on this platform";
+  return false;
+# endif
+}
+
+bool DFU::readFile(const std::string& path, std::string& contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+#ifdef __linux__
+DFU::Device::~Device() {
+  if (fd < 0) return;
+  if (claimed) {
+    uint32_t interface{DFU_INTERFACE};
+    ioctl(fd, USBDEVFS_RELEASEINTERFACE, &interface);
+  }
+  close(fd);
+}
+
+bool DFU::Device::open(const std::string& board, std::string& error) {
+  if (board.rfind("BOOTLOADER|", 0) != 0) {
+    error = "Board is not in bootloader mode";
+    return false;
+  }
+  const std::string sysPath{"/sys/bus/usb/devices/" + board.substr(std::strlen("BOOTLOADER|"))};
+  std::ifstream busFile(sysPath + "/busnum");
+  std::ifstream devFile(sysPath + "/devnum");
+  int32_t bus{0}, dev{0};
+  if (!(busFile >> bus) || !(devFile >> dev)) {
+    error = "Bootloader disappeared";
+    return false;
+  }
+
+  char path[32];
+  std::snprintf(path, sizeof(path), "/dev/bus/usb/%03d/%03d", bus, dev);
+  fd = ::open(path, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    error = std::string("Could not open bootloader: ") + std::strerror(errno) + "\nMake sure the Proffieboard udev rules are installed.";
+    return false;
+  }
+
+  uint32_t interface{DFU_INTERFACE};
+  if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &interface) < 0) {
+    error = std::string("Could not claim bootloader: ") + std::strerror(errno);
+    return false;
+  }
+  claimed = true;
+
+  usbdevfs_setinterface alternate{};
+  alternate.interface = DFU_INTERFACE;
+  alternate.altsetting = 0; // Internal flash
+  if (ioctl(fd, USBDEVFS_SETINTERFACE, &alternate) < 0) {
+    error = std::string("Could not select internal flash: ") + std::strerror(errno);
+    return false;
+  }
+
+  return readDescriptors(error);
+}
+
+int32_t DFU::Device::control(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, void* data, uint16_t length) {
+  usbdevfs_ctrltransfer transfer{};
+  transfer.bRequestType = requestType;
+  transfer.bRequest = request;
+  transfer.wValue = value;
+  transfer.wIndex = index;
+  transfer.wLength = length;
+  transfer.timeout = CONTROL_TIMEOUT;
+  transfer.data = data;
+  return ioctl(fd, USBDEVFS_CONTROL, &transfer);
+}
+
+bool DFU::Device::getStatus(Status& status) {
+  uint8_t data[6];
+  if (control(0xA1, DFU_GETSTATUS, 0, DFU_INTERFACE, data, sizeof(data)) != sizeof(data)) return false;
+  status.status = data[0];
+  status.pollTimeout = data[1] | (data[2] << 8) | (data[3] << 16);
+  status.state = static_cast<State>(data[4]);
+  return true;
+}
+bool DFU::Device::clearStatus() { return control(0x21, DFU_CLRSTATUS, 0, DFU_INTERFACE, nullptr, 0) >= 0; }
+bool DFU::Device::abort() { return control(0x21, DFU_ABORT, 0, DFU_INTERFACE, nullptr, 0) >= 0; }
+bool DFU::Device::download(uint16_t block, const char* data, uint16_t length) {
+  return control(0x21, DFU_DNLOAD, block, DFU_INTERFACE, const_cast<char*>(data), length) == length;
+}
+bool DFU::Device::upload(uint16_t block, char* data, uint16_t length) {
+  return control(0xA1, DFU_UPLOAD, block, DFU_INTERFACE, data, length) == length;
+}
+
+bool DFU::Device::waitIdle(Status& status) {
+  // The request is only carried out once status is asked for
+  do {
+    if (!getStatus(status)) return false;
+    if (status.state == DNBUSY) std::this_thread::sleep_for(std::chrono::milliseconds(status.pollTimeout));
+  } while (status.state == DNBUSY || status.state == DNLOAD_SYNC);
+  return status.state == DNLOAD_IDLE && status.status == 0;
+}
+
+bool DFU::Device::toIdle(std::string& error) {
+  Status status;
+  for (int32_t attempt = 0; attempt < 3; attempt++) {
+    if (!getStatus(status)) break;
+    if (status.state == DFU_IDLE) return true;
+    if (status.state == ERROR) clearStatus();
+    else abort();
+  }
+  error = "Bootloader is not responding";
+  return false;
+}
+
+bool DFU::Device::command(uint8_t command, uint32_t address, std::string& error) {
+  const char data[5]{
+    static_cast<char>(command),
+    static_cast<char>(address & 0xFF),
+    static_cast<char>((address >> 8) & 0xFF),
+    static_cast<char>((address >> 16) & 0xFF),
+    static_cast<char>((address >> 24) & 0xFF),
+  };
+  Status status;
+  if (download(0, data, sizeof(data)) && waitIdle(status)) return true;
+
+  char addressStr[16];
+  std::snprintf(addressStr, sizeof(addressStr), "0x%08x", address);
+  error = std::string(command == DFUSE_ERASE ? "Erase" : "Set address") + " failed at " + addressStr;
+  return false;
+}
+
+bool DFU::Device::readDescriptors(std::string& error) {
+  // usbdevfs hands out the cached device descriptor followed by the configuration(s)
+  std::string descriptors;
+  char buffer[1024];
+  ssize_t length;
+  lseek(fd, 0, SEEK_SET);
+  while ((length = read(fd, buffer, sizeof(buffer))) > 0) descriptors.append(buffer, length);
+
+  std::string layoutDescription;
+  bool inDFU{false};
+  for (size_t pos = 18; pos + 2 <= descriptors.size(); pos += static_cast<uint8_t>(descriptors[pos])) {
+    const auto descLength{static_cast<uint8_t>(descriptors[pos])};
+    const auto descType{static_cast<uint8_t>(descriptors[pos + 1])};
+    if (descLength < 2 || pos + descLength > descriptors.size()) break;
+
+    if (descType == 0x04 && descLength >= 9) { // Interface
+      const auto number{static_cast<uint8_t>(descriptors[pos + 2])};
+      const auto alternate{static_cast<uint8_t>(descriptors[pos + 3])};
+      inDFU = number == DFU_INTERFACE;
+      if (inDFU && alternate == 0) layoutDescription = getString(static_cast<uint8_t>(descriptors[pos + 8]));
+    } else if (descType == 0x21 && descLength >= 7 && inDFU) { // DFU functional
+      transferSize = static_cast<uint8_t>(descriptors[pos + 5]) | (static_cast<uint8_t>(descriptors[pos + 6]) << 8);
+      if (transferSize == 0) transferSize = DEFAULT_TRANSFER_SIZE;
+    }
+  }
+
+  if (!parseLayout(layoutDescription, layout)) {
+    error = "Could not read flash layout from bootloader (\"" + layoutDescription + "\")";
+    return false;
+  }
+  return true;
+}
+
+std::string DFU::Device::getString(uint8_t index) {
+  if (index == 0) return {};
+  uint8_t data[255];
+  auto length{control(0x80, 0x06 /* GET_DESCRIPTOR */, (0x03 << 8) | index, 0x0409, data, sizeof(data))};
+  std::string str;
+  // UTF-16LE, the layout is always ASCII
+  for (int32_t pos = 2; pos + 1 < length; pos += 2) str += static_cast<char>(data[pos]);
+  return str;
+}
+
+bool DFU::parseLayout(const std::string& description, std::vector<Sector>& layout) {
+  // "@Internal Flash  /0x08000000/0256*0002Kg" or several runs: "/0x08000000/04*016Kg,01*064Kg,07*128Kg"
+  layout.clear();
+  auto slash{description.find('/')};
+  if (slash == std::string::npos) return false;
+
+  char* pos{nullptr};
+  uint32_t address{static_cast<uint32_t>(std::strtoul(description.c_str() + slash + 1, &pos, 16))};
+  if (*pos != '/') return false;
+  pos++;
+
+  while (*pos != '\0') {
+    Sector sector;
+    sector.start = address;
+    sector.count = std::strtoul(pos, &pos, 10);
+    if (*pos != '*') return false;
+    sector.size = std::strtoul(pos + 1, &pos, 10);
+    if (*pos == 'K') sector.size *= 1024, pos++;
+    else if (*pos == 'M') sector.size *= 1024 * 1024, pos++;
+    else if (*pos == ' ') pos++;
+    if (*pos != '\0' && *pos != ',' && *pos != '/') pos++; // Access flags (a-g)
+
+    if (sector.count == 0 || sector.size == 0) return false;
+    layout.push_back(sector);
+    address += sector.count * sector.size;
+
+    if (*pos == ',') pos++;
+    else break;
+  }
+  return !layout.empty();
+}
+#endif
@@ -0,0 +1,40 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Flashes the STM32 ROM bootloader directly over USB (DFU 1.1 with ST's
+// DfuSe extensions), instead of going through arduino-cli and dfu-util.
+//
+// Only implemented for Linux (usbdevfs), elsewhere isSupported() is false.
+namespace DFU {
+  enum class Stage {
+    ERASE,
+    WRITE,
+    VERIFY,
+  };
+  // done/total are bytes of the image
+  using ProgressFunc = std::function<void(Stage, size_t done, size_t total)>;
+
+  struct Image {
+    uint32_t address{0x08000000};
+    std::string data;
+  };
+
+  [[nodiscard]] bool isSupported();
+
+  // Reads the firmware arduino-cli put in outputDir: the .bin, or failing
+  // that the .dfu (plain with a DFU suffix, or DfuSe).
+  bool loadImage(const std::string& outputDir, Image&, std::string& error);
+
+  // board is a bootloader as named by BoardWatcher ("BOOTLOADER|<usb device>").
+  // Erases only the pages the image covers, writes, reads everything back to
+  // verify, and then has the board leave the bootloader and boot it.
+  // Until started is set nothing on the board has been changed, so on failure
+  // another way of uploading can still be tried.
+  bool flash(const std::string& board, const Image&, std::string& error, bool& started, const ProgressFunc& onProgress = nullptr);
+} // namespace DFU
@@ -0,0 +1,248 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/flashqueue.h"
+
+#if !defined(__WINDOWS__)
+#include "core/defines.h"
+#include "core/config/configuration.h"
+#include "mainmenu/mainmenu.h"
+#include "tools/batchverify.h"
+#include "tools/buildcache.h"
+
+#include <algorithm>
+
+#include <wx/filename.h>
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+
+using namespace std::chrono_literals;
+
+// Long enough for a freshly flashed board to boot back into ProffieOS
+#define RETURN_GRACE 15s
+#define POLL_INTERVAL 3s
+#define WORKSPACE BATCH_DIR "queue"
+
+enum {
+  COLUMN_BOARD,
+  COLUMN_STATUS,
+  COLUMN_PROGRESS,
+};
+
+FlashQueue* FlashQueue::instance{nullptr};
+wxEventTypeTag<wxCommandEvent> FlashQueue::EVT_JOB(wxNewEventType());
+wxEventTypeTag<wxCommandEvent> FlashQueue::EVT_BUILT(wxNewEventType());
+wxEventTypeTag<wxCommandEvent> FlashQueue::EVT_BUILD_PROGRESS(wxNewEventType());
+
+FlashQueue::FlashQueue(MainMenu* parent, EditorWindow* editor) :
+  wxFrame(parent, wxID_ANY, "Flash Multiple Boards - " + editor->getOpenConfig()),
+  configName(editor->getOpenConfig()),
+  model(editor->model),
+  build(Arduino::getBuild(editor))
+{
+  instance = this;
+
+  auto master = new wxBoxSizer(wxVERTICAL);
+  summary = new wxStaticText(this, wxID_ANY, "Compiling " + configName + "...");
+  list = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxSize(550, 250), wxLC_REPORT | wxLC_SINGLE_SEL);
+  list->AppendColumn("Board", wxLIST_FORMAT_LEFT, 220);
+  list->AppendColumn("Status", wxLIST_FORMAT_LEFT, 250);
+  list->AppendColumn("Progress", wxLIST_FORMAT_RIGHT, 70);
+
+  master->Add(summary, wxSizerFlags(0).Border(wxALL, 10).Expand());
+  master->Add(list, wxSizerFlags(1).Border(wxLEFT | wxRIGHT | wxBOTTOM, 10).Expand());
+  SetSizerAndFit(master);
+
+  BindEvents();
+  StartBuild();
+  if (!BoardWatcher::start(this)) pollThread = std::thread{&FlashQueue::PollBoards, this};
+
+  Show(true);
+}
+
+FlashQueue::~FlashQueue() {
+  BoardWatcher::stop(this);
+  {
+    std::lock_guard<std::mutex> guard(pollLock);
+    stopping = true;
+  }
+  pollWake.notify_all();
+  if (pollThread.joinable()) pollThread.join();
+  if (buildThread.joinable()) buildThread.join();
+  for (auto& job : jobs) if (job->thread.joinable()) job->thread.join();
+  instance = nullptr;
+}
+
+void FlashQueue::BindEvents() {
+  Bind(wxEVT_CLOSE_WINDOW, [&](wxCloseEvent& event) {
+    if (isBusy() && event.CanVeto()) {
+      wxMessageDialog(this, "Wait for the boards being flashed to finish before closing.", "Flashing In Progress", wxOK | wxCENTER | wxICON_EXCLAMATION).ShowModal();
+      event.Veto();
+      return;
+    }
+    event.Skip();
+  });
+  Bind(BoardWatcher::EVT_ADDED, [&](BoardWatcher::Event& evt) { BoardAdded(evt.board); });
+  Bind(BoardWatcher::EVT_REMOVED, [&](BoardWatcher::Event& evt) { BoardRemoved(evt.board); });
+  Bind(EVT_BUILT, [&](wxCommandEvent& evt) {
+    buildThread.join();
+    if (!evt.GetInt()) {
+      buildFailed = true;
+      summary->SetLabel("Could not compile " + configName + ":\n\n" + evt.GetString());
+      Fit();
+      return;
+    }
+
+    built = true;
+    for (size_t idx = 0; idx < jobs.size(); idx++) if (jobs[idx]->state == State::WAITING) StartJob(idx);
+    UpdateSummary();
+  });
+  Bind(EVT_BUILD_PROGRESS, [&](wxCommandEvent& evt) {
+    wxString label{"Compiling " + configName + "..."};
+    if (evt.GetInt() >= 0) label += wxString::Format(" %d%%", evt.GetInt());
+    summary->SetLabel(label + "\n" + evt.GetString());
+    Layout();
+  });
+  Bind(EVT_JOB, [&](wxCommandEvent& event) {
+    auto& evt{static_cast<JobEvent&>(event)};
+    auto& job{*jobs[evt.job]};
+    job.state = evt.state;
+    SetRow(evt.job, evt.status, evt.progress);
+    if (job.state == State::DONE || job.state == State::FAILED) {
+      job.thread.join();
+      // A board that failed often stays in the bootloader, and whatever's plugged in next on the port is a new one
+      if (job.state == State::DONE) returning[job.key] = std::chrono::steady_clock::now() + RETURN_GRACE;
+      UpdateSummary();
+    }
+  });
+}
+
+void FlashQueue::StartBuild() {
+  buildThread = std::thread{[this]() {
+    auto evt{new wxCommandEvent(EVT_BUILT)};
+    std::string error;
+    wxString returnVal;
+
+    build.sketchPath = WORKSPACE + wxString{wxFileName::GetPathSeparator()} + "ProffieOS";
+    build.buildPath = BuildCache::getBuildPath(build.fqbn, build.boardOptions, "queue");
+    const wxString workspaceConfig{build.sketchPath + wxFileName::GetPathSeparator() + "config" + wxFileName::GetPathSeparator() + configName + ".h"};
+
+    if (!Configuration::outputConfig(build.configPath, model, error)) evt->SetString(error);
+    else if (!BatchVerify::prepareWorkspace(WORKSPACE) || !wxCopyFile(build.configPath, workspaceConfig)) evt->SetString("Could not copy config into workspace");
+    else if (!Arduino::updateIno(returnVal, build.sketchPath, configName)) evt->SetString("Could not update ProffieOS file: " + returnVal);
+    else if (!Arduino::compile(returnVal, build, [this](int32_t percent, const wxString& message) {
+      auto progressEvt{new wxCommandEvent(EVT_BUILD_PROGRESS)};
+      progressEvt->SetInt(percent);
+      progressEvt->SetString(message);
+      wxQueueEvent(this, progressEvt);
+    })) evt->SetString(returnVal);
+    else evt->SetInt(true);
+
+    wxQueueEvent(this, evt);
+  }};
+}
+
+void FlashQueue::BoardAdded(const std::string& board) {
+  const auto location{BoardWatcher::locate(board)};
+  const auto key{location.port.empty() ? board : location.port};
+  const bool isBootloader{board.rfind("BOOTLOADER", 0) == 0};
+
+  for (const auto& job : jobs) {
+    if (job->state != State::FLASHING) continue;
+    // The board being flashed rebooting into the bootloader.
+    // Where a board is plugged in isn't known everywhere, any bootloader could be it then.
+    if (job->key == key || (location.port.empty() && isBootloader)) return;
+  }
+  auto returned{returning.find(key)};
+  if (returned != returning.end()) {
+    const bool expected{std::chrono::steady_clock::now() < returned->second};
+    returning.erase(returned);
+    if (expected) return;
+  }
+
+  auto& job{*jobs.emplace_back(std::make_unique<Job>())};
+  job.board = board;
+  job.key = key;
+  const size_t idx{jobs.size() - 1};
+  list->InsertItem(idx, location.serial.empty() ? board : board + " (" + location.serial + ")");
+  SetRow(idx, buildFailed ? "Not flashed" : "Waiting for compile...", 0);
+
+  if (built) StartJob(idx);
+  UpdateSummary();
+}
+
+void FlashQueue::BoardRemoved(const std::string& board) {
+  for (size_t idx = 0; idx < jobs.size(); idx++) {
+    auto& job{*jobs[idx]};
+    if (job.board != board || job.state != State::WAITING) continue;
+    job.state = State::UNPLUGGED;
+    SetRow(idx, "Unplugged", 0);
+  }
+  UpdateSummary();
+}
+
+void FlashQueue::StartJob(size_t idx) {
+  auto& job{*jobs[idx]};
+  job.state = State::FLASHING;
+  SetRow(idx, "Waiting for bootloader...", 5);
+  job.thread = std::thread{[this, idx, board = job.board]() {
+    wxQueueEvent(this, new JobEvent(idx, State::FLASHING, 30, "Uploading..."));
+
+    wxString returnVal;
+    const bool flashed{Arduino::upload(returnVal, build, board, [&](int32_t percent, const wxString& message) {
+      if (percent >= 0) wxQueueEvent(this, new JobEvent(idx, State::FLASHING, 30 + percent * 69 / 100, message));
+    })};
+    if (flashed) wxQueueEvent(this, new JobEvent(idx, State::DONE, 100, "Done"));
+    else wxQueueEvent(this, new JobEvent(idx, State::FAILED, 100, "Failed: " + returnVal.BeforeFirst('\n')));
+  }};
+}
+
+void FlashQueue::SetRow(size_t idx, const wxString& status, int32_t progress) {
+  list->SetItem(idx, COLUMN_STATUS, status);
+  list->SetItem(idx, COLUMN_PROGRESS, wxString::Format("%d%%", progress));
+}
+
+void FlashQueue::UpdateSummary() {
+  if (!built) return;
+
+  size_t flashing{0}, done{0}, failed{0};
+  for (const auto& job : jobs) {
+    if (job->state == State::FLASHING) flashing++;
+    else if (job->state == State::DONE) done++;
+    else if (job->state == State::FAILED) failed++;
+  }
+  summary->SetLabel(wxString::Format("%zu flashed, %zu failed, %zu in progress.\n", done, failed, flashing) + "Plug in more boards to flash them with " + configName + ".");
+  Layout();
+}
+
+void FlashQueue::PollBoards() {
+  std::vector<wxString> known;
+  std::unique_lock<std::mutex> guard(pollLock);
+  while (!stopping) {
+    guard.unlock();
+    auto boards{Arduino::getBoards()};
+    boards.erase(boards.begin()); // "Select Board..."
+    for (const auto& board : boards) {
+      if (std::find(known.begin(), known.end(), board) != known.end()) continue;
+      auto evt{new BoardWatcher::Event(BoardWatcher::EVT_ADDED)};
+      evt->board = board.ToStdString();
+      wxQueueEvent(this, evt);
+    }
+    for (const auto& board : known) {
+      if (std::find(boards.begin(), boards.end(), board) != boards.end()) continue;
+      auto evt{new BoardWatcher::Event(BoardWatcher::EVT_REMOVED)};
+      evt->board = board.ToStdString();
+      wxQueueEvent(this, evt);
+    }
+    known = std::move(boards);
+    guard.lock();
+
+    pollWake.wait_for(guard, POLL_INTERVAL, [&]() { return stopping; });
+  }
+}
+
+bool FlashQueue::isBusy() const {
+  if (buildThread.joinable()) return true;
+  return std::any_of(jobs.begin(), jobs.end(), [](const std::unique_ptr<Job>& job) { return job->state == State::FLASHING; });
+}
+#endif
@@ -0,0 +1,101 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#if !defined(__WINDOWS__)
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wx/frame.h>
+#include <wx/listctrl.h>
+#include <wx/stattext.h>
+
+#include "core/config/configmodel.h"
+#include "tools/arduino.h"
+#include "tools/boardwatcher.h"
+
+// Compiles a config once, then flashes it onto every Proffieboard that's
+// connected or gets plugged in while the window is open, for building
+// sabers in batches.
+class FlashQueue : public wxFrame {
+public:
+  // Uses the editor's model as last saved.
+  FlashQueue(MainMenu*, EditorWindow*);
+  ~FlashQueue();
+  static FlashQueue* instance;
+
+private:
+  enum class State {
+    WAITING,
+    FLASHING,
+    DONE,
+    FAILED,
+    UNPLUGGED,
+  };
+
+  class JobEvent;
+  static wxEventTypeTag<wxCommandEvent> EVT_JOB;
+  static wxEventTypeTag<wxCommandEvent> EVT_BUILT;
+  static wxEventTypeTag<wxCommandEvent> EVT_BUILD_PROGRESS;
+
+  struct Job {
+    std::string board;
+    // USB port if known, otherwise the board itself
+    std::string key;
+    State state{State::WAITING};
+    std::thread thread;
+  };
+
+  wxStaticText* summary{nullptr};
+  wxListCtrl* list{nullptr};
+
+  const std::string configName;
+  const ConfigModel model;
+  // Built in a workspace of its own, so the editor can verify/apply meanwhile
+  Arduino::Build build;
+  std::thread buildThread;
+  bool built{false};
+  bool buildFailed{false};
+
+  // One row each, never removed so job threads can refer to them by index
+  std::vector<std::unique_ptr<Job>> jobs;
+  // Boards just flashed, which will reappear once they've rebooted
+  std::map<std::string, std::chrono::steady_clock::time_point> returning;
+
+  // Without BoardWatcher, boards are found by polling Arduino::getBoards()
+  std::thread pollThread;
+  std::mutex pollLock;
+  std::condition_variable pollWake;
+  bool stopping{false};
+
+  void BindEvents();
+  void StartBuild();
+  void BoardAdded(const std::string&);
+  void BoardRemoved(const std::string&);
+  void StartJob(size_t job);
+  void SetRow(size_t job, const wxString& status, int32_t progress);
+  void UpdateSummary();
+  void PollBoards();
+  [[nodiscard]] bool isBusy() const;
+};
+
+class FlashQueue::JobEvent : public wxCommandEvent {
+public:
+  JobEvent(size_t job, State state, int32_t progress, const wxString& status) : job(job), state(state), progress(progress), status(status) {
+    this->SetEventType(EVT_JOB);
+    this->SetId(wxID_ANY);
+  }
+
+  size_t job;
+  State state;
+  int32_t progress;
+  wxString status;
+};
+#endif
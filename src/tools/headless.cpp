@@ -0,0 +1,225 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/headless.h"
+
+#include "core/defines.h"
+#include "core/appstate.h"
+#include "core/config/configuration.h"
+#include "tools/arduino.h"
+#include "tools/batchverify.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#define CLI_FLAG "--cli"
+
+namespace Headless {
+  int usage();
+  int listConfigs();
+  int listBoards();
+  int importConfig(const std::vector<std::string>& args);
+  int verifyConfigs(const std::vector<std::string>& args);
+  int flashConfig(const std::vector<std::string>& args);
+  int regenerateConfigs(const std::vector<std::string>& args);
+
+  bool knownConfig(const std::string& config);
+}
+
+bool Headless::requested(int argc, char** argv) {
+  for (int32_t arg = 1; arg < argc; arg++) {
+    if (std::strcmp(argv[arg], CLI_FLAG) == 0) return true;
+  }
+  return false;
+}
+
+int Headless::run(int argc, char** argv) {
+  std::vector<std::string> args;
+  for (int32_t arg = 1; arg < argc; arg++) {
+    if (std::strcmp(argv[arg], CLI_FLAG) != 0) args.emplace_back(argv[arg]);
+  }
+  if (args.empty()) return usage();
+
+  AppState::init(true);
+
+  const auto command{args.front()};
+  args.erase(args.begin());
+  if (command == "list") return listConfigs();
+  if (command == "boards") return listBoards();
+  if (command == "import") return importConfig(args);
+  if (command == "verify") return verifyConfigs(args);
+  if (command == "flash") return flashConfig(args);
+  if (command == "regenerate") return regenerateConfigs(args);
+  if (command == "help" || command == "--help") {
+    usage();
+    return 0;
+  }
+
+  std::cerr << "Unknown command \"" << command << "\"" << std::endl;
+  return usage();
+}
+
+int Headless::usage() {
+  std::cerr <<
+    "Usage: ProffieConfig " CLI_FLAG " <command> [args]\n"
+    "\n"
+    "Commands:\n"
+    "  list                      List saved configs\n"
+    "  boards                    List connected Proffieboards\n"
+    "  import <file.h> [name]    Copy a config header into ProffieConfig\n"
+    "  verify <config>... | all  Compile configs and report flash usage\n"
+    "  flash <config> <port>     Compile a config and upload it to the board on port\n"
+    "  regenerate <config>... | all\n"
+    "                            Read configs and write them back out in ProffieConfig's format\n";
+  return 2;
+}
+
+int Headless::listConfigs() {
+  for (const auto& config : AppState::instance->getConfigFileNames()) std::cout << config << '\n';
+  return 0;
+}
+
+int Headless::listBoards() {
+  const auto boards{Arduino::getBoards()};
+  // First entry is the "Select Board..." placeholder
+  for (auto board = std::next(boards.begin()); board < boards.end(); board++) std::cout << *board << '\n';
+  return 0;
+}
+
+int Headless::importConfig(const std::vector<std::string>& args) {
+  if (args.empty() || args.size() > 2) return usage();
+
+  const wxFileName source{args[0]};
+  if (!source.FileExists()) {
+    std::cerr << "File \"" << args[0] << "\" does not exist." << std::endl;
+    return 1;
+  }
+  const auto name{args.size() == 2 ? args[1] : source.GetName().ToStdString()};
+  if (name.empty() || name.find_first_of("/\\. ") != std::string::npos) {
+    std::cerr << "Invalid config name \"" << name << "\"." << std::endl;
+    return 1;
+  }
+  if (knownConfig(name)) {
+    std::cerr << "Config \"" << name << "\" already exists." << std::endl;
+    return 1;
+  }
+
+  // Make sure we'll be able to build it before taking it in
+  Arduino::Build build;
+  if (!Arduino::readBuild(args[0], build)) {
+    std::cerr << "\"" << args[0] << "\" does not look like a ProffieOS config (no board include found)." << std::endl;
+    return 1;
+  }
+
+  if (!wxCopyFile(source.GetFullPath(), CONFIG_DIR + name + ".h")) {
+    std::cerr << "Could not copy config file." << std::endl;
+    return 1;
+  }
+  AppState::instance->addConfig(name);
+  AppState::instance->saveState();
+
+  std::cout << "Imported " << name << std::endl;
+  return 0;
+}
+
+int Headless::verifyConfigs(const std::vector<std::string>& args) {
+  if (args.empty()) return usage();
+
+  std::vector<std::string> configs;
+  if (args.size() == 1 && args[0] == "all") configs = AppState::instance->getConfigFileNames();
+  else configs = args;
+
+  for (const auto& config : configs) {
+    if (knownConfig(config)) continue;
+    std::cerr << "Unknown config \"" << config << "\"." << std::endl;
+    return 1;
+  }
+
+  auto results{BatchVerify::verify(configs, [&](size_t done, const BatchVerify::Result& result) {
+    std::cerr << "[" << done << "/" << configs.size() << "] " << result.config << (result.passed ? " passed" : " failed") << std::endl;
+  })};
+  std::cout << BatchVerify::formatReport(results) << std::endl;
+
+  auto failed{std::count_if(results.begin(), results.end(), [](const BatchVerify::Result& result) { return !result.passed; })};
+  return failed ? 1 : 0;
+}
+
+int Headless::flashConfig(const std::vector<std::string>& args) {
+  if (args.size() != 2) return usage();
+
+  const auto& config{args[0]};
+  const wxString port{args[1]};
+  if (!knownConfig(config)) {
+    std::cerr << "Unknown config \"" << config << "\"." << std::endl;
+    return 1;
+  }
+
+  Arduino::Build build;
+  if (!Arduino::readBuild(CONFIG_DIR + config + ".h", build)) {
+    std::cerr << "Could not read board settings from \"" << config << "\"." << std::endl;
+    return 1;
+  }
+
+  wxString returnVal;
+  std::cerr << "Updating ProffieOS file..." << std::endl;
+  if (!Arduino::updateIno(returnVal, build.sketchPath, config)) {
+    std::cerr << "There was an error while updating ProffieOS file:\n\n" << returnVal << std::endl;
+    return 1;
+  }
+
+  std::cerr << "Compiling ProffieOS..." << std::endl;
+  if (!Arduino::compile(returnVal, build)) {
+    std::cerr << "There was an error while compiling:\n\n" << returnVal << std::endl;
+    return 1;
+  }
+
+  std::cerr << "Uploading to " << port << "..." << std::endl;
+  if (!Arduino::upload(returnVal, build, port)) {
+    std::cerr << "There was an error while uploading:\n\n" << returnVal << std::endl;
+    return 1;
+  }
+
+  std::cout << "Flashed " << config << " to " << port << std::endl;
+  return 0;
+}
+
+int Headless::regenerateConfigs(const std::vector<std::string>& args) {
+  if (args.empty()) return usage();
+
+  std::vector<std::string> configs;
+  if (args.size() == 1 && args[0] == "all") configs = AppState::instance->getConfigFileNames();
+  else configs = args;
+
+  int32_t failed{0};
+  for (const auto& config : configs) {
+    if (!knownConfig(config)) {
+      std::cerr << "Unknown config \"" << config << "\"." << std::endl;
+      failed++;
+      continue;
+    }
+
+    ConfigModel model;
+    std::string error;
+    const auto path{CONFIG_DIR + config + ".h"};
+    if (!Configuration::readConfig(path, model, error) || !Configuration::outputConfig(path, model, error)) {
+      std::cerr << config << ": " << error << std::endl;
+      failed++;
+      continue;
+    }
+    std::cout << "Regenerated " << config << std::endl;
+  }
+
+  return failed ? 1 : 0;
+}
+
+bool Headless::knownConfig(const std::string& config) {
+  const auto& configs{AppState::instance->getConfigFileNames()};
+  return std::find(configs.begin(), configs.end(), config) != configs.end();
+}
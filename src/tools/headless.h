@@ -0,0 +1,12 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+// `ProffieConfig --cli <command> ...`: scriptable import/verify/flash without
+// opening any windows, so it also works on machines with no display.
+namespace Headless {
+  [[nodiscard]] bool requested(int argc, char** argv);
+  // Returns the process exit code
+  int run(int argc, char** argv);
+} // namespace Headless
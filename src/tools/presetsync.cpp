@@ -0,0 +1,33 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/presetsync.h"
+
+PresetSync::Plan PresetSync::diff(const std::vector<ConfigModel::Preset>& presets, const SerialParser::PresetList& board, int32_t currentPreset) {
+  Plan plan;
+  if (presets.size() != board.presets.size()) {
+    plan.blocker = "The board has " + std::to_string(board.presets.size()) + " presets but the config has " + std::to_string(presets.size()) + ".";
+    return plan;
+  }
+
+  for (size_t idx = 0; idx < presets.size(); idx++) {
+    const auto& preset{presets[idx]};
+    const auto& boardPreset{board.presets[idx]};
+
+    std::vector<std::string> changes;
+    auto font = preset.dirs.ToStdString();
+    auto track = preset.track.ToStdString();
+    auto name = preset.name.ToStdString();
+    if (font != boardPreset.font) changes.push_back("set_font " + font);
+    if (track != boardPreset.track) changes.push_back("set_track " + track);
+    if (name != boardPreset.name) changes.push_back("set_name " + name);
+    if (changes.empty()) continue;
+
+    plan.changedPresets++;
+    plan.commands.push_back("set_preset " + std::to_string(idx));
+    plan.commands.insert(plan.commands.end(), changes.begin(), changes.end());
+  }
+
+  if (!plan.commands.empty()) plan.commands.push_back("set_preset " + std::to_string(currentPreset));
+  return plan;
+}
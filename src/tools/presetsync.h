@@ -0,0 +1,29 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include "core/config/configmodel.h"
+#include "tools/serialparser.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Works out the serial commands to make a board's presets match a config's
+// without recompiling.
+//
+// Only font, track, and name can be changed this way. Styles are compiled
+// into ProffieOS (the board only reports them as "builtin <preset> <blade>"),
+// so changing them, or the number of presets, still needs a full apply.
+namespace PresetSync {
+  struct Plan {
+    std::vector<std::string> commands{};
+    int32_t changedPresets{0};
+    // Non-empty if the board can't be made to match live
+    std::string blocker{};
+  };
+
+  // currentPreset is returned to afterwards, since commands apply to the current preset.
+  Plan diff(const std::vector<ConfigModel::Preset>& presets, const SerialParser::PresetList& board, int32_t currentPreset);
+} // namespace PresetSync
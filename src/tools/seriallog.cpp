@@ -0,0 +1,182 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/seriallog.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+
+#define LOG_HEADER "# ProffieConfig serial log 1"
+
+SerialLog::Writer::~Writer() { close(); }
+
+bool SerialLog::Writer::open(const std::string& path) {
+  close();
+
+  file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file.is_open()) return false;
+
+  auto now = std::time(nullptr);
+  file << LOG_HEADER "\n# Started " << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S") << '\n';
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    start = std::chrono::steady_clock::now();
+    stopping = false;
+    opened = true;
+  }
+  thread = std::thread{[this]() { run(); }};
+  return true;
+}
+
+void SerialLog::Writer::close() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+    opened = false;
+    stopping = true;
+  }
+  wake.notify_one();
+  if (thread.joinable()) thread.join();
+  file.close();
+}
+
+bool SerialLog::Writer::isOpen() {
+  std::lock_guard<std::mutex> guard(lock);
+  return opened;
+}
+
+void SerialLog::Writer::record(Direction direction, const std::string& data) {
+  if (data.empty()) return;
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    queue.push_back({ static_cast<uint64_t>(time), direction, data });
+  }
+  wake.notify_one();
+}
+
+void SerialLog::Writer::run() {
+  std::vector<Entry> entries;
+  std::string buffer;
+  while (true) {
+    bool done;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+      entries.swap(queue);
+      done = stopping;
+    }
+
+    buffer.clear();
+    for (const auto& entry : entries) {
+      buffer += std::to_string(entry.time);
+      buffer += ' ';
+      buffer += static_cast<char>(entry.direction);
+      buffer += ' ';
+      buffer += escape(entry.data);
+      buffer += '\n';
+    }
+    entries.clear();
+
+    file.write(buffer.data(), buffer.size());
+    file.flush();
+
+    if (done) return;
+  }
+}
+
+bool SerialLog::read(const std::string& path, std::vector<Entry>& entries, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    error = "Could not open \"" + path + "\".";
+    return false;
+  }
+
+  entries.clear();
+  std::string line;
+  int32_t lineNum{0};
+  while (std::getline(file, line)) {
+    lineNum++;
+    if (line.empty() || line[0] == '#') continue;
+
+    Entry entry;
+    auto timeEnd = line.find(' ');
+    if (
+        timeEnd == std::string::npos ||
+        timeEnd + 2 >= line.size() ||
+        (line[timeEnd + 1] != static_cast<char>(Direction::RECEIVED) && line[timeEnd + 1] != static_cast<char>(Direction::SENT)) ||
+        line[timeEnd + 2] != ' '
+        ) {
+      error = "Malformed record on line " + std::to_string(lineNum) + ".";
+      return false;
+    }
+
+    char* end{nullptr};
+    entry.time = std::strtoull(line.c_str(), &end, 10);
+    entry.direction = static_cast<Direction>(line[timeEnd + 1]);
+    if (end != line.c_str() + timeEnd || !unescape(line.substr(timeEnd + 3), entry.data)) {
+      error = "Malformed record on line " + std::to_string(lineNum) + ".";
+      return false;
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  return true;
+}
+
+std::string SerialLog::escape(const std::string& data) {
+  static constexpr char hex[]{"0123456789ABCDEF"};
+
+  std::string ret;
+  ret.reserve(data.size());
+  for (unsigned char chr : data) {
+    switch (chr) {
+      case '\\': ret += "\\\\"; break;
+      case '\r': ret += "\\r"; break;
+      case '\n': ret += "\\n"; break;
+      case '\t': ret += "\\t"; break;
+      default:
+        if (chr >= 0x20 && chr < 0x7F) ret += static_cast<char>(chr);
+        else {
+          ret += "\\x";
+          ret += hex[chr >> 4];
+          ret += hex[chr & 0xF];
+        }
+    }
+  }
+  return ret;
+}
+
+bool SerialLog::unescape(const std::string& data, std::string& out) {
+  out.clear();
+  out.reserve(data.size());
+  for (size_t idx = 0; idx < data.size(); idx++) {
+    if (data[idx] != '\\') {
+      out += data[idx];
+      continue;
+    }
+
+    if (++idx >= data.size()) return false;
+    switch (data[idx]) {
+      case '\\': out += '\\'; break;
+      case 'r': out += '\r'; break;
+      case 'n': out += '\n'; break;
+      case 't': out += '\t'; break;
+      case 'x': {
+        if (idx + 2 >= data.size() || !std::isxdigit(data[idx + 1]) || !std::isxdigit(data[idx + 2])) return false;
+        auto value = std::strtol(data.substr(idx + 1, 2).c_str(), nullptr, 16);
+        out += static_cast<char>(value);
+        idx += 2;
+        break;
+      }
+      default: return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,65 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timestamped capture of serial traffic, for looking at a board's behavior
+// later without it attached.
+//
+// Logs are text, one record per line: "<ms since start> <'<' or '>'> <data>",
+// with '<' for received and '>' for sent. Data is escaped C-style (\r, \n,
+// \t, \\, \xHH) so any bytes survive. Lines starting with '#' are comments.
+namespace SerialLog {
+  enum class Direction : char {
+    RECEIVED = '<',
+    SENT = '>',
+  };
+
+  struct Entry {
+    uint64_t time{0};
+    Direction direction{Direction::RECEIVED};
+    std::string data{};
+  };
+
+  // Formatting and disk writes happen on its own thread, record() only queues.
+  // Safe to use from multiple threads.
+  class Writer {
+  public:
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    ~Writer();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen();
+    // Does nothing if not open.
+    void record(Direction, const std::string& data);
+
+  private:
+    void run();
+
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<Entry> queue;
+    bool opened{false};
+    bool stopping{false};
+
+    std::ofstream file;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  bool read(const std::string& path, std::vector<Entry>&, std::string& error);
+
+  std::string escape(const std::string&);
+  bool unescape(const std::string&, std::string& out);
+} // namespace SerialLog
@@ -5,7 +5,9 @@
 #include <string>
 
 #include "core/defines.h"
+#include "core/utilities/misc.h"
 #include "mainmenu/mainmenu.h"
+#include "tools/presetsync.h"
 
 #ifdef __WINDOWS__
 #include <windows.h>
@@ -15,10 +17,12 @@
 #else
 #include <wx/msgdlg.h>
 #endif
+#include <wx/filedlg.h>
+#include <wx/filename.h>
 
 SerialMonitor* SerialMonitor::instance;
 #if defined(__WINDOWS__)
-SerialMonitor::SerialMonitor(MainMenu* parent) {
+SerialMonitor::SerialMonitor(MainMenu* parent, const std::string&) {
   if (parent->boardSelect->entry()->GetSelection() > 0) {
         ShellExecute(NULL, NULL, TEXT(ARDUINO_PATH), std::wstring(L"monitor -p " + parent->boardSelect->entry()->GetStringSelection().ToStdWstring() + L" -c baudrate=115200").c_str(), NULL, true);
   } else wxMessageDialog(parent, "Select board first.", "No Board Selected", wxOK | wxICON_ERROR).ShowModal();
@@ -26,28 +30,53 @@ SerialMonitor::SerialMonitor(MainMenu* parent) {
 
 #elif defined(__WXOSX__) || defined(__WXGTK__)
 
+#include <cerrno>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <termios.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
-using namespace std::chrono_literals;
+#define REFRESH_RATE 30
+// Anything older has scrolled out of output's history anyways
+#define MAX_INCOMING (1024 * 1024)
 
-SerialMonitor::SerialMonitor(MainMenu* parent) : wxFrame(parent, wxID_ANY, "Proffie Serial")
+SerialMonitor::SerialMonitor(MainMenu* parent, const std::string& replayLog) :
+  wxFrame(parent, wxID_ANY, "Proffie Serial"),
+  parser([this](SerialParser::Record&& record) { wxQueueEvent(GetEventHandler(), new RecordEvent(std::move(record))); })
 {
   instance = this;
 
   wxBoxSizer *master = new wxBoxSizer(wxVERTICAL);
-
-  input = new pcTextCtrl(this, ID_SerialCommand, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
-  output = new pcTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(500, 200), wxTE_MULTILINE | wxTE_READONLY | wxNO_BORDER);
-
-  master->Add(input, BOXITEMFLAGS);
+  auto top = new wxBoxSizer(wxHORIZONTAL);
+
+  if (replayLog.empty()) {
+    input = new pcTextCtrl(this, ID_SerialCommand, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+    captureButton = new wxButton(this, ID_Capture, "Start Capture...");
+    captureButton->SetToolTip("Save everything sent and received, with timestamps, to a log which can be replayed later.");
+    top->Add(input, wxSizerFlags(1).Border(wxALL, 10).Expand());
+    top->Add(captureButton, wxSizerFlags(0).Border(wxALL, 10).Bottom());
+  } else {
+    SetTitle("Proffie Serial Replay - " + wxFileName(replayLog).GetFullName());
+    replaySpeed = new pcChoice(this, ID_ReplaySpeed, "Replay Speed", wxDefaultPosition, wxDefaultSize, Misc::createEntries({ "1x", "2x", "5x", "10x", "Instant" }), 0);
+    replaySpeed->entry()->SetSelection(0);
+    top->Add(replaySpeed, BOXITEMFLAGS);
+  }
+  output = new pcLogView(this, wxID_ANY, wxDefaultPosition, wxSize(500, 200));
+  refreshTimer.SetOwner(this);
+
+  master->Add(top, wxSizerFlags(0).Expand());
   master->Add(output, wxSizerFlags(1).Border(wxALL, 10).Expand());
+  CreateStatusBar(3);
 
   BindEvents();
-  OpenDevice();
+  if (replayLog.empty()) OpenDevice();
+  else StartReplay(replayLog);
 
   SetSizerAndFit(master);
   Show(true);
@@ -55,28 +84,54 @@ SerialMonitor::SerialMonitor(MainMenu* parent) : wxFrame(parent, wxID_ANY, "Prof
 
 
 SerialMonitor::~SerialMonitor() {
-#if defined(__WXOSX__) || defined(__WXGTK__)
-  close(fd);
-#elif defined(__WINDOWS__)
-  CloseHandle(serHandle);
-#endif
+  {
+    std::lock_guard<std::mutex> guard(sendLock);
+    stopping = true;
+  }
+  Wake();
+  replayWake.notify_all();
+  if (ioThread.joinable()) ioThread.join();
+  if (replayThread.joinable()) replayThread.join();
+  refreshTimer.Stop();
+  capture.close();
+
+  if (fd >= 0) close(fd);
+  if (wakeRead >= 0) close(wakeRead);
+  if (wakeWrite >= 0 && wakeWrite != wakeRead) close(wakeWrite);
 
   instance = nullptr;
-
-  if (devThread.joinable()) devThread.join();
-  if (listenThread.joinable()) listenThread.join();
-  if (writerThread.joinable()) writerThread.join();
 }
 
 wxEventTypeTag<wxCommandEvent> SerialMonitor::EVT_INPUT(wxNewEventType());
 wxEventTypeTag<wxCommandEvent> SerialMonitor::EVT_DISCON(wxNewEventType());
+wxEventTypeTag<wxCommandEvent> SerialMonitor::EVT_RECORD(wxNewEventType());
 void SerialMonitor::BindEvents()
 {
   Bind(wxEVT_TEXT_ENTER, [&](wxCommandEvent&) {
-        sendOut = SerialMonitor::instance->input->entry()->GetValue();
-        SerialMonitor::instance->input->entry()->Clear();
+        SendCommand(input->entry()->GetValue().ToStdString());
+        input->entry()->Clear();
       }, ID_SerialCommand);
-  Bind(EVT_INPUT, [&](wxCommandEvent& evt) { output->entry()->AppendText(((SerialDataEvent*)&evt)->value); }, wxID_ANY);
+  Bind(EVT_INPUT, [&](wxCommandEvent&) {
+        constexpr std::chrono::milliseconds interval{1000 / REFRESH_RATE};
+        auto sinceLast = std::chrono::steady_clock::now() - lastRefresh;
+        if (sinceLast >= interval) FlushInput();
+        else if (!refreshTimer.IsRunning()) {
+          refreshTimer.StartOnce(std::chrono::duration_cast<std::chrono::milliseconds>(interval - sinceLast).count() + 1);
+        }
+      }, wxID_ANY);
+  Bind(wxEVT_TIMER, [&](wxTimerEvent&) { FlushInput(); });
+  Bind(EVT_RECORD, [&](wxCommandEvent& evt) {
+        const auto& record{static_cast<RecordEvent*>(&evt)->record};
+        UpdateStatus(record);
+        if (auto preset = std::get_if<SerialParser::CurrentPreset>(&record)) boardPreset = preset->index;
+        if (auto presets = std::get_if<SerialParser::PresetList>(&record); presets && pendingPush) FinishPush(*presets);
+        evt.Skip();
+      }, wxID_ANY);
+  Bind(wxEVT_BUTTON, [&](wxCommandEvent&) { ToggleCapture(); }, ID_Capture);
+  Bind(wxEVT_CHOICE, [&](wxCommandEvent&) {
+        static constexpr int32_t speeds[]{ 1, 2, 5, 10, 0 };
+        speed = speeds[replaySpeed->entry()->GetSelection()];
+      }, ID_ReplaySpeed);
   Bind(EVT_DISCON, [&](wxCommandEvent&) {
         SerialMonitor::instance->Close(true);
       }, wxID_ANY);
@@ -85,75 +140,226 @@ void SerialMonitor::BindEvents()
 void SerialMonitor::OpenDevice() {
     struct termios newtio;
 
-    fd = open(static_cast<MainMenu*>(GetParent())->boardSelect->entry()->GetStringSelection().data(), O_RDWR | O_NOCTTY);
+    fd = open(static_cast<MainMenu*>(GetParent())->boardSelect->entry()->GetStringSelection().data(), O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (fd < 0) {
         wxMessageDialog(GetParent(), "Could not connect to proffieboard.", "Serial Error", wxICON_ERROR | wxOK).ShowModal();
         SerialMonitor::instance->Close(true);
         return;
     }
 
+#   ifdef __linux__
+    wakeRead = wakeWrite = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#   else
+    int32_t wakePipe[2];
+    if (pipe(wakePipe) == 0) {
+        wakeRead = wakePipe[0];
+        wakeWrite = wakePipe[1];
+        fcntl(wakeRead, F_SETFL, O_NONBLOCK);
+        fcntl(wakeWrite, F_SETFL, O_NONBLOCK);
+    }
+#   endif
+    if (wakeRead < 0) {
+        wxMessageDialog(GetParent(), "Could not start serial monitor.", "Serial Error", wxICON_ERROR | wxOK).ShowModal();
+        SerialMonitor::instance->Close(true);
+        return;
+    }
+
     memset(&newtio, 0, sizeof(newtio));
 
     newtio.c_cflag = B115200 | CRTSCTS | CS8 | CLOCAL | CREAD;
     newtio.c_iflag = IGNPAR;
     newtio.c_oflag = (tcflag_t) NULL;
     newtio.c_lflag &= ~ICANON; /* unset canonical */
-    newtio.c_cc[VTIME] = 1; /* 100 millis */
+    // Non-blocking, poll() does the waiting
+    newtio.c_cc[VMIN] = 0;
+    newtio.c_cc[VTIME] = 0;
 
     tcflush(fd, TCIFLUSH);
     tcsetattr(fd, TCSANOW, &newtio);
 
-    CreateListener();
-    CreateWriter();
+    ioThread = std::thread{[this]() { IOLoop(); }};
+}
 
-    devThread = std::thread{[this]() {
-        struct stat info;
-        while (SerialMonitor::instance != nullptr) {
-            if (stat(static_cast<MainMenu*>(GetParent())->boardSelect->entry()->GetStringSelection().data(), &info) != 0) { // Check if device is still present
-                SerialDataEvent* event = new SerialDataEvent(EVT_DISCON, wxID_ANY, "");
-                wxQueueEvent(SerialMonitor::instance, event);
-                break;
-            }
+void SerialMonitor::SendCommand(const std::string& command) {
+    {
+        std::lock_guard<std::mutex> guard(sendLock);
+        sendQueue.push_back("\r\n" + command + "\r\n");
+        capture.record(SerialLog::Direction::SENT, sendQueue.back());
+    }
+    Wake();
+}
 
-            std::this_thread::sleep_for(50ms);
-        }
-    }};
+void SerialMonitor::QueueInput(const char* data, size_t length) {
+    parser.feed(data, length);
+    {
+        std::lock_guard<std::mutex> guard(inputLock);
+        incoming.append(data, length);
+        if (incoming.size() > MAX_INCOMING) incoming.erase(0, incoming.size() - MAX_INCOMING);
+    }
+    // One event until the UI catches up, it takes everything that's arrived by then
+    if (!refreshQueued.exchange(true)) wxQueueEvent(GetEventHandler(), new SerialDataEvent(EVT_INPUT, wxID_ANY, ""));
 }
 
-void SerialMonitor::CreateListener() {
-    listenThread = std::thread{[this]() {
-        int32_t res;
-        char buf[255];
+void SerialMonitor::UpdateStatus(const SerialParser::Record& record) {
+    if (auto battery = std::get_if<SerialParser::Battery>(&record)) {
+        SetStatusText(wxString::Format("Battery: %.2fV", battery->voltage), 0);
+    } else if (auto volume = std::get_if<SerialParser::Volume>(&record)) {
+        SetStatusText(wxString::Format("Volume: %d", volume->volume), 1);
+    } else if (auto preset = std::get_if<SerialParser::CurrentPreset>(&record)) {
+        SetStatusText(wxString::Format("Preset: %d", preset->index), 2);
+    }
+}
 
-        while (instance != nullptr) {
-            res = read(fd, buf, 255);
+void SerialMonitor::PushPresets(const std::vector<ConfigModel::Preset>& presets) {
+    if (fd < 0) return;
 
-            buf[res] = '\0';
-            if (res != 0) {
-                SerialDataEvent *event = new SerialDataEvent(EVT_INPUT, wxID_ANY, buf);
-                wxQueueEvent(GetEventHandler(), event);
-            }
+    pendingPush = presets;
+    SendCommand("get_preset");
+    SendCommand("list_presets");
+}
+
+void SerialMonitor::FinishPush(const SerialParser::PresetList& boardPresets) {
+    auto plan = PresetSync::diff(*pendingPush, boardPresets, boardPreset);
+    pendingPush.reset();
+
+    if (!plan.blocker.empty()) {
+        wxMessageDialog(this, plan.blocker + "\n\nUse \"Apply Selected Configuration to Board\" instead.", "Can't Push Presets", wxICON_WARNING | wxOK).ShowModal();
+        return;
+    }
+
+    for (const auto& command : plan.commands) SendCommand(command);
+    wxMessageDialog(
+        this,
+        plan.changedPresets == 0 ?
+          wxString("Board presets already match.") :
+          wxString::Format("Updated %d preset(s) on the board.", plan.changedPresets),
+        "Presets Pushed",
+        wxOK
+        ).ShowModal();
+}
 
-            std::this_thread::sleep_for(50ms);
+void SerialMonitor::ToggleCapture() {
+    if (capture.isOpen()) {
+        capture.close();
+        captureButton->SetLabel("Start Capture...");
+        return;
+    }
+
+    wxFileDialog dialog(this, "Save Serial Capture", "", "serial.pslog", "Serial Log (*.pslog)|*.pslog", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (dialog.ShowModal() != wxID_OK) return;
+
+    if (!capture.open(dialog.GetPath().ToStdString())) {
+        wxMessageDialog(this, "Could not open \"" + dialog.GetPath() + "\" for writing.", "Capture Error", wxICON_ERROR | wxOK).ShowModal();
+        return;
+    }
+    captureButton->SetLabel("Stop Capture");
+}
+
+void SerialMonitor::StartReplay(const std::string& path) {
+    std::vector<SerialLog::Entry> entries;
+    std::string error;
+    if (!SerialLog::read(path, entries, error)) {
+        wxMessageDialog(GetParent(), "Could not replay serial log.\n\n" + error, "Replay Error", wxICON_ERROR | wxOK).ShowModal();
+        SerialMonitor::instance->Close(true);
+        return;
+    }
+
+    replayThread = std::thread{[this, entries{std::move(entries)}]() {
+        uint64_t lastTime{0};
+        for (const auto& entry : entries) {
+            std::unique_lock<std::mutex> guard(sendLock);
+            auto currentSpeed{speed.load()};
+            auto delay{entry.time > lastTime && currentSpeed ? (entry.time - lastTime) / currentSpeed : 0};
+            if (replayWake.wait_for(guard, std::chrono::milliseconds(delay), [this]() { return stopping; })) return;
+            guard.unlock();
+
+            lastTime = entry.time;
+            // Only what came from the board shows up in the monitor
+            if (entry.direction == SerialLog::Direction::RECEIVED) QueueInput(entry.data.data(), entry.data.size());
+            else parser.commandSent(entry.data);
         }
     }};
 }
 
-void SerialMonitor::CreateWriter() {
-    writerThread = std::thread{[&]() {
-        while (instance != nullptr) {
-            if (!sendOut.empty()) {
+void SerialMonitor::FlushInput() {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> guard(inputLock);
+        text.swap(incoming);
+        refreshQueued = false;
+    }
+    lastRefresh = std::chrono::steady_clock::now();
+    output->append(text);
+}
 
-                sendOut.resize(255);
-                sendOut.at(253) = '\r';
-                sendOut.at(254) = '\n';
+void SerialMonitor::Wake() {
+    if (wakeWrite < 0) return;
 
-                write(fd, "\r\n", 2);
-                write(fd, sendOut.data(), 255);
+    uint64_t one{1};
+    // Only fails if already signaled, which is just as good
+    auto res = write(wakeWrite, &one, sizeof(one));
+    (void)res;
+}
+
+void SerialMonitor::IOLoop() {
+    pollfd fds[2]{};
+    fds[0].fd = fd;
+    fds[1].fd = wakeRead;
+    fds[1].events = POLLIN;
+
+    std::string pending;
+    char buf[4096];
+
+    auto disconnect = [this]() {
+        wxQueueEvent(GetEventHandler(), new SerialDataEvent(EVT_DISCON, wxID_ANY, ""));
+    };
+
+    while (true) {
+        fds[0].events = POLLIN | (pending.empty() ? 0 : POLLOUT);
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            disconnect();
+            return;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            while (read(wakeRead, &count, sizeof(count)) > 0);
+
+            std::lock_guard<std::mutex> guard(sendLock);
+            if (stopping) return;
+            for (const auto& command : sendQueue) {
+                parser.commandSent(command);
+                pending += command;
             }
-            sendOut.clear();
-            std::this_thread::sleep_for(50ms);
+            sendQueue.clear();
         }
-    }};
+
+        if (fds[0].revents & POLLIN) {
+            auto res = read(fd, buf, sizeof(buf) - 1);
+            if (res > 0) {
+                capture.record(SerialLog::Direction::RECEIVED, std::string(buf, res));
+                QueueInput(buf, res);
+            } else if (res == 0 || (errno != EAGAIN && errno != EINTR)) {
+                // Device went away
+                disconnect();
+                return;
+            }
+        }
+
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            disconnect();
+            return;
+        }
+
+        if (fds[0].revents & POLLOUT) {
+            auto res = write(fd, pending.data(), pending.size());
+            if (res > 0) pending.erase(0, res);
+            else if (res < 0 && errno != EAGAIN && errno != EINTR) {
+                disconnect();
+                return;
+            }
+        }
+    }
 }
 #endif
@@ -3,47 +3,105 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <thread>
-#include <semaphore>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #if !defined(__WINDOWS__)
+#include "tools/seriallog.h"
+#include "tools/serialparser.h"
+#include "core/config/configmodel.h"
+#include "ui/pcchoice.h"
 #include "ui/pctextctrl.h"
+#include "ui/pclogview.h"
+#include <wx/button.h>
+#include <wx/timer.h>
 #endif
 
 #include "mainmenu/mainmenu.h"
 
 class SerialMonitor : public wxFrame {
 public:
-  SerialMonitor(MainMenu*);
+  // With replayLog, plays back a SerialLog capture instead of connecting to the board.
+  SerialMonitor(MainMenu*, const std::string& replayLog = {});
   static SerialMonitor* instance;
 
 #if !defined(__WINDOWS__)
   ~SerialMonitor();
 
+  // Posted to the monitor for everything SerialParser recognizes, bind to this to follow board state.
+  class RecordEvent;
+  static wxEventTypeTag<wxCommandEvent> EVT_RECORD;
+
+  // Changes the board's preset fonts/tracks/names to match over serial, see PresetSync.
+  void PushPresets(const std::vector<ConfigModel::Preset>&);
+  [[nodiscard]] bool isReplay() const { return replaySpeed != nullptr; }
+  [[nodiscard]] bool isConnected() const { return fd >= 0; }
+
 private:
   class SerialDataEvent;
   static wxEventTypeTag<wxCommandEvent> EVT_INPUT;
   static wxEventTypeTag<wxCommandEvent> EVT_DISCON;
 
   enum {
-      ID_SerialCommand
+      ID_SerialCommand,
+      ID_Capture,
+      ID_ReplaySpeed,
   };
 
-  std::thread devThread;
-  std::thread listenThread;
-  std::thread writerThread;
+  // Does all reading, writing, and disconnect detection, sleeping in poll() in between
+  std::thread ioThread;
+
+  pcTextCtrl* input{nullptr};
+  wxButton* captureButton{nullptr};
+  pcChoice* replaySpeed{nullptr};
+  pcLogView* output;
+
+  SerialLog::Writer capture;
+  // Only used from ioThread (or replayThread)
+  SerialParser::Parser parser;
+
+  // Waiting on list_presets to push these
+  std::optional<std::vector<ConfigModel::Preset>> pendingPush;
+  int32_t boardPreset{0};
+  std::thread replayThread;
+  // Signaled (with sendLock) on shutdown
+  std::condition_variable replayWake;
+  // Multiplier, 0 for as fast as possible
+  std::atomic<int32_t> speed{1};
 
-  pcTextCtrl* input;
-  pcTextCtrl* output;
+  int32_t fd = -1;
+  // eventfd (pipe on macOS) to wake ioThread for outgoing commands or shutdown
+  int32_t wakeRead = -1;
+  int32_t wakeWrite = -1;
 
-  int32_t fd = 0;
-  wxString sendOut;
+  std::mutex sendLock;
+  std::vector<std::string> sendQueue;
+  bool stopping = false;
 
+  // Filled by ioThread, moved into output at most REFRESH_RATE times a second
+  std::mutex inputLock;
+  std::string incoming;
+  std::atomic<bool> refreshQueued{false};
+  wxTimer refreshTimer;
+  std::chrono::steady_clock::time_point lastRefresh{};
 
   void BindEvents();
   void OpenDevice();
-  void CreateListener();
-  void CreateWriter();
+  void SendCommand(const std::string&);
+  void QueueInput(const char* data, size_t length);
+  void FlushInput();
+  void ToggleCapture();
+  void UpdateStatus(const SerialParser::Record&);
+  void FinishPush(const SerialParser::PresetList&);
+  void StartReplay(const std::string& path);
+  void Wake();
+  void IOLoop();
 #endif // OSX or GTK
 };
 
@@ -58,4 +116,14 @@ public:
 
   wxString value;
 };
+
+class SerialMonitor::RecordEvent : public wxCommandEvent {
+public:
+  RecordEvent(SerialParser::Record&& record) : record(std::move(record)) {
+    this->SetEventType(EVT_RECORD);
+    this->SetId(wxID_ANY);
+  }
+
+  SerialParser::Record record;
+};
 #endif
@@ -0,0 +1,158 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "tools/serialparser.h"
+
+#include <cstdlib>
+
+#define BEGIN_OUTPUT "-+=BEGIN_OUTPUT=+-"
+#define END_OUTPUT "-+=END_OUTPUT=+-"
+// Anything longer and we've probably missed an END_OUTPUT
+#define MAX_RESPONSE_LINES 10000
+
+namespace SerialParser {
+  std::string trim(const std::string&);
+  bool parseInt(const std::string&, int32_t&);
+  bool parseDouble(const std::string&, double&);
+  bool splitPair(const std::string& line, char separator, std::string& key, std::string& value);
+}
+
+void SerialParser::Parser::commandSent(const std::string& command) {
+  auto trimmed = trim(command);
+  if (!trimmed.empty()) sentCommands.push_back(trimmed);
+}
+
+void SerialParser::Parser::feed(const char* data, size_t length) {
+  for (size_t idx = 0; idx < length; idx++) {
+    if (data[idx] == '\n') {
+      parseLine(std::move(partialLine));
+      partialLine.clear();
+    } else if (data[idx] != '\r') partialLine += data[idx];
+  }
+}
+
+void SerialParser::Parser::reset() {
+  partialLine.clear();
+  sentCommands.clear();
+  inResponse = false;
+  response = {};
+}
+
+void SerialParser::Parser::parseLine(std::string line) {
+  if (line == BEGIN_OUTPUT) {
+    // Previous one never ended, salvage what we have
+    if (inResponse) finishResponse();
+
+    inResponse = true;
+    response = {};
+    if (!sentCommands.empty()) {
+      response.command = std::move(sentCommands.front());
+      sentCommands.pop_front();
+    }
+    return;
+  }
+  if (line == END_OUTPUT) {
+    if (inResponse) finishResponse();
+    return;
+  }
+
+  if (inResponse) {
+    response.lines.push_back(std::move(line));
+    if (response.lines.size() >= MAX_RESPONSE_LINES) finishResponse();
+    return;
+  }
+
+  std::string name, value;
+  if (!splitPair(line, ':', name, value) || name.empty()) return;
+
+  if (name == "Battery voltage") {
+    Battery battery;
+    if (parseDouble(value, battery.voltage)) onRecord(battery);
+  }
+  onRecord(MonitorValue{ name, value });
+}
+
+void SerialParser::Parser::finishResponse() {
+  inResponse = false;
+
+  auto command = response.command.substr(0, response.command.find(' '));
+  const auto& lines{response.lines};
+  if (!lines.empty()) {
+    if (command == "get_volume") {
+      Volume volume;
+      if (parseInt(lines.front(), volume.volume)) onRecord(volume);
+    } else if (command == "battery_voltage") {
+      Battery battery;
+      if (parseDouble(lines.front(), battery.voltage)) onRecord(battery);
+    } else if (command == "get_preset") {
+      CurrentPreset preset;
+      if (parseInt(lines.front(), preset.index)) onRecord(preset);
+    } else if (command == "list_presets") {
+      PresetList presets;
+      if (parsePresetList(lines, presets)) onRecord(std::move(presets));
+    } else if (command == "sd_card_info") {
+      SDCardInfo info;
+      for (const auto& line : lines) {
+        std::string key, value;
+        if (splitPair(line, ':', key, value) || splitPair(line, '=', key, value)) info.fields[key] = value;
+      }
+      onRecord(std::move(info));
+    }
+  }
+
+  onRecord(std::move(response));
+  response = {};
+}
+
+bool SerialParser::parsePresetList(const std::vector<std::string>& lines, PresetList& list) {
+  list.presets.clear();
+  for (const auto& line : lines) {
+    std::string key, value;
+    if (!splitPair(line, '=', key, value)) continue;
+
+    // Each preset starts with its font
+    if (key == "FONT" || list.presets.empty()) list.presets.emplace_back();
+    auto& preset{list.presets.back()};
+
+    if (key == "FONT") preset.font = value;
+    else if (key == "TRACK") preset.track = value;
+    else if (key == "NAME") preset.name = value;
+    else if (key == "VARIATION") parseInt(value, preset.variation);
+    else if (key.rfind("STYLE", 0) == 0) preset.styles.push_back(value);
+  }
+
+  return !list.presets.empty();
+}
+
+std::string SerialParser::trim(const std::string& str) {
+  auto begin = str.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos) return {};
+  auto end = str.find_last_not_of(" \t\r\n");
+  return str.substr(begin, end - begin + 1);
+}
+
+bool SerialParser::parseInt(const std::string& str, int32_t& value) {
+  auto trimmed = trim(str);
+  char* end{nullptr};
+  auto parsed = std::strtol(trimmed.c_str(), &end, 10);
+  if (trimmed.empty() || *end != '\0') return false;
+  value = static_cast<int32_t>(parsed);
+  return true;
+}
+
+bool SerialParser::parseDouble(const std::string& str, double& value) {
+  auto trimmed = trim(str);
+  char* end{nullptr};
+  auto parsed = std::strtod(trimmed.c_str(), &end);
+  if (trimmed.empty() || *end != '\0') return false;
+  value = parsed;
+  return true;
+}
+
+bool SerialParser::splitPair(const std::string& line, char separator, std::string& key, std::string& value) {
+  auto pos = line.find(separator);
+  if (pos == std::string::npos) return false;
+  key = trim(line.substr(0, pos));
+  value = trim(line.substr(pos + 1));
+  return true;
+}
@@ -0,0 +1,80 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Turns ProffieOS serial output into typed records.
+//
+// ProffieOS wraps each command's output in BEGIN_OUTPUT/END_OUTPUT marker
+// lines, responses are matched to commands in the order they were sent.
+// Anything outside of a response (e.g. from `mon`) that looks like
+// "Name: value" comes out as a MonitorValue.
+//
+// Not thread-safe, commandSent() and feed() should be called from the same
+// thread, in the order things actually went over the wire.
+namespace SerialParser {
+  // Every command's output, whether or not it's understood
+  struct Response {
+    std::string command{};
+    std::vector<std::string> lines{};
+  };
+  struct Volume {
+    int32_t volume{0};
+  };
+  struct Battery {
+    double voltage{0};
+  };
+  struct CurrentPreset {
+    int32_t index{0};
+  };
+  struct Preset {
+    std::string name{};
+    std::string font{};
+    std::string track{};
+    std::vector<std::string> styles{};
+    int32_t variation{0};
+  };
+  struct PresetList {
+    std::vector<Preset> presets{};
+  };
+  struct SDCardInfo {
+    std::unordered_map<std::string, std::string> fields{};
+  };
+  struct MonitorValue {
+    std::string name{};
+    std::string value{};
+  };
+
+  typedef std::variant<Response, Volume, Battery, CurrentPreset, PresetList, SDCardInfo, MonitorValue> Record;
+
+  class Parser {
+  public:
+    Parser(std::function<void(Record&&)> onRecord) : onRecord(std::move(onRecord)) {}
+
+    void commandSent(const std::string& command);
+    void feed(const char* data, size_t length);
+    void reset();
+
+  private:
+    void parseLine(std::string line);
+    void finishResponse();
+
+    std::function<void(Record&&)> onRecord;
+
+    std::string partialLine{};
+    std::deque<std::string> sentCommands{};
+    bool inResponse{false};
+    Response response{};
+  };
+
+  // Split out for use on Response::lines without a Parser.
+  bool parsePresetList(const std::vector<std::string>& lines, PresetList&);
+} // namespace SerialParser
@@ -0,0 +1,72 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#include "ui/pclogview.h"
+
+// Output without newlines still has to scroll out eventually
+#define MAX_LINE_LENGTH 4096
+
+namespace {
+  // Serial output isn't always valid UTF-8, fall back to showing it byte-for-byte
+  wxString convert(const char* data, size_t length) {
+    auto ret = wxString::FromUTF8(data, length);
+    if (ret.empty() && length) ret = wxString::From8BitData(data, length);
+    return ret;
+  }
+}
+
+pcLogView::pcLogView(wxWindow* parent, int32_t id, const wxPoint& pos, const wxSize& size, size_t maxLines) :
+  wxListCtrl(parent, id, pos, size, wxLC_REPORT | wxLC_VIRTUAL | wxLC_NO_HEADER | wxLC_SINGLE_SEL),
+  lines(maxLines) {
+  AppendColumn(wxEmptyString);
+  Bind(wxEVT_SIZE, [&](wxSizeEvent& evt) {
+      SetColumnWidth(0, GetClientSize().x);
+      evt.Skip();
+    });
+}
+
+void pcLogView::append(const std::string& text) {
+  if (text.empty()) return;
+
+  auto oldCount = lineCount();
+  bool atBottom = oldCount == 0 || GetTopItem() + GetCountPerPage() >= static_cast<long>(oldCount) - 1;
+
+  size_t lineStart{0};
+  for (size_t idx = 0; idx < text.size(); idx++) {
+    if (text[idx] != '\n') continue;
+
+    partialLine.append(text, lineStart, idx - lineStart);
+    if (!partialLine.empty() && partialLine.back() == '\r') partialLine.pop_back();
+    lines.push(convert(partialLine.data(), partialLine.size()));
+    partialLine.clear();
+    lineStart = idx + 1;
+  }
+  partialLine.append(text, lineStart, std::string::npos);
+  while (partialLine.size() > MAX_LINE_LENGTH) {
+    lines.push(convert(partialLine.data(), MAX_LINE_LENGTH));
+    partialLine.erase(0, MAX_LINE_LENGTH);
+  }
+
+  updateCount();
+  if (atBottom && lineCount()) EnsureVisible(lineCount() - 1);
+}
+
+void pcLogView::clear() {
+  lines.clear();
+  partialLine.clear();
+  updateCount();
+}
+
+wxString pcLogView::OnGetItemText(long item, long) const {
+  if (item < 0) return wxEmptyString;
+  if (static_cast<size_t>(item) < lines.size()) return lines[item];
+  return convert(partialLine.data(), partialLine.size());
+}
+
+size_t pcLogView::lineCount() const { return lines.size() + (partialLine.empty() ? 0 : 1); }
+
+void pcLogView::updateCount() {
+  SetItemCount(lineCount());
+  // Once full, existing rows shift every time, so everything visible is stale
+  Refresh();
+}
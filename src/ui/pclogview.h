@@ -0,0 +1,38 @@
+// ProffieConfig, All-In-One GUI Proffieboard Configuration Utility
+// Copyright (C) 2024 Ryan Ogurek
+
+#pragma once
+
+#include "core/utilities/ringbuffer.h"
+
+#include <string>
+#include <wx/listctrl.h>
+
+// Read-only, line-based log view. Only the most recent maxLines are kept,
+// and since it's a virtual list only the visible lines are ever rendered.
+class pcLogView : public wxListCtrl {
+public:
+  pcLogView(
+    wxWindow* parent,
+    int32_t id = wxID_ANY,
+    const wxPoint& pos = wxDefaultPosition,
+    const wxSize& size = wxDefaultSize,
+    size_t maxLines = 10000
+    );
+
+  // Splits text into lines, an unterminated last line is continued by the next append.
+  // Stays scrolled to the bottom if it already was.
+  void append(const std::string& text);
+  void clear();
+
+protected:
+  wxString OnGetItemText(long item, long column) const override;
+
+private:
+  RingBuffer<wxString> lines;
+  // Raw bytes, a multi-byte character could be split across appends
+  std::string partialLine{};
+
+  size_t lineCount() const;
+  void updateCount();
+};